@@ -0,0 +1,173 @@
+#include <void/evaluator.hpp>
+#include <void/lexer.hpp>
+#include <void/parser.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <sys/resource.h>
+
+// Lexer, parser and evaluator microbenchmarks and end to end runs of a
+// corpus of Monkey programs. Besides ns/op each reports heap allocations
+// per op and the peak RSS of the process so far; track them across
+// releases with --benchmark_format=json.
+
+using namespace Void;
+
+namespace {
+  std::uint64_t allocations = 0;
+
+  // allocs_per_op over the timed loop and the high water mark of RSS
+  class Report {
+  public:
+    explicit Report(benchmark::State& state)
+      : _state(state), _before(allocations) {}
+    Report(Report const&) = delete;
+    Report& operator=(Report const&) = delete;
+    ~Report() {
+      _state.counters["allocs_per_op"] =
+	benchmark::Counter(static_cast<double>(allocations - _before), benchmark::Counter::kAvgIterations);
+      rusage usage{};
+      getrusage(RUSAGE_SELF, &usage);
+      _state.counters["peak_rss_kb"] = static_cast<double>(usage.ru_maxrss);
+    }
+
+  private:
+    benchmark::State& _state;
+    std::uint64_t _before;
+  };
+
+  constexpr char const* fib = R"(
+    let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) };
+    fib(18);
+  )";
+
+  constexpr char const* closures = R"(
+    let adder = fn(x) { fn(y) { x + y } };
+    let run = fn(n, acc) { if (n == 0) { acc } else { run(n - 1, adder(n)(acc)) } };
+    run(500, 0);
+  )";
+
+  constexpr char const* array_push = R"(
+    let build = fn(arr, n) { if (n == 0) { arr } else { build(push(arr, n), n - 1) } };
+    len(build([], 1000));
+  )";
+
+  constexpr char const* string_concat = R"(
+    let cat = fn(s, n) { if (n == 0) { s } else { cat(s + "ab", n - 1) } };
+    len(cat("", 1000));
+  )";
+
+  constexpr char const* deep_recursion = R"(
+    let depth = fn(n) { if (n == 0) { 0 } else { 1 + depth(n - 1) } };
+    depth(1000);
+  )";
+
+  constexpr char const* nested_index = R"(
+    let grid = [[1, 2, 3], [4, 5, 6], [7, 8, 9]];
+    let mod3 = fn(n) { n - n / 3 * 3 };
+    let walk = fn(n, acc) {
+      if (n == 0) { acc } else { walk(n - 1, acc + grid[mod3(n)][mod3(n + 1)]) }
+    };
+    walk(1000, 0);
+  )";
+
+  // every kind of token and node, for the lexer and parser
+  constexpr char const* mixed = R"(
+    let data = {"name": "void", "tags": ["a", "b"], 1: true, false: 2};
+    let f = fn(x, y) { if (x <= y) { return x * 2 - y / 3; } else { !(x != y) } };
+    let g = fn(arr) { push(arr, len(arr))[0] >= -1 };
+    f(10, 20) + f(3, 4) == g([1, 2, 3]);
+  )";
+}
+
+// sanitizers pair allocations with their own operator new, leave it alone
+#if !defined(__SANITIZE_ADDRESS__)
+namespace {
+  // out of line, or inlining pairs std::free with operator new and warns
+  [[gnu::noinline]] void* counted_malloc(std::size_t size) {
+    ++allocations;
+    return std::malloc(size ? size : 1);
+  }
+
+  [[gnu::noinline]] void counted_free(void* ptr) {
+    std::free(ptr);
+  }
+}
+
+void* operator new(std::size_t size) {
+  if (auto ptr = counted_malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  counted_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  counted_free(ptr);
+}
+#endif
+
+static void BM_Lex(benchmark::State& state) {
+  std::string source = mixed;
+  Report report(state);
+  for (auto _ : state) {
+    Lexer lexer(source);
+    std::size_t tokens = 0;
+    while (lexer.read_token().type != Token::eof_t) {
+      ++tokens;
+    }
+    benchmark::DoNotOptimize(tokens);
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_Lex);
+
+static void BM_Parse(benchmark::State& state) {
+  std::string source = mixed;
+  Report report(state);
+  for (auto _ : state) {
+    Parser parser(source);
+    benchmark::DoNotOptimize(parser.parse());
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_Parse);
+
+// a compiled script, evaluation alone
+static void BM_Eval(benchmark::State& state) {
+  Evaluator evaluator;
+  evaluator.eval("let f = fn(x, y) { if (x < y) { x * 2 - y } else { y } };");
+  auto script = evaluator.compile("f(10, 20) + f(3, 4) * f(7, 1)");
+  Report report(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(script.run());
+  }
+}
+BENCHMARK(BM_Eval);
+
+// a fresh evaluator per op: lexing, parsing and evaluating the program
+static void BM_Corpus(benchmark::State& state, char const* source) {
+  std::string program = source;
+  Report report(state);
+  for (auto _ : state) {
+    Evaluator evaluator;
+    auto res = evaluator.eval(program);
+    if (res->type() == Object::error_object_t) {
+      state.SkipWithError(res->inspect().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(res);
+  }
+}
+BENCHMARK_CAPTURE(BM_Corpus, fib, fib)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Corpus, closures, closures)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Corpus, array_push, array_push)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Corpus, string_concat, string_concat)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Corpus, deep_recursion, deep_recursion)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Corpus, nested_index, nested_index)->Unit(benchmark::kMicrosecond);
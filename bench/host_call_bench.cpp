@@ -0,0 +1,73 @@
+#include <void/evaluator.hpp>
+#include <void/builtin.hpp>
+#include <void/host.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+using namespace Void;
+
+namespace {
+  std::int64_t score(std::int64_t base, std::string_view tag) {
+    return base + static_cast<std::int64_t>(tag.size());
+  }
+
+  std::shared_ptr<Object> score_by_hand(std::shared_ptr<Object> const& base, std::shared_ptr<Object> const& tag) {
+    if (base->type() != Object::integer_object_t || tag->type() != Object::string_object_t) {
+      return std::make_shared<Error>();
+    }
+    return Integer::make(base->cast<Integer>()->value() + static_cast<std::int64_t>(tag->cast<String>()->size()));
+  }
+
+  std::string repeat_calls(std::string const& call, int count) {
+    std::string res;
+    for (int i = 0; i < count; ++i) {
+      res += call + ";";
+    }
+    return res;
+  }
+}
+
+// cost of the generated marshalling compared to a hand written builtin
+static void BM_HostCall(benchmark::State& state) {
+  auto fn = host::bind("score", &score);
+  std::shared_ptr<Object> args[] = {Integer::make(40), String::intern("ab")};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fn->run(Args(args, 2)));
+  }
+}
+BENCHMARK(BM_HostCall);
+
+static void BM_BuiltinCall(benchmark::State& state) {
+  auto fn = std::make_shared<Builtin>(&score_by_hand, "score");
+  std::shared_ptr<Object> args[] = {Integer::make(40), String::intern("ab")};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fn->run(Args(args, 2)));
+  }
+}
+BENCHMARK(BM_BuiltinCall);
+
+// whole calls from a script, parsing included and amortized over 1000 calls
+static void BM_EvalHostCall(benchmark::State& state) {
+  Evaluator evaluator;
+  evaluator.def("score", &score);
+  auto source = repeat_calls(R"(score(40, "ab"))", 1000);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluator.eval(source));
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_EvalHostCall);
+
+static void BM_EvalBuiltinCall(benchmark::State& state) {
+  Evaluator evaluator;
+  evaluator.eval("let a = [1, 2, 3]");
+  auto source = repeat_calls("len(a)", 1000);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluator.eval(source));
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_EvalBuiltinCall);
@@ -0,0 +1,51 @@
+#include <void/evaluator.hpp>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+using namespace Void;
+
+namespace {
+  constexpr char const* source = "let add = fn(x, y) { x + y }";
+}
+
+// host to script latency: a resolved Callable against the ways a host
+// could reach the same function without one
+static void BM_CallableCall(benchmark::State& state) {
+  Evaluator evaluator;
+  evaluator.eval(source);
+  auto add = evaluator.lookup_function("add");
+  std::int64_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(add.call(i++, 1));
+  }
+}
+BENCHMARK(BM_CallableCall);
+
+static void BM_LookupAndCall(benchmark::State& state) {
+  Evaluator evaluator;
+  evaluator.eval(source);
+  std::int64_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluator.lookup_function("add").call(i++, 1));
+  }
+}
+BENCHMARK(BM_LookupAndCall);
+
+static void BM_ScriptRun(benchmark::State& state) {
+  Evaluator evaluator;
+  evaluator.eval(source);
+  auto script = evaluator.compile("add(40, 2)");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(script.run());
+  }
+}
+BENCHMARK(BM_ScriptRun);
+
+static void BM_EvalCall(benchmark::State& state) {
+  Evaluator evaluator;
+  evaluator.eval(source);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluator.eval("add(40, 2)"));
+  }
+}
+BENCHMARK(BM_EvalCall);
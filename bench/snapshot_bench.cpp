@@ -0,0 +1,40 @@
+#include <void/evaluator.hpp>
+#include <benchmark/benchmark.h>
+#include <string>
+
+using namespace Void;
+
+namespace {
+  // n helper functions and n constant tables computed at load time
+  std::string prelude(int n) {
+    std::string res = "let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) };";
+    for (int i = 0; i < n; ++i) {
+      auto id = std::to_string(i);
+      res += "let f" + id + " = fn(x) { x * " + id + " + fib(10) };";
+      res += "let t" + id + " = [fib(12), " + id + ", \"entry " + id + "\"];";
+    }
+    return res;
+  }
+}
+
+// startup by evaluating the prelude against restoring a snapshot of it
+static void BM_RunPrelude(benchmark::State& state) {
+  auto source = prelude(state.range(0));
+  for (auto _ : state) {
+    Evaluator evaluator;
+    benchmark::DoNotOptimize(evaluator.eval(source));
+  }
+}
+BENCHMARK(BM_RunPrelude)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
+
+static void BM_RestoreSnapshot(benchmark::State& state) {
+  Evaluator source;
+  source.eval(prelude(state.range(0)));
+  auto image = source.snapshot();
+  for (auto _ : state) {
+    Evaluator evaluator;
+    benchmark::DoNotOptimize(evaluator.restore(image));
+  }
+  state.counters["image_bytes"] = image.size();
+}
+BENCHMARK(BM_RestoreSnapshot)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
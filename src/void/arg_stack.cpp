@@ -0,0 +1,50 @@
+#include <void/arg_stack.hpp>
+#include <void/object.hpp>
+
+#include <algorithm>
+
+namespace Void {
+  ArgStack::Slot* ArgStack::push_frame(std::size_t size) {
+    if (size == 0) {
+      return nullptr;
+    }
+
+    if (!_blocks.empty()) {
+      auto& block = _blocks[_current];
+      if (block.top + size <= block.capacity) {
+	auto res = block.slots.get() + block.top;
+	block.top += size;
+	return res;
+      }
+      // a frame never straddles two blocks, start the next one
+      ++_current;
+    }
+
+    if (_current == _blocks.size() || _blocks[_current].capacity < size) {
+      auto capacity = std::max(block_size, size);
+      Block block{std::make_unique<Slot[]>(capacity), capacity, 0};
+      if (_current == _blocks.size()) {
+	_blocks.push_back(std::move(block));
+      } else {
+	_blocks[_current] = std::move(block);
+      }
+    }
+
+    auto& block = _blocks[_current];
+    block.top = size;
+    return block.slots.get();
+  }
+
+  void ArgStack::pop_frame(std::size_t size) {
+    if (size == 0) {
+      return;
+    }
+
+    auto& block = _blocks[_current];
+    block.top -= size;
+    std::fill(block.slots.get() + block.top, block.slots.get() + block.top + size, nullptr);
+    if (block.top == 0 && _current != 0) {
+      --_current;
+    }
+  }
+}
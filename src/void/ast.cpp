@@ -1,13 +1,74 @@
+#include <algorithm>
+#include <charconv>
 #include <cstdlib>
 #include <exception>
 #include <malloc.h>
 #include <vector>
 #include <void/ast.hpp>
 #include <void/token.hpp>
+#include <void/heap_profiler.hpp>
+#include <atomic>
 #include <cstdio>
+#include <functional>
 #include <memory>
+#include <utility>
 
 namespace Void {
+  // AstNode
+  namespace {
+    std::atomic<std::size_t> live_nodes{0};
+    std::atomic<std::size_t> live_bytes{0};
+    thread_local std::size_t thread_nodes = 0;
+  }
+
+  void* AstNode::operator new(std::size_t size) {
+    live_nodes.fetch_add(1, std::memory_order_relaxed);
+    live_bytes.fetch_add(size, std::memory_order_relaxed);
+    ++thread_nodes;
+    return ::operator new(size);
+  }
+
+  void AstNode::operator delete(void* ptr, std::size_t size) {
+    live_nodes.fetch_sub(1, std::memory_order_relaxed);
+    live_bytes.fetch_sub(size, std::memory_order_relaxed);
+    // the address may be reused by a node of another program
+    if (heap_profiler::active()) {
+      heap_profiler::forget(static_cast<AstNode*>(ptr));
+    }
+    ::operator delete(ptr);
+  }
+
+  AstStats AstNode::stats() {
+    return {live_nodes.load(std::memory_order_relaxed), live_bytes.load(std::memory_order_relaxed)};
+  }
+
+  std::size_t AstNode::made_on_thread() {
+    return thread_nodes;
+  }
+
+  char const* to_string(NodeKind kind) {
+    static char const* const names[] = {
+      "program",
+      "identifier",
+      "let_statement",
+      "return_statement",
+      "expression_statement",
+      "block_statement",
+      "integer_literal",
+      "boolean_literal",
+      "string_literal",
+      "array_literal",
+      "hash_literal",
+      "function_literal",
+      "if_expression",
+      "call_expression",
+      "index_expression",
+      "prefix_expression",
+      "infix_expression",
+    };
+    return names[static_cast<std::size_t>(kind)];
+  }
+
   // Statement
   Statement::Statement(Token token)
     : _token(token) {}
@@ -16,6 +77,10 @@ namespace Void {
     return _token.literal;
   }
 
+  int Statement::line() const {
+    return _token.line;
+  }
+
   // Expression
   Expression::Expression(Token token)
     : _token(token) {}
@@ -24,7 +89,15 @@ namespace Void {
     return _token.literal;
   }
 
+  int Expression::line() const {
+    return _token.line;
+  }
+
   // Program
+  NodeKind Program::kind() const {
+    return NodeKind::program;
+  }
+
   std::string Program::to_string() const {
     std::string res;
     for (auto& stmt : _statements) {
@@ -45,23 +118,67 @@ namespace Void {
     return _statements;
   }
 
+  std::string const& Program::source() const {
+    return _source;
+  }
+
+  void Program::set_source(std::string source) {
+    _source = std::move(source);
+  }
+
+  std::vector<FunctionLiteral*> const& Program::functions() const {
+    return _functions;
+  }
+
+  void Program::set_functions(std::vector<FunctionLiteral*> functions) {
+    _functions = std::move(functions);
+  }
+
   void Program::append(std::unique_ptr<Statement> stmt) {
     _statements.emplace_back(std::move(stmt)); 
   }
 
   // Identifier
+  std::uint64_t name_bit(std::string const& name) {
+    return std::uint64_t{1} << (std::hash<std::string>{}(name) & 63);
+  }
+
   Identifier::Identifier(Token token)
-    : Expression(token), _value(token.literal) {}
+    : Expression(token), _value(token.literal), _bit(name_bit(_value)) {}
+
+  NodeKind Identifier::kind() const {
+    return NodeKind::identifier;
+  }
 
   std::string Identifier::to_string() const {
     return _value; 
   }
 
-  std::string Identifier::value() const {
+  std::string const& Identifier::value() const {
     return _value;
   }
 
+  std::uint64_t Identifier::bit() const {
+    return _bit;
+  }
+
+  SlotCache& Identifier::slot_cache() {
+    return _slot_cache;
+  }
+
+  Quick Identifier::quick() const {
+    return _quick;
+  }
+
+  void Identifier::set_quick(Quick quick) {
+    _quick = quick;
+  }
+
   // LetStatement
+  NodeKind LetStatement::kind() const {
+    return NodeKind::let_statement;
+  }
+
   std::string LetStatement::to_string() const {
     return "let " + _identifier->to_string() + " = " + _expression->to_string(); 
   }
@@ -83,6 +200,10 @@ namespace Void {
   }
 
   // ReturnStatment
+  NodeKind ReturnStatement::kind() const {
+    return NodeKind::return_statement;
+  }
+
   std::string ReturnStatement::to_string() const {
     return "return " + _expression->to_string(); 
   }
@@ -96,6 +217,10 @@ namespace Void {
   }
 
   // ExpressionStatement
+  NodeKind ExpressionStatement::kind() const {
+    return NodeKind::expression_statement;
+  }
+
   std::string ExpressionStatement::to_string() const {
     return (_expression == nullptr ? "" : _expression->to_string()); 
   }
@@ -109,6 +234,10 @@ namespace Void {
   }
 
   // BlockStatement
+  NodeKind BlockStatement::kind() const {
+    return NodeKind::block_statement;
+  }
+
   std::string BlockStatement::to_string() const {
     std::string res;
     for (auto& stmt : _statements) {
@@ -132,20 +261,44 @@ namespace Void {
 
   // IntegerLiteral
   IntegerLiteral::IntegerLiteral(Token token)
-    : Expression(token), _value(std::stoi(token.literal)) {}
+    : Expression(token) {
+    auto& lit = _token.literal;
+    auto [ptr, ec] = std::from_chars(lit.data(), lit.data() + lit.size(), _value);
+    _big = ec == std::errc::result_out_of_range;
+  }
  
+  NodeKind IntegerLiteral::kind() const {
+    return NodeKind::integer_literal;
+  }
+
   std::string IntegerLiteral::to_string() const {
-    return std::to_string(_value);
+    return _big ? _token.literal : std::to_string(_value);
   }
 
-  int IntegerLiteral::value() const {
+  std::int64_t IntegerLiteral::value() const {
     return _value;
   }
 
+  bool IntegerLiteral::is_big() const {
+    return _big;
+  }
+
+  std::shared_ptr<Object> const& IntegerLiteral::object() const {
+    return _object;
+  }
+
+  void IntegerLiteral::set_object(std::shared_ptr<Object> obj) {
+    _object.swap(obj);
+  }
+
   // BooleanLiteral
   BooleanLiteral::BooleanLiteral(Token token)
     : Expression(token), _value(token.type == Token::true_t) {}
 
+  NodeKind BooleanLiteral::kind() const {
+    return NodeKind::boolean_literal;
+  }
+
   std::string BooleanLiteral::to_string() const {
     return _value ? "true" : "false";
   }
@@ -158,6 +311,10 @@ namespace Void {
   StringLiteral::StringLiteral(Token token)
     : Expression(token), _value(token.literal) {}
 
+  NodeKind StringLiteral::kind() const {
+    return NodeKind::string_literal;
+  }
+
   std::string StringLiteral::to_string() const {
     return "\"" + _value + "\"";
   }
@@ -166,7 +323,19 @@ namespace Void {
     return _value;
   }
 
+  std::shared_ptr<String> const& StringLiteral::object() const {
+    return _object;
+  }
+
+  void StringLiteral::set_object(std::shared_ptr<String> obj) {
+    _object.swap(obj);
+  }
+
   // ArrayLiteral
+  NodeKind ArrayLiteral::kind() const {
+    return NodeKind::array_literal;
+  }
+
   std::string ArrayLiteral::to_string() const {
     std::string res;
     bool first = false; 
@@ -188,7 +357,37 @@ namespace Void {
     _expressions.emplace_back(std::move(expr)); 
   }
 
+  // HashLiteral
+  NodeKind HashLiteral::kind() const {
+    return NodeKind::hash_literal;
+  }
+
+  std::string HashLiteral::to_string() const {
+    std::string res;
+    bool first = false;
+    for (auto& [key, value] : _pairs) {
+      if (first) {
+	res += ", ";
+      }
+      first = true;
+      res += key->to_string() + ": " + value->to_string();
+    }
+    return "{" + res + "}";
+  }
+
+  std::vector<HashLiteral::Pair> const& HashLiteral::pairs() const {
+    return _pairs;
+  }
+
+  void HashLiteral::append(std::unique_ptr<Expression> key, std::unique_ptr<Expression> value) {
+    _pairs.emplace_back(std::move(key), std::move(value));
+  }
+
   // FunctionLiteral
+  NodeKind FunctionLiteral::kind() const {
+    return NodeKind::function_literal;
+  }
+
   std::string FunctionLiteral::to_string() const {
     std::string para, body;
     bool first = false; 
@@ -214,7 +413,35 @@ namespace Void {
   }
 
   void FunctionLiteral::append_parameters(std::unique_ptr<Identifier> ident) {
+    auto index = static_cast<std::uint32_t>(_parameters.size());
+    auto& name = ident->value();
+    _parameter_names |= ident->bit();
     _parameters.emplace_back(std::move(ident)); 
+
+    // a later parameter of the same name wins, as it did binding one by one
+    auto by_name = [this](std::uint32_t i, std::string const& name) { return _parameters[i]->value() < name; };
+    auto it = std::lower_bound(_binding_order.begin(), _binding_order.end(), name, by_name);
+    if (it != _binding_order.end() && _parameters[*it]->value() == name) {
+      *it = index;
+    } else {
+      _binding_order.insert(it, index);
+    }
+  }
+
+  std::vector<std::uint32_t> const& FunctionLiteral::binding_order() const {
+    return _binding_order;
+  }
+
+  std::uint64_t FunctionLiteral::parameter_names() const {
+    return _parameter_names;
+  }
+
+  std::string const& FunctionLiteral::name() const {
+    return _name;
+  }
+
+  void FunctionLiteral::set_name(std::string name) {
+    _name = std::move(name);
   }
 
   void FunctionLiteral::set_body(std::unique_ptr<BlockStatement> stmt) {
@@ -222,6 +449,10 @@ namespace Void {
   }
 
   // IfExpression
+  NodeKind IfExpression::kind() const {
+    return NodeKind::if_expression;
+  }
+
   std::string IfExpression::to_string() const {
     std::string res, cond, cons, alt;
     cond = _condition->to_string();
@@ -262,7 +493,23 @@ namespace Void {
     _alternative.swap(stmt);
   }
 
+  IfFeedback& IfExpression::feedback() {
+    return _feedback;
+  }
+
+  Quick IfExpression::quick() const {
+    return _quick;
+  }
+
+  void IfExpression::set_quick(Quick quick) {
+    _quick = quick;
+  }
+
   // CallExpression
+  NodeKind CallExpression::kind() const {
+    return NodeKind::call_expression;
+  }
+
   std::string CallExpression::to_string() const {
     std::string arguments;
     bool first = false; 
@@ -292,7 +539,19 @@ namespace Void {
     _arguments.emplace_back(std::move(expr)); 
   }
 
+  CallFeedback& CallExpression::feedback() {
+    return _feedback;
+  }
+
+  CallCache& CallExpression::cache() {
+    return _cache;
+  }
+
   // IndexExpression
+  NodeKind IndexExpression::kind() const {
+    return NodeKind::index_expression;
+  }
+
   std::string IndexExpression::to_string() const {
     return _array->to_string() + "[" + _index->to_string() + "]";
   }
@@ -317,6 +576,10 @@ namespace Void {
   PrefixExpression::PrefixExpression(Token token)
     : Expression(token), _op(token.literal) {}
 
+  NodeKind PrefixExpression::kind() const {
+    return NodeKind::prefix_expression;
+  }
+
   std::string PrefixExpression::to_string() const {
     if (_right == nullptr) {
       return "()";
@@ -337,8 +600,28 @@ namespace Void {
   }
 
   // InfixExpression
+  namespace {
+    InfixOp decode_infix_op(std::string const& op) {
+      static std::pair<char const*, InfixOp> const ops[] = {
+	{"+", InfixOp::add}, {"-", InfixOp::sub}, {"*", InfixOp::mul}, {"/", InfixOp::div},
+	{"<", InfixOp::lt}, {"<=", InfixOp::le}, {">", InfixOp::gt}, {">=", InfixOp::ge},
+	{"==", InfixOp::eq}, {"!=", InfixOp::ne},
+      };
+      for (auto& [name, value] : ops) {
+	if (op == name) {
+	  return value;
+	}
+      }
+      return InfixOp::other;
+    }
+  }
+
   InfixExpression::InfixExpression(Token token)
-    : Expression(token), _op(token.literal) {}
+    : Expression(token), _op(token.literal), _infix_op(decode_infix_op(_op)) {}
+
+  NodeKind InfixExpression::kind() const {
+    return NodeKind::infix_expression;
+  }
 
   std::string InfixExpression::to_string() const {
     if (_left == nullptr || _right == nullptr) {
@@ -351,6 +634,10 @@ namespace Void {
     return _op;
   }
 
+  InfixOp InfixExpression::infix_op() const {
+    return _infix_op;
+  }
+
   Expression* InfixExpression::left() const {
     return _left.get(); 
   }
@@ -366,4 +653,16 @@ namespace Void {
   void InfixExpression::set_right(std::unique_ptr<Expression> expr) {
     _right.swap(expr); 
   }
+
+  InfixFeedback& InfixExpression::feedback() {
+    return _feedback;
+  }
+
+  Quick InfixExpression::quick() const {
+    return _quick;
+  }
+
+  void InfixExpression::set_quick(Quick quick) {
+    _quick = quick;
+  }
 }
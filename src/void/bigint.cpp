@@ -0,0 +1,390 @@
+#include <void/bigint.hpp>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace Void {
+  namespace {
+    using Limbs = BigInt::Limbs;
+
+    Limbs slice(Limbs const& limbs, std::size_t from, std::size_t to) {
+      from = std::min(from, limbs.size());
+      to = std::min(to, limbs.size());
+      Limbs res(limbs.begin() + from, limbs.begin() + to);
+      while (!res.empty() && res.back() == 0) {
+	res.pop_back();
+      }
+      return res;
+    }
+
+    // res += value << (32 * shift)
+    void add_shifted(Limbs& res, Limbs const& value, std::size_t shift) {
+      if (res.size() < value.size() + shift + 1) {
+	res.resize(value.size() + shift + 1, 0);
+      }
+      std::uint64_t carry = 0;
+      std::size_t i = 0;
+      for (; i < value.size(); ++i) {
+	carry += static_cast<std::uint64_t>(res[i + shift]) + value[i];
+	res[i + shift] = static_cast<std::uint32_t>(carry);
+	carry >>= 32;
+      }
+      for (i += shift; carry != 0; ++i) {
+	if (i == res.size()) {
+	  res.push_back(0);
+	}
+	carry += res[i];
+	res[i] = static_cast<std::uint32_t>(carry);
+	carry >>= 32;
+      }
+    }
+
+    void mul_small_add(Limbs& limbs, std::uint32_t mul, std::uint32_t add) {
+      std::uint64_t carry = add;
+      for (auto& limb : limbs) {
+	carry += static_cast<std::uint64_t>(limb) * mul;
+	limb = static_cast<std::uint32_t>(carry);
+	carry >>= 32;
+      }
+      if (carry != 0) {
+	limbs.push_back(static_cast<std::uint32_t>(carry));
+      }
+    }
+  }
+
+  BigInt::BigInt(std::int64_t value)
+    : _negative(value < 0) {
+    auto mag = value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+    while (mag != 0) {
+      _limbs.push_back(static_cast<std::uint32_t>(mag));
+      mag >>= 32;
+    }
+  }
+
+  bool BigInt::parse(std::string_view digits, BigInt& res) {
+    bool negative = false;
+    if (!digits.empty() && digits.front() == '-') {
+      negative = true;
+      digits.remove_prefix(1);
+    }
+    if (digits.empty()) {
+      return false;
+    }
+
+    Limbs limbs;
+    while (!digits.empty()) {
+      auto len = std::min<std::size_t>(9, digits.size());
+      std::uint32_t chunk = 0, mul = 1;
+      for (std::size_t i = 0; i < len; ++i) {
+	if (digits[i] < '0' || digits[i] > '9') {
+	  return false;
+	}
+	chunk = chunk * 10 + (digits[i] - '0');
+	mul *= 10;
+      }
+      mul_small_add(limbs, mul, chunk);
+      digits.remove_prefix(len);
+    }
+    trim(limbs);
+
+    res._limbs = std::move(limbs);
+    res._negative = negative && !res._limbs.empty();
+    return true;
+  }
+
+  std::string BigInt::to_string() const {
+    if (is_zero()) {
+      return "0";
+    }
+
+    std::vector<std::uint32_t> chunks;
+    auto mag = _limbs;
+    while (!mag.empty()) {
+      chunks.push_back(divmod_small(mag, 1000000000));
+    }
+
+    std::string res = _negative ? "-" : "";
+    res += std::to_string(chunks.back());
+    char buf[16];
+    for (auto it = chunks.rbegin() + 1; it != chunks.rend(); ++it) {
+      std::snprintf(buf, sizeof(buf), "%09u", *it);
+      res += buf;
+    }
+    return res;
+  }
+
+  bool BigInt::is_zero() const {
+    return _limbs.empty();
+  }
+
+  bool BigInt::is_negative() const {
+    return _negative;
+  }
+
+  bool BigInt::fits_int64() const {
+    if (_limbs.size() > 2) {
+      return false;
+    }
+    std::uint64_t mag = 0;
+    for (std::size_t i = _limbs.size(); i-- > 0; ) {
+      mag = (mag << 32) | _limbs[i];
+    }
+    return _negative ? mag <= (std::uint64_t{1} << 63) : mag < (std::uint64_t{1} << 63);
+  }
+
+  std::int64_t BigInt::to_int64() const {
+    std::uint64_t mag = 0;
+    for (std::size_t i = _limbs.size(); i-- > 0; ) {
+      mag = (mag << 32) | _limbs[i];
+    }
+    return static_cast<std::int64_t>(_negative ? 0 - mag : mag);
+  }
+
+  int BigInt::compare(BigInt const& other) const {
+    if (_negative != other._negative) {
+      return _negative ? -1 : 1;
+    }
+    auto res = compare_magnitude(_limbs, other._limbs);
+    return _negative ? -res : res;
+  }
+
+  std::uint64_t BigInt::hash() const {
+    std::uint64_t res = _negative ? 0x9e3779b97f4a7c15ULL : 0;
+    for (auto limb : _limbs) {
+      res = (res ^ limb) * 0x100000001b3ULL;
+      res ^= res >> 29;
+    }
+    return res;
+  }
+
+  BigInt BigInt::operator-() const {
+    auto res = *this;
+    res._negative = !_negative && !_limbs.empty();
+    return res;
+  }
+
+  BigInt operator+(BigInt const& left, BigInt const& right) {
+    BigInt res;
+    if (left._negative == right._negative) {
+      res._limbs = BigInt::add_magnitude(left._limbs, right._limbs);
+      res._negative = left._negative;
+    } else if (BigInt::compare_magnitude(left._limbs, right._limbs) >= 0) {
+      res._limbs = BigInt::sub_magnitude(left._limbs, right._limbs);
+      res._negative = left._negative;
+    } else {
+      res._limbs = BigInt::sub_magnitude(right._limbs, left._limbs);
+      res._negative = right._negative;
+    }
+    res._negative = res._negative && !res._limbs.empty();
+    return res;
+  }
+
+  BigInt operator-(BigInt const& left, BigInt const& right) {
+    return left + -right;
+  }
+
+  BigInt operator*(BigInt const& left, BigInt const& right) {
+    BigInt res;
+    res._limbs = BigInt::mul_magnitude(left._limbs, right._limbs);
+    res._negative = (left._negative != right._negative) && !res._limbs.empty();
+    return res;
+  }
+
+  BigInt operator/(BigInt const& left, BigInt const& right) {
+    BigInt quot;
+    BigInt::Limbs rem;
+    BigInt::divmod_magnitude(left._limbs, right._limbs, quot._limbs, rem);
+    quot._negative = (left._negative != right._negative) && !quot._limbs.empty();
+    return quot;
+  }
+
+  BigInt operator%(BigInt const& left, BigInt const& right) {
+    BigInt rem;
+    BigInt::Limbs quot;
+    BigInt::divmod_magnitude(left._limbs, right._limbs, quot, rem._limbs);
+    rem._negative = left._negative && !rem._limbs.empty();
+    return rem;
+  }
+
+  BigInt::Limbs BigInt::add_magnitude(Limbs const& left, Limbs const& right) {
+    auto res = left;
+    add_shifted(res, right, 0);
+    trim(res);
+    return res;
+  }
+
+  BigInt::Limbs BigInt::sub_magnitude(Limbs const& left, Limbs const& right) {
+    Limbs res(left.size());
+    std::int64_t borrow = 0;
+    for (std::size_t i = 0; i < left.size(); ++i) {
+      std::int64_t diff = static_cast<std::int64_t>(left[i]) - borrow - (i < right.size() ? right[i] : 0);
+      borrow = diff < 0;
+      res[i] = static_cast<std::uint32_t>(diff + (borrow << 32));
+    }
+    trim(res);
+    return res;
+  }
+
+  BigInt::Limbs BigInt::mul_magnitude(Limbs const& left, Limbs const& right) {
+    if (left.empty() || right.empty()) {
+      return {};
+    }
+    if (std::min(left.size(), right.size()) < karatsuba_threshold) {
+      return mul_schoolbook(left, right);
+    }
+    return mul_karatsuba(left, right);
+  }
+
+  BigInt::Limbs BigInt::mul_schoolbook(Limbs const& left, Limbs const& right) {
+    Limbs res(left.size() + right.size(), 0);
+    for (std::size_t i = 0; i < left.size(); ++i) {
+      std::uint64_t carry = 0;
+      for (std::size_t j = 0; j < right.size(); ++j) {
+	carry += static_cast<std::uint64_t>(left[i]) * right[j] + res[i + j];
+	res[i + j] = static_cast<std::uint32_t>(carry);
+	carry >>= 32;
+      }
+      res[i + right.size()] = static_cast<std::uint32_t>(carry);
+    }
+    trim(res);
+    return res;
+  }
+
+  BigInt::Limbs BigInt::mul_karatsuba(Limbs const& left, Limbs const& right) {
+    // left = l1 * B^k + l0, right = r1 * B^k + r0
+    auto k = std::max(left.size(), right.size()) / 2;
+    auto l0 = slice(left, 0, k), l1 = slice(left, k, left.size());
+    auto r0 = slice(right, 0, k), r1 = slice(right, k, right.size());
+
+    Limbs res;
+    if (l1.empty() || r1.empty()) {
+      // unbalanced operands, only the longer one is split
+      auto& whole = l1.empty() ? left : right;
+      auto& lo = l1.empty() ? r0 : l0;
+      auto& hi = l1.empty() ? r1 : l1;
+      add_shifted(res, mul_magnitude(lo, whole), 0);
+      add_shifted(res, mul_magnitude(hi, whole), k);
+      trim(res);
+      return res;
+    }
+
+    auto z0 = mul_magnitude(l0, r0);
+    auto z2 = mul_magnitude(l1, r1);
+    auto z1 = mul_magnitude(add_magnitude(l0, l1), add_magnitude(r0, r1));
+    z1 = sub_magnitude(sub_magnitude(z1, z0), z2);
+
+    res = z0;
+    add_shifted(res, z1, k);
+    add_shifted(res, z2, 2 * k);
+    trim(res);
+    return res;
+  }
+
+  void BigInt::divmod_magnitude(Limbs const& left, Limbs const& right, Limbs& quot, Limbs& rem) {
+    if (compare_magnitude(left, right) < 0) {
+      quot.clear();
+      rem = left;
+      return;
+    }
+    if (right.size() == 1) {
+      quot = left;
+      auto r = divmod_small(quot, right[0]);
+      rem.clear();
+      if (r != 0) {
+	rem.push_back(r);
+      }
+      return;
+    }
+
+    // Knuth, TAOCP vol. 2, 4.3.1 algorithm D
+    auto n = right.size();
+    auto m = left.size() - n;
+    int s = __builtin_clz(right.back());
+
+    Limbs vn(n), un(left.size() + 1);
+    for (std::size_t i = n - 1; i > 0; --i) {
+      vn[i] = (right[i] << s) | (s ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(right[i - 1]) >> (32 - s)) : 0);
+    }
+    vn[0] = right[0] << s;
+    un[left.size()] = s ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(left.back()) >> (32 - s)) : 0;
+    for (std::size_t i = left.size() - 1; i > 0; --i) {
+      un[i] = (left[i] << s) | (s ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(left[i - 1]) >> (32 - s)) : 0);
+    }
+    un[0] = left[0] << s;
+
+    constexpr std::uint64_t base = std::uint64_t{1} << 32;
+    quot.assign(m + 1, 0);
+    for (std::size_t j = m + 1; j-- > 0; ) {
+      auto num = (static_cast<std::uint64_t>(un[j + n]) << 32) | un[j + n - 1];
+      auto qhat = num / vn[n - 1];
+      auto rhat = num % vn[n - 1];
+      while (qhat >= base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+	--qhat;
+	rhat += vn[n - 1];
+	if (rhat >= base) {
+	  break;
+	}
+      }
+
+      // multiply and subtract
+      std::int64_t k = 0, t = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+	auto p = qhat * vn[i];
+	t = static_cast<std::int64_t>(un[i + j]) - k - static_cast<std::int64_t>(p & 0xffffffff);
+	un[i + j] = static_cast<std::uint32_t>(t);
+	k = static_cast<std::int64_t>(p >> 32) - (t >> 32);
+      }
+      t = static_cast<std::int64_t>(un[j + n]) - k;
+      un[j + n] = static_cast<std::uint32_t>(t);
+
+      quot[j] = static_cast<std::uint32_t>(qhat);
+      if (t < 0) {
+	// subtracted too much, add back
+	--quot[j];
+	std::uint64_t carry = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+	  carry += static_cast<std::uint64_t>(un[i + j]) + vn[i];
+	  un[i + j] = static_cast<std::uint32_t>(carry);
+	  carry >>= 32;
+	}
+	un[j + n] += static_cast<std::uint32_t>(carry);
+      }
+    }
+
+    rem.assign(n, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+      rem[i] = (un[i] >> s) | (s ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(un[i + 1]) << (32 - s)) : 0);
+    }
+    trim(quot);
+    trim(rem);
+  }
+
+  int BigInt::compare_magnitude(Limbs const& left, Limbs const& right) {
+    if (left.size() != right.size()) {
+      return left.size() < right.size() ? -1 : 1;
+    }
+    for (std::size_t i = left.size(); i-- > 0; ) {
+      if (left[i] != right[i]) {
+	return left[i] < right[i] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  std::uint32_t BigInt::divmod_small(Limbs& limbs, std::uint32_t divisor) {
+    std::uint64_t rem = 0;
+    for (std::size_t i = limbs.size(); i-- > 0; ) {
+      rem = (rem << 32) | limbs[i];
+      limbs[i] = static_cast<std::uint32_t>(rem / divisor);
+      rem %= divisor;
+    }
+    trim(limbs);
+    return static_cast<std::uint32_t>(rem);
+  }
+
+  void BigInt::trim(Limbs& limbs) {
+    while (!limbs.empty() && limbs.back() == 0) {
+      limbs.pop_back();
+    }
+  }
+}
@@ -2,9 +2,13 @@
 #include <system_error>
 #include <void/builtin.hpp>
 #include <void/object.hpp>
+#include <void/simd.hpp>
+#include <void/counters.hpp>
+#include <void/heap_profiler.hpp>
 #include <memory>
 #include <vector>
 #include <iostream>
+#include <sstream>
 
 namespace Void {
   std::map<std::string, std::shared_ptr<Builtin>> builtin_func_map = {
@@ -14,31 +18,37 @@ namespace Void {
     {"push", std::make_shared<Builtin>(push, "push")},
     {"pop", std::make_shared<Builtin>(pop, "pop")},
     {"puts", std::make_shared<Builtin>(puts, "puts")},
+    {"keys", std::make_shared<Builtin>(keys, "keys")},
+    {"values", std::make_shared<Builtin>(values, "values")},
+    {"get", std::make_shared<Builtin>(get, "get")},
+    {"set", std::make_shared<Builtin>(set, "set", 3)},
+    {"substr", std::make_shared<Builtin>(substr, "substr", 3)},
+    {"intern", std::make_shared<Builtin>(intern, "intern")},
+    {"int_array", std::make_shared<Builtin>(int_array, "int_array")},
+    {"to_array", std::make_shared<Builtin>(to_array, "to_array")},
+    {"sum", std::make_shared<Builtin>(sum, "sum")},
+    {"dot", std::make_shared<Builtin>(dot, "dot")},
+    {"min", std::make_shared<Builtin>(min, "min")},
+    {"max", std::make_shared<Builtin>(max, "max")},
+    {"stats", std::make_shared<Builtin>(stats, "stats")},
+    {"heap_profile", std::make_shared<Builtin>(heap_profile, "heap_profile")},
   };
 
-  std::shared_ptr<Object> len(std::vector<std::shared_ptr<Object>> const& args) {
-    if (args.size() != 1) {
-      return std::make_shared<Error>();
-    }
-    
-    auto& obj = args[0];
-
+  std::shared_ptr<Object> len(std::shared_ptr<Object> const& obj) {
     if (obj->type() == Object::string_object_t) {
-      return std::make_shared<Integer>(obj->cast<String>()->value().size());
+      return Integer::make(obj->cast<String>()->size());
     } else if (obj->type() == Object::array_object_t) {
-      return std::make_shared<Integer>(obj->cast<Array>()->value().size());
+      return Integer::make(obj->cast<Array>()->value().size());
+    } else if (obj->type() == Object::int_array_object_t) {
+      return Integer::make(obj->cast<IntArray>()->values().size());
+    } else if (obj->type() == Object::hash_object_t) {
+      return Integer::make(obj->cast<Hash>()->pairs().size());
     } else {
       return std::make_shared<Error>();
     }
   }
 
-  std::shared_ptr<Object> first(std::vector<std::shared_ptr<Object>> const& args) {
-    if (args.size() != 1) {
-      return std::make_shared<Error>();
-    }
-    
-    auto& obj = args[0];
-
+  std::shared_ptr<Object> first(std::shared_ptr<Object> const& obj) {
     if (obj->type() == Object::array_object_t) {
       auto arr = obj->cast<Array>();
       if (arr->elements().empty()) {
@@ -51,13 +61,7 @@ namespace Void {
     }
   }
 
-  std::shared_ptr<Object> last(std::vector<std::shared_ptr<Object>> const& args) {
-    if (args.size() != 1) {
-      return std::make_shared<Error>();
-    }
-    
-    auto& obj = args[0];
-
+  std::shared_ptr<Object> last(std::shared_ptr<Object> const& obj) {
     if (obj->type() == Object::array_object_t) {
       auto arr = obj->cast<Array>();
       if (arr->elements().empty()) {
@@ -70,56 +74,221 @@ namespace Void {
     }
   }
 
-  std::shared_ptr<Object> push(std::vector<std::shared_ptr<Object>> const& args) {
-    if (args.size() != 2) {
+  std::shared_ptr<Object> push(std::shared_ptr<Object> const& arr_obj, std::shared_ptr<Object> const& obj) {
+    if (arr_obj->type() == Object::array_object_t) {
+      auto& elems = arr_obj->cast<Array>()->elements();
+      return std::make_shared<Array>(elems.push_back(obj));
+    } else {
       return std::make_shared<Error>();
     }
+  }
 
-    auto& arr_obj = args[0];
-    auto& obj = args[1];
-
+  std::shared_ptr<Object> pop(std::shared_ptr<Object> const& arr_obj) {
     if (arr_obj->type() == Object::array_object_t) {
       auto& elems = arr_obj->cast<Array>()->elements();
-      auto res = std::make_shared<Array>();
-      for (auto& elem : elems) {
-	res->append(elem);
+      if (elems.empty()) {
+	return std::make_shared<Error>();
       }
-      res->append(obj);
-      return res; 
+      return std::make_shared<Array>(elems.pop_back());
     } else {
       return std::make_shared<Error>();
     }
   }
 
-  std::shared_ptr<Object> pop(std::vector<std::shared_ptr<Object>> const& args) {
-    if (args.size() != 1) {
+  std::shared_ptr<Object> puts(std::shared_ptr<Object> const& arg) {
+    StreamSink out(std::cout, display_limits);
+    out.write("<puts: ");
+    arg->write_to(out);
+    out.finish(">\n");
+    out.flush();
+    std::cout.flush();
+
+    return null_obj;
+  }
+
+  std::shared_ptr<Object> keys(std::shared_ptr<Object> const& arg) {
+    if (arg->type() != Object::hash_object_t) {
       return std::make_shared<Error>();
     }
 
-    auto& arr_obj = args[0];
+    auto res = std::make_shared<Array>();
+    for (auto& entry : arg->cast<Hash>()->pairs().entries()) {
+      res->append(entry.key);
+    }
+    return res;
+  }
 
-    if (arr_obj->type() == Object::array_object_t) {
-      auto& elems = arr_obj->cast<Array>()->elements();
-      if (elems.empty()) {
+  std::shared_ptr<Object> values(std::shared_ptr<Object> const& arg) {
+    if (arg->type() != Object::hash_object_t) {
+      return std::make_shared<Error>();
+    }
+
+    auto res = std::make_shared<Array>();
+    for (auto& entry : arg->cast<Hash>()->pairs().entries()) {
+      res->append(entry.value);
+    }
+    return res;
+  }
+
+  std::shared_ptr<Object> get(std::shared_ptr<Object> const& hash, std::shared_ptr<Object> const& key) {
+    if (hash->type() != Object::hash_object_t) {
+      return std::make_shared<Error>();
+    }
+    if (!HashTable::hashable(key.get())) {
+      return std::make_shared<Error>();
+    }
+
+    auto value = hash->cast<Hash>()->get(key.get());
+    return value ? value : null_obj;
+  }
+
+  std::shared_ptr<Object> set(Args args) {
+    if (args[0]->type() != Object::hash_object_t) {
+      return std::make_shared<Error>();
+    }
+    if (!HashTable::hashable(args[1].get())) {
+      return std::make_shared<Error>();
+    }
+
+    // hashes are values, set returns a modified copy
+    auto res = std::make_shared<Hash>(*args[0]->cast<Hash>());
+    res->set(args[1], args[2]);
+    return res;
+  }
+
+  std::shared_ptr<Object> substr(Args args) {
+    if (args[0]->type() != Object::string_object_t ||
+	args[1]->type() != Object::integer_object_t ||
+	args[2]->type() != Object::integer_object_t) {
+      return std::make_shared<Error>();
+    }
+
+    auto pos = args[1]->cast<Integer>()->value();
+    auto len = args[2]->cast<Integer>()->value();
+    if (pos < 0 || len < 0) {
+      return std::make_shared<Error>();
+    }
+    return args[0]->cast<String>()->substr(pos, len);
+  }
+
+  std::shared_ptr<Object> intern(std::shared_ptr<Object> const& arg) {
+    if (arg->type() != Object::string_object_t) {
+      return std::make_shared<Error>();
+    }
+
+    return String::intern(std::static_pointer_cast<String>(arg));
+  }
+
+  std::shared_ptr<Object> int_array(std::shared_ptr<Object> const& arg) {
+    if (arg->type() == Object::int_array_object_t) {
+      return arg;
+    }
+    if (arg->type() != Object::array_object_t) {
+      return std::make_shared<Error>();
+    }
+
+    auto& elems = arg->cast<Array>()->elements();
+    IntArray::Values values;
+    values.reserve(elems.size());
+    for (auto& elem : elems) {
+      if (elem->type() != Object::integer_object_t) {
 	return std::make_shared<Error>();
       }
-      auto res = std::make_shared<Array>();
-      for (std::size_t i = 0; i + 1 < elems.size(); ++i) {
-	res->append(elems[i]);
-      }
-      return res; 
-    } else {
+      values.push_back(elem->cast<Integer>()->value());
+    }
+    return std::make_shared<IntArray>(std::move(values));
+  }
+
+  std::shared_ptr<Object> to_array(std::shared_ptr<Object> const& arg) {
+    if (arg->type() != Object::int_array_object_t) {
       return std::make_shared<Error>();
     }
+
+    auto res = std::make_shared<Array>();
+    for (auto value : arg->cast<IntArray>()->values()) {
+      res->append(Integer::make(value));
+    }
+    return res;
   }
 
-  std::shared_ptr<Object> puts(std::vector<std::shared_ptr<Object>> const& args) {
-    if (args.size() != 1) {
+  std::shared_ptr<Object> sum(std::shared_ptr<Object> const& arg) {
+    if (arg->type() != Object::int_array_object_t) {
       return std::make_shared<Error>();
     }
 
-    std::cout << "<puts: " << args[0]->inspect() << ">" << std::endl;
+    auto& values = arg->cast<IntArray>()->values();
+    std::int64_t res;
+    if (simd::sum(values.data(), values.size(), res)) {
+      return Integer::make(res);
+    }
+    BigInt big;
+    for (auto value : values) {
+      big = big + BigInt(value);
+    }
+    return BigInteger::make(std::move(big));
+  }
+
+  std::shared_ptr<Object> dot(std::shared_ptr<Object> const& left, std::shared_ptr<Object> const& right) {
+    if (left->type() != Object::int_array_object_t ||
+	right->type() != Object::int_array_object_t) {
+      return std::make_shared<Error>();
+    }
 
-    return null_obj;
+    auto& lhs = left->cast<IntArray>()->values();
+    auto& rhs = right->cast<IntArray>()->values();
+    if (lhs.size() != rhs.size()) {
+      return std::make_shared<Error>();
+    }
+    std::int64_t res;
+    if (simd::dot(lhs.data(), rhs.data(), lhs.size(), res)) {
+      return Integer::make(res);
+    }
+    BigInt big;
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+      big = big + BigInt(lhs[i]) * BigInt(rhs[i]);
+    }
+    return BigInteger::make(std::move(big));
+  }
+
+  std::shared_ptr<Object> min(std::shared_ptr<Object> const& arg) {
+    if (arg->type() != Object::int_array_object_t) {
+      return std::make_shared<Error>();
+    }
+
+    auto& values = arg->cast<IntArray>()->values();
+    if (values.empty()) {
+      return std::make_shared<Error>();
+    }
+    return Integer::make(simd::min(values.data(), values.size()));
+  }
+
+  std::shared_ptr<Object> max(std::shared_ptr<Object> const& arg) {
+    if (arg->type() != Object::int_array_object_t) {
+      return std::make_shared<Error>();
+    }
+
+    auto& values = arg->cast<IntArray>()->values();
+    if (values.empty()) {
+      return std::make_shared<Error>();
+    }
+    return Integer::make(simd::max(values.data(), values.size()));
+  }
+
+  std::shared_ptr<Object> stats() {
+    auto counters = Counters::active();
+    if (!counters) {
+      return std::make_shared<Error>("stats() needs a build with VOID_STATS");
+    }
+    // a copy, so the objects built for the result do not count themselves
+    return Counters(*counters).to_object();
+  }
+
+  std::shared_ptr<Object> heap_profile() {
+    if (!heap_profiler::active()) {
+      return std::make_shared<Error>("heap profiling is off");
+    }
+    std::ostringstream report;
+    heap_profiler::write_report(report);
+    return std::make_shared<String>(report.str());
   }
 }
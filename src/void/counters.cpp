@@ -0,0 +1,132 @@
+#include <void/counters.hpp>
+
+#include <cstdio>
+#include <sstream>
+
+namespace Void {
+#ifdef VOID_STATS
+  namespace detail {
+    thread_local Counters* active_counters = nullptr;
+  }
+#endif
+
+  namespace {
+    void write_json_string(std::ostream& os, std::string const& str) {
+      os << '"';
+      for (unsigned char c : str) {
+	if (c == '"' || c == '\\') {
+	  os << '\\' << c;
+	} else if (c < 0x20) {
+	  char buf[8];
+	  std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+	  os << buf;
+	} else {
+	  os << c;
+	}
+      }
+      os << '"';
+    }
+
+    // the non-zero entries of a per-kind or per-type array
+    template <typename Name, std::size_t N>
+    std::map<std::string, std::uint64_t> named(std::array<std::uint64_t, N> const& counts, Name name) {
+      std::map<std::string, std::uint64_t> res;
+      for (std::size_t i = 0; i < N; ++i) {
+	if (counts[i]) {
+	  res.emplace(name(i), counts[i]);
+	}
+      }
+      return res;
+    }
+
+    std::map<std::string, std::uint64_t> nodes_by_name(Counters const& counters) {
+      return named(counters.nodes, [](std::size_t i) { return to_string(static_cast<NodeKind>(i)); });
+    }
+
+    std::map<std::string, std::uint64_t> objects_by_name(Counters const& counters) {
+      return named(counters.objects, [](std::size_t i) { return to_string(static_cast<Object::ObjectType>(i)); });
+    }
+
+    std::shared_ptr<Object> to_hash(std::map<std::string, std::uint64_t> const& counts) {
+      auto res = std::make_shared<Hash>();
+      for (auto& [name, count] : counts) {
+	res->set(std::make_shared<String>(name), Integer::make(static_cast<std::int64_t>(count)));
+      }
+      return res;
+    }
+  }
+
+  std::map<std::string, std::uint64_t> Counters::builtin_calls_by_name() const {
+    std::map<std::string, std::uint64_t> res;
+    for (auto& [builtin, count] : builtin_calls) {
+      res[builtin->cast<Builtin>()->name()] += count;
+    }
+    return res;
+  }
+
+  std::string Counters::to_json() const {
+    std::ostringstream os;
+    auto write_map = [&](std::map<std::string, std::uint64_t> const& counts) {
+      os << '{';
+      char const* sep = "";
+      for (auto& [name, count] : counts) {
+	os << sep;
+	write_json_string(os, name);
+	os << ": " << count;
+	sep = ", ";
+      }
+      os << '}';
+    };
+
+    os << "{\"nodes\": ";
+    write_map(nodes_by_name(*this));
+    os << ", \"env_gets\": " << env_gets
+       << ", \"env_hops\": " << env_hops
+       << ", \"objects\": ";
+    write_map(objects_by_name(*this));
+    os << ", \"builtin_calls\": ";
+    write_map(builtin_calls_by_name());
+    os << ", \"function_calls\": " << function_calls
+       << ", \"max_depth\": " << max_depth << '}';
+    return os.str();
+  }
+
+  std::shared_ptr<Object> Counters::to_object() const {
+    auto res = std::make_shared<Hash>();
+    auto set = [&](char const* key, std::shared_ptr<Object> value) {
+      res->set(std::make_shared<String>(key), std::move(value));
+    };
+    set("nodes", to_hash(nodes_by_name(*this)));
+    set("env_gets", Integer::make(static_cast<std::int64_t>(env_gets)));
+    set("env_hops", Integer::make(static_cast<std::int64_t>(env_hops)));
+    set("objects", to_hash(objects_by_name(*this)));
+    set("builtin_calls", to_hash(builtin_calls_by_name()));
+    set("function_calls", Integer::make(static_cast<std::int64_t>(function_calls)));
+    set("max_depth", Integer::make(max_depth));
+    return res;
+  }
+
+#ifdef VOID_STATS
+  Counters::Activation::Activation(Counters& counters)
+    : _outer(detail::active_counters) {
+    detail::active_counters = &counters;
+  }
+
+  Counters::Activation::~Activation() {
+    detail::active_counters = _outer;
+  }
+
+  Counters* Counters::active() {
+    return detail::active_counters;
+  }
+#else
+  Counters::Activation::Activation(Counters&)
+    : _outer(nullptr) {}
+
+  Counters::Activation::~Activation() {}
+
+  Counters* Counters::active() {
+    return nullptr;
+  }
+#endif
+}
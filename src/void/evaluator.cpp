@@ -3,63 +3,330 @@
 #include <void/object.hpp>
 #include <void/parser.hpp>
 #include <void/evaluator.hpp>
+#include <void/simd.hpp>
+#include <void/heap_profiler.hpp>
+#include <void/perf_counters.hpp>
+#include <void/tracer.hpp>
+#include <void/type_feedback.hpp>
+#include <void/type_inference.hpp>
+#include <algorithm>
+#include <utility>
 #include <memory>
 #include <cstddef>
+#include <cstdint>
 #include <vector>
+#include <iostream>
 
 namespace Void {
+  namespace {
+    // slot misses before an identifier stops caching where it was found
+    constexpr std::uint32_t max_slot_misses = 8;
+    // misses before a call site drops its targets
+    constexpr std::uint32_t max_call_misses = 8;
+
+    // the scope `hops` out, nullptr if there are fewer or a nearer one
+    // may bind the name of `bit`
+    Environment* scope_out(Environment* env, std::uint64_t bit, std::uint32_t hops) {
+      for (; hops && env && !(env->names() & bit); --hops) {
+	env = env->outer().get();
+      }
+      return hops ? nullptr : env;
+    }
+
+    // the target whose binding a callee named by `bit` still reads,
+    // nullptr on a miss
+    CallTarget const* find_call_target(CallCache const& cache, std::uint64_t bit, Environment* env) {
+      for (std::uint8_t i = 0; i < cache.size; ++i) {
+	auto& target = cache.targets[i];
+	auto scope = scope_out(env, bit, target.hops);
+	if (scope && scope->id() == target.env && target.slot->get() == target.raw && !target.object.expired()) {
+	  count_env_get(target.hops);
+	  return &target;
+	}
+      }
+      return nullptr;
+    }
+
+    // After a miss, caches the target the callee just resolved to if it
+    // was read from the binding its slot cache holds and, for a function,
+    // its arity matches the site's
+    void add_call_target(CallCache& cache, Identifier* callee, std::shared_ptr<Object> const& object,
+			 std::size_t args, Environment* env) {
+      if (cache.size && ++cache.misses == max_call_misses) {
+	for (auto& target : cache.targets) {
+	  target = {};
+	}
+	cache.size = 0;
+	cache.megamorphic = true;
+	return;
+      }
+      FunctionLiteral const* function = nullptr;
+      if (object->type() == Object::function_object_t) {
+	function = object->cast<Function>()->function();
+	if (function->parameters().size() != args) {
+	  return;
+	}
+      }
+      if (callee->quick() != Quick::slot) {
+	return;
+      }
+      auto& slot = callee->slot_cache();
+      auto scope = scope_out(env, callee->bit(), slot.hops);
+      if (!scope || scope->id() != slot.env || slot.slot->get() != object.get()) {
+	return;
+      }
+      auto& target = cache.size < CallCache::ways ? cache.targets[cache.size++]
+						  : cache.targets[cache.next++ % CallCache::ways];
+      target = {object, object.get(), function, slot.slot, slot.env, slot.hops};
+    }
+
+    // True when the only references to a returning call's scope, other
+    // than the caller's, come from closures bound in it that nothing else
+    // holds: a cycle that nothing outside can reach any more.
+    bool closed_cycle(std::shared_ptr<Environment> const& env) {
+      auto refs = env.use_count() - 1;
+      if (refs == 0) {
+	return false;
+      }
+      long inner = 0;
+      for (auto& [name, value] : env->store()) {
+	if (value->type() == Object::function_object_t && value.use_count() == 1 &&
+	    value->cast<Function>()->env() == env) {
+	  ++inner;
+	}
+      }
+      return inner == refs;
+    }
+  }
+
+  // Script
+  Script::Script(Evaluator* evaluator, std::shared_ptr<Program> program, std::vector<std::string> errors)
+    : _evaluator(evaluator),
+      _program(std::move(program)),
+      _errors(std::move(errors))
+  {}
+
+  std::shared_ptr<Object> Script::run() const {
+    if (!ok()) {
+      return std::make_shared<Error>(_errors.front());
+    }
+    return _evaluator->run(_program);
+  }
+
+  bool Script::ok() const {
+    return _errors.empty();
+  }
+
+  std::vector<std::string> const& Script::errors() const {
+    return _errors;
+  }
+
+  // Evaluator
   Evaluator::Evaluator()
-    : _env(std::make_unique<Environment>()) {}
+    : _env(std::make_shared<Environment>()) {}
+
+  Evaluator::~Evaluator() {
+    // a function bound in the scope it captured keeps that scope alive
+    for (auto& weak : _captured) {
+      if (auto env = weak.lock()) {
+	env->clear();
+      }
+    }
+    _env->clear();
+  }
 
   std::shared_ptr<Object> Evaluator::eval(std::string const& input) {
+    return compile(input).run();
+  }
+
+  std::shared_ptr<Object> Evaluator::eval(std::string const& input, EvalTiming& timing) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    auto tokens = Lexer(input).tokenize();
+    auto lexed = Clock::now();
+
+    timing.tokens = tokens.size() - 1; // not eof
+    auto nodes = AstNode::made_on_thread();
+    Parser parser(std::move(tokens));
+    std::shared_ptr<Program> program = parser.parse();
+    auto parsed = Clock::now();
+    timing.nodes = AstNode::made_on_thread() - nodes;
+
+    program->set_source(input);
+    if (_inference) {
+      _inference->merge(type_inference::infer(*program));
+    }
+    if (_profile) {
+      _profile->attach(program);
+    }
+    auto res = Script(this, std::move(program), parser.error()).run();
+    auto done = Clock::now();
+    timing.lex = lexed - start;
+    timing.parse = parsed - lexed;
+    timing.eval = done - parsed;
+    return res;
+  }
+
+  Script Evaluator::compile(std::string const& input) {
     Parser parser(input);
-    _programs.emplace_back(parser.parse());
-    return eval(_programs.back().get(), _env.get()); 
+    std::shared_ptr<Program> program = parser.parse();
+    program->set_source(input);
+    if (_inference) {
+      _inference->merge(type_inference::infer(*program));
+    }
+    if (_profile) {
+      _profile->attach(program);
+    }
+    return Script(this, std::move(program), parser.error());
   }
 
-  std::shared_ptr<Object> Evaluator::eval(AstNode* node, Environment* env) {
-    if (auto program = dynamic_cast<Program*>(node)) {
-      return eval_program(program, env); 
-    } else if (auto let_stmt = dynamic_cast<LetStatement*>(node)) {
-      return eval_let_statement(let_stmt, env); 
-    } else if (auto ret_stmt = dynamic_cast<ReturnStatement*>(node)) {
-      return eval_return_statement(ret_stmt, env); 
-    } else if (auto expr_stmt = dynamic_cast<ExpressionStatement*>(node)) {
-      return eval_expression_statement(expr_stmt, env); 
-    } else if (auto prefix_expr = dynamic_cast<PrefixExpression*>(node)) {
-      return eval_prefix_expression(prefix_expr, env);
-    } else if (auto infix_expr = dynamic_cast<InfixExpression*>(node)) {
-      return eval_infix_expression(infix_expr, env);
-    } else if (auto if_expr = dynamic_cast<IfExpression*>(node)) {
-      return eval_if_expression(if_expr, env);
-    } else if (auto ident = dynamic_cast<Identifier*>(node)) {
-      return eval_identifier(ident, env);
-    } else if (auto block_stmt = dynamic_cast<BlockStatement*>(node)) {
-      return eval_block_statement(block_stmt, env);
-    } else if (auto call_expr = dynamic_cast<CallExpression*>(node)) {
-      return eval_call_expression(call_expr, env);
-    } else if (auto index_expr = dynamic_cast<IndexExpression*>(node)) {
-      return eval_index_expression(index_expr, env);
-    } else if (auto int_lit = dynamic_cast<IntegerLiteral*>(node)) {
-      return eval_integer_literal(int_lit, env);
-    } else if (auto bool_lit = dynamic_cast<BooleanLiteral*>(node)) {
-      return eval_boolean_literal(bool_lit, env); 
-    } else if (auto str_lit = dynamic_cast<StringLiteral*>(node)) {
-      return eval_string_literal(str_lit, env); 
-    } else if (auto arr_lit = dynamic_cast<ArrayLiteral*>(node)) {
-      return eval_array_literal(arr_lit, env); 
-    } else if (auto func_lit = dynamic_cast<FunctionLiteral*>(node)) {
-      return eval_function_literal(func_lit, env);
+  Callable Evaluator::lookup_function(std::string const& name) {
+    auto obj = _env->get(name);
+    if (obj->type() == Object::function_object_t || obj->type() == Object::builtin_object_t) {
+      return Callable(this, std::move(obj));
+    }
+    if (!is_null(obj.get())) {
+      return Callable();
+    }
+    if (auto it = _functions.find(name); it != _functions.end()) {
+      return Callable(this, it->second);
+    }
+    if (auto it = builtin_func_map.find(name); it != builtin_func_map.end()) {
+      return Callable(this, it->second);
+    }
+    return Callable();
+  }
+
+  std::shared_ptr<Object> Evaluator::call(std::shared_ptr<Object> const& function, Args args) {
+    CallStack::Activation active(_calls);
+    Counters::Activation counting(_counters);
+    std::shared_ptr<Object> res;
+    if (function->type() == Object::builtin_object_t) {
+      if constexpr (stats_enabled) {
+	++_counters.builtin_calls[function];
+      }
+      res = function->cast<Builtin>()->run(args);
+    } else if (function->type() == Object::function_object_t) {
+      res = eval_apply_function(function->cast<Function>(), args);
     } else {
-      return nullptr;
+      return std::make_shared<Error>("not a function");
+    }
+    safepoint();
+    return res;
+  }
+
+  std::shared_ptr<Object> Evaluator::run(std::shared_ptr<Program> const& program) {
+    CallStack::Activation active(_calls);
+    Counters::Activation counting(_counters);
+    CallStack::Scope frame(_calls, nullptr, 0);
+    auto outer = std::exchange(_program, &program);
+    auto res = eval(program.get(), _env.get());
+    _program = outer;
+    safepoint();
+    return res;
+  }
+
+  void Evaluator::def(std::string const& name, BuiltinFunction fn, int arity) {
+    _functions[name] = std::make_shared<Builtin>(fn, name, arity);
+  }
+
+  void Evaluator::set_gc_mode(Collector::Mode mode) {
+    if (auto collector = Collector::local()) {
+      collector->set_mode(mode);
+    }
+  }
+
+  void Evaluator::set_gc_pause_budget(std::chrono::microseconds budget) {
+    if (auto collector = Collector::local()) {
+      collector->set_pause_budget(budget);
     }
   }
 
+  void Evaluator::collect_garbage() {
+    if (auto collector = Collector::local()) {
+      collector->collect();
+    }
+  }
+
+  EvaluatorStats Evaluator::stats() const {
+    EvaluatorStats stats;
+    if (auto collector = Collector::local()) {
+      stats.gc = collector->stats();
+    }
+    stats.ast = AstNode::stats();
+    stats.counters = _counters;
+    return stats;
+  }
+
+  void Evaluator::set_profile(type_feedback::Profile* profile) {
+    _profile = profile;
+  }
+
+  void Evaluator::set_inference(type_inference::Report* report) {
+    _inference = report;
+  }
+
+  void Evaluator::safepoint() {
+    if (heap_profiler::take_dump_request()) {
+      heap_profiler::write_report(std::cerr);
+    }
+    auto collector = Collector::local();
+    if (collector && collector->has_pending()) {
+      collector->step();
+    }
+  }
+
+  std::shared_ptr<Object> Evaluator::eval(AstNode* node, Environment* env) {
+    auto kind = node->kind();
+    if constexpr (stats_enabled) {
+      ++_counters.nodes[static_cast<std::size_t>(kind)];
+    }
+    heap_profiler::Site site(node, _calls);
+    switch (kind) {
+    case NodeKind::program:
+      return eval_program(static_cast<Program*>(node), env);
+    case NodeKind::let_statement:
+      return eval_let_statement(static_cast<LetStatement*>(node), env);
+    case NodeKind::return_statement:
+      return eval_return_statement(static_cast<ReturnStatement*>(node), env);
+    case NodeKind::expression_statement:
+      return eval_expression_statement(static_cast<ExpressionStatement*>(node), env);
+    case NodeKind::prefix_expression:
+      return eval_prefix_expression(static_cast<PrefixExpression*>(node), env);
+    case NodeKind::infix_expression:
+      return eval_infix_expression(static_cast<InfixExpression*>(node), env);
+    case NodeKind::if_expression:
+      return eval_if_expression(static_cast<IfExpression*>(node), env);
+    case NodeKind::identifier:
+      return eval_identifier(static_cast<Identifier*>(node), env);
+    case NodeKind::block_statement:
+      return eval_block_statement(static_cast<BlockStatement*>(node), env);
+    case NodeKind::call_expression:
+      return eval_call_expression(static_cast<CallExpression*>(node), env);
+    case NodeKind::index_expression:
+      return eval_index_expression(static_cast<IndexExpression*>(node), env);
+    case NodeKind::integer_literal:
+      return eval_integer_literal(static_cast<IntegerLiteral*>(node), env);
+    case NodeKind::boolean_literal:
+      return eval_boolean_literal(static_cast<BooleanLiteral*>(node), env);
+    case NodeKind::string_literal:
+      return eval_string_literal(static_cast<StringLiteral*>(node), env);
+    case NodeKind::array_literal:
+      return eval_array_literal(static_cast<ArrayLiteral*>(node), env);
+    case NodeKind::hash_literal:
+      return eval_hash_literal(static_cast<HashLiteral*>(node), env);
+    case NodeKind::function_literal:
+      return eval_function_literal(static_cast<FunctionLiteral*>(node), env);
+    }
+    return nullptr;
+  }
+
   std::shared_ptr<Object> Evaluator::eval_program(Program* program, Environment* env) {
     std::shared_ptr<Object> ret = std::make_shared<Null>();
     
     auto& stmts = program->statements();
     for (auto& stmt : stmts) {
+      _calls.set_line(stmt->line());
       auto obj = eval(stmt.get(), env);
 
       if (obj->type() == Object::return_object_t) {
@@ -69,6 +336,7 @@ namespace Void {
       }
 
       ret.swap(obj);
+      safepoint();
     }
 
     return ret;
@@ -79,7 +347,7 @@ namespace Void {
     if (is_error(obj.get())) {
       return obj;
     }
-    env->set(node->identier()->value(), std::move(obj));
+    env->set(node->identier()->value(), node->identier()->bit(), std::move(obj));
     return null_obj;
   }
 
@@ -99,7 +367,7 @@ namespace Void {
     auto obj = eval(node->right(), env); 
     if (node->op() == "!") {
       return eval_bang_operator_expression(obj.get());
-    } else if (node->op() == "=") {
+    } else if (node->op() == "-") {
       return eval_minus_operator_expression(obj.get());
     } else {
       return std::make_shared<Error>();
@@ -109,16 +377,35 @@ namespace Void {
   std::shared_ptr<Object> Evaluator::eval_infix_expression(InfixExpression* node, Environment* env) {
     auto left = eval(node->left(), env);
     auto right = eval(node->right(), env);
+    // a site that has only seen Integers skips the feedback and the checks below
+    if (node->quick() == Quick::int_int) {
+      if (left->type() == Object::integer_object_t && right->type() == Object::integer_object_t) {
+	return eval_integer_infix_expression(node->infix_op(), left->cast<Integer>(), right->cast<Integer>());
+      }
+      node->set_quick(Quick::generic);
+    }
+    auto& feedback = node->feedback();
+    feedback.record(left->type(), right->type());
+    if (node->quick() == Quick::none && feedback.count >= type_feedback::warm_up) {
+      constexpr auto integer = 1u << Object::integer_object_t;
+      node->set_quick(feedback.left == integer && feedback.right == integer ? Quick::int_int : Quick::generic);
+    }
+
     auto op = node->op();
     if (left->type() == Object::integer_object_t &&
 	right->type() == Object::integer_object_t) {
-      return eval_integer_infix_expression(op, left->cast<Integer>(), right->cast<Integer>());
+      return eval_integer_infix_expression(node->infix_op(), left->cast<Integer>(), right->cast<Integer>());
+    } else if (is_integer(left.get()) && is_integer(right.get())) {
+      return eval_big_integer_infix_expression(op, to_big_int(left.get()), to_big_int(right.get()));
     } else if (left->type() == Object::string_object_t &&
 	       right->type() == Object::string_object_t) {
-      return eval_string_infix_expression(op, left->cast<String>(), right->cast<String>()); 
+      return eval_string_infix_expression(op, std::static_pointer_cast<String>(left), std::static_pointer_cast<String>(right)); 
     } else if (left->type() == Object::array_object_t &&
 	       right->type() == Object::array_object_t) {
       return eval_array_infix_expression(op, left->cast<Array>(), right->cast<Array>());
+    } else if (left->type() == Object::int_array_object_t ||
+	       right->type() == Object::int_array_object_t) {
+      return eval_int_array_infix_expression(op, left.get(), right.get());
     } else if (left->type() != right->type()) {
       return std::make_shared<Error>();
     } else if (op == "==") {
@@ -132,27 +419,79 @@ namespace Void {
 
   std::shared_ptr<Object> Evaluator::eval_if_expression(IfExpression* node, Environment* env) {
     auto cond = eval(node->condition(), env);
+    // the singletons are the only Booleans, a pointer compare tells the
+    // branch; its bias is still counted
+    if (node->quick() == Quick::bool_cond) {
+      if (cond == true_obj) {
+	node->feedback().record(true);
+	return eval(node->consequence(), env);
+      } else if (cond == false_obj) {
+	node->feedback().record(false);
+	return node->alternative() ? eval(node->alternative(), env) : null_obj;
+      }
+      node->set_quick(Quick::generic);
+    }
 
     if (is_error(cond.get())) {
       return cond;
     }
     
-    if (is_truthy(cond.get())) {
+    auto truthy = is_truthy(cond.get());
+    auto& feedback = node->feedback();
+    feedback.record(truthy);
+    if (node->quick() == Quick::none) {
+      if (cond->type() != Object::boolean_object_t) {
+	node->set_quick(Quick::generic);
+      } else if (feedback.taken + std::uint64_t{feedback.not_taken} >= type_feedback::warm_up) {
+	node->set_quick(Quick::bool_cond);
+      }
+    }
+    if (truthy) {
       return eval(node->consequence(), env); 
-    } else {
+    } else if (node->alternative()) {
       return eval(node->alternative(), env);
+    } else {
+      return null_obj;
     }
   }
 
   std::shared_ptr<Object> Evaluator::eval_identifier(Identifier* node, Environment* env) {
-    auto obj = env->get(node->value());
-    if (is_null(obj.get())) {
-      auto it = builtin_func_map.find(node->value());
-      if (it != builtin_func_map.end()) {
-	return it->second;
+    // The scope the name was found in last time, reached by the same
+    // number of hops and with no nearer scope that may bind the name.
+    // Scopes made per call differ every time, reads of parameters and
+    // locals miss until the node gives up.
+    if (node->quick() == Quick::slot) {
+      auto& cache = node->slot_cache();
+      auto scope = scope_out(env, node->bit(), cache.hops);
+      if (scope && scope->id() == cache.env && !is_null(cache.slot->get())) {
+	count_env_get(cache.hops);
+	return *cache.slot;
       }
+      if (++cache.misses == max_slot_misses) {
+	node->set_quick(Quick::generic);
+      }
+    }
+
+    auto binding = env->lookup(node->value());
+    if (binding.slot && !is_null(binding.slot->get())) {
+      if (node->quick() != Quick::generic) {
+	auto& cache = node->slot_cache();
+	cache.hops = binding.hops;
+	cache.env = binding.scope->id();
+	cache.slot = binding.slot;
+	node->set_quick(Quick::slot);
+      }
+      return *binding.slot;
+    }
+    // a name bound to null still finds a builtin of that name
+    if (auto it = _functions.find(node->value()); it != _functions.end()) {
+      return it->second;
     }
-    return obj;
+    auto it = builtin_func_map.find(node->value());
+    if (it != builtin_func_map.end()) {
+      return it->second;
+    }
+    return null_obj;
   }
 
   std::shared_ptr<Object> Evaluator::eval_block_statement(BlockStatement* node, Environment* env) {
@@ -160,11 +499,12 @@ namespace Void {
 
     auto& stmts = node->statements();
     for (auto& stmt : stmts) {
+      _calls.set_line(stmt->line());
       auto obj = eval(stmt.get(), env);
 
-      if (obj->type() == Object::return_object_t) {
-	return obj->cast<Return>()->value(); 
-      } else if (obj->type() == Object::error_object_t) {
+      // a return unwinds enclosing blocks up to the function or program
+      if (obj->type() == Object::return_object_t ||
+	  obj->type() == Object::error_object_t) {
 	return obj;
       }
 
@@ -175,45 +515,76 @@ namespace Void {
   }
 
   std::shared_ptr<Object> Evaluator::eval_call_expression(CallExpression* node, Environment* env) {
-    auto func_obj = eval(node->function(), env);
-    if (func_obj->type() != Object::function_object_t &&
-	func_obj->type() != Object::builtin_object_t) {
-      if (func_obj->type() == Object::error_object_t) {
-	return func_obj;
-      } else { 
-	return std::make_shared<Error>();
+    // A callee whose binding still holds a target the site cached was
+    // resolved, type and arity checked and recorded when it was added.
+    auto& cache = node->cache();
+    auto callee = node->function()->kind() == NodeKind::identifier ? static_cast<Identifier*>(node->function()) : nullptr;
+    auto hit = callee && cache.size ? find_call_target(cache, callee->bit(), env) : nullptr;
+    auto& feedback = node->feedback();
+    std::shared_ptr<Object> func_obj;
+    if (hit) {
+      func_obj = *hit->slot;
+      cache.hits += cache.hits != UINT32_MAX;
+    } else {
+      func_obj = eval(node->function(), env);
+      if (func_obj->type() != Object::function_object_t &&
+	  func_obj->type() != Object::builtin_object_t) {
+	if (func_obj->type() == Object::error_object_t) {
+	  return func_obj;
+	} else { 
+	  return std::make_shared<Error>();
+	}
       }
-    }
-
 
-    std::vector<std::shared_ptr<Object>> args_obj;
-    auto& args_expr = node->arguments();
-    for (auto& expr : args_expr) {
-      args_obj.emplace_back(eval(expr.get(), env)); 
+      auto target = func_obj->type() == Object::builtin_object_t ? static_cast<void const*>(func_obj.get())
+								 : func_obj->cast<Function>()->function();
+      if (target != feedback.target && !feedback.polymorphic) {
+	record_call_target(feedback, func_obj.get(), target);
+      }
+      if (callee && !cache.megamorphic) {
+	add_call_target(cache, callee, func_obj, node->arguments().size(), env);
+      }
     }
+    feedback.count += feedback.count != UINT32_MAX;
 
-    
-    if (func_obj->type() == Object::builtin_object_t) {
-      return func_obj->cast<Builtin>()->run(args_obj); 
+    // arguments live on the evaluator's stack, a call allocates no vector
+    auto& args_expr = node->arguments();
+    ArgStack::Frame args_obj(_stack, args_expr.size());
+    for (std::size_t i = 0; i < args_expr.size(); ++i) {
+      args_obj[i] = eval(args_expr[i].get(), env);
+      if (is_error(args_obj[i].get())) {
+	return args_obj[i];
+      }
     }
     
-    auto func_expr = func_obj->cast<Function>()->function();
-    auto& params_expr = func_expr->parameters();
-    if (args_expr.size() != params_expr.size()) {
-      return std::make_shared<Error>();
-    }
-    for (std::size_t i = 0; i < args_expr.size(); ++i) {
-      auto& param = params_expr[i];
-      
-      func_obj->cast<Function>()->env()->set(param->value(), args_obj[i]);
+    Args args(args_obj.data(), args_obj.size());
+    if (hit ? !hit->function : func_obj->type() == Object::builtin_object_t) {
+      if constexpr (stats_enabled) {
+	++_counters.builtin_calls[func_obj];
+      }
+      return func_obj->cast<Builtin>()->run(args); 
     }
     
-    return eval_apply_function(func_obj->cast<Function>(), func_obj->cast<Function>()->env());
+    auto func = func_obj->cast<Function>();
+    auto res = hit ? eval_apply_checked_function(func, args) : eval_apply_function(func, args);
+    safepoint();
+    return res;
   }
 
   std::shared_ptr<Object> Evaluator::eval_index_expression(IndexExpression* node, Environment* env) {
     auto arr = eval(node->array(), env);
-    if (arr->type() != Object::array_object_t) {
+    if (arr->type() == Object::hash_object_t) {
+      auto key = eval(node->index(), env);
+      if (is_error(key.get())) {
+	return key;
+      }
+      if (!HashTable::hashable(key.get())) {
+	return std::make_shared<Error>();
+      }
+      auto value = arr->cast<Hash>()->get(key.get());
+      return value ? value : null_obj;
+    } else if (arr->type() != Object::array_object_t &&
+	       arr->type() != Object::int_array_object_t) {
       return std::make_shared<Error>();
     }
 
@@ -222,19 +593,45 @@ namespace Void {
       return std::make_shared<Error>();
     }
 
-    return arr->cast<Array>()->elements()[index->cast<Integer>()->value()];
+    if (arr->type() == Object::int_array_object_t) {
+      auto& values = arr->cast<IntArray>()->values();
+      auto i = index->cast<Integer>()->value();
+      if (i < 0 || static_cast<std::size_t>(i) >= values.size()) {
+	return null_obj;
+      }
+      return Integer::make(values[i]);
+    }
+
+    auto& elems = arr->cast<Array>()->elements();
+    auto i = index->cast<Integer>()->value();
+    if (i < 0 || static_cast<std::size_t>(i) >= elems.size()) {
+      return null_obj;
+    }
+    return elems[i];
   }
   
   std::shared_ptr<Object> Evaluator::eval_integer_literal(IntegerLiteral* node, Environment* env) {
-    return std::make_shared<Integer>(node->value()); 
+    if (node->object() == nullptr) {
+      if (node->is_big()) {
+	BigInt value;
+	BigInt::parse(node->token_literal(), value);
+	node->set_object(BigInteger::make(std::move(value)));
+      } else {
+	node->set_object(std::make_shared<Integer>(node->value()));
+      }
+    }
+    return node->object(); 
   }
 
   std::shared_ptr<Object> Evaluator::eval_boolean_literal(BooleanLiteral* node, Environment* env) {
-    return std::make_shared<Boolean>(node->value()); 
+    return native_bool_to_boolean(node->value()); 
   }
 
   std::shared_ptr<Object> Evaluator::eval_string_literal(StringLiteral* node, Environment* env) {
-    return std::make_shared<String>(node->value()); 
+    if (node->object() == nullptr) {
+      node->set_object(String::intern(node->value()));
+    }
+    return node->object(); 
   }
 
   std::shared_ptr<Object> Evaluator::eval_array_literal(ArrayLiteral* node, Environment* env) {
@@ -252,8 +649,39 @@ namespace Void {
     return array;
   }
 
+  std::shared_ptr<Object> Evaluator::eval_hash_literal(HashLiteral* node, Environment* env) {
+    auto hash = std::make_shared<Hash>();
+
+    for (auto& [key_expr, value_expr] : node->pairs()) {
+      auto key = eval(key_expr.get(), env);
+      if (is_error(key.get())) {
+	return key;
+      }
+      if (!HashTable::hashable(key.get())) {
+	return std::make_shared<Error>();
+      }
+
+      auto value = eval(value_expr.get(), env);
+      if (is_error(value.get())) {
+	return value;
+      }
+      hash->set(std::move(key), std::move(value));
+    }
+
+    return hash;
+  }
+
   std::shared_ptr<Object> Evaluator::eval_function_literal(FunctionLiteral* node, Environment* env) {
-    return std::make_shared<Function>(node, env);
+    auto scope = env->shared_from_this();
+    if (_captured.empty() || _captured.back().lock() != scope) {
+      if (_captured.size() == _captured.capacity()) {
+	_captured.erase(std::remove_if(_captured.begin(), _captured.end(),
+				       [](auto& weak) { return weak.expired(); }),
+			_captured.end());
+      }
+      _captured.push_back(scope);
+    }
+    return std::make_shared<Function>(node, *_program, std::move(scope));
   }
 
   std::shared_ptr<Object> Evaluator::eval_bang_operator_expression(Object* obj) {
@@ -262,53 +690,113 @@ namespace Void {
 
   std::shared_ptr<Object> Evaluator::eval_minus_operator_expression(Object* obj) {
     if (auto int_obj = dynamic_cast<Integer*>(obj)) {
-      return std::make_shared<Integer>(-int_obj->value()); 
+      if (int_obj->value() == INT64_MIN) {
+	return BigInteger::make(-BigInt(int_obj->value()));
+      }
+      return Integer::make(-int_obj->value()); 
+    } else if (auto big_obj = dynamic_cast<BigInteger*>(obj)) {
+      return BigInteger::make(-big_obj->value());
     } else {
       return std::make_shared<Error>();
     }
   }
 
-  std::shared_ptr<Object> Evaluator::eval_integer_infix_expression(std::string const& op, Integer* left, Integer* right) {
+  std::shared_ptr<Object> Evaluator::eval_integer_infix_expression(InfixOp op, Integer* left, Integer* right) {
+    auto lhs = left->value(), rhs = right->value();
+    std::int64_t res;
+    // on overflow fall back to the arbitrary precision path
+    switch (op) {
+    case InfixOp::add:
+      if (__builtin_add_overflow(lhs, rhs, &res)) {
+	return BigInteger::make(BigInt(lhs) + BigInt(rhs));
+      }
+      return Integer::make(res); 
+    case InfixOp::sub:
+      if (__builtin_sub_overflow(lhs, rhs, &res)) {
+	return BigInteger::make(BigInt(lhs) - BigInt(rhs));
+      }
+      return Integer::make(res);
+    case InfixOp::mul:
+      if (__builtin_mul_overflow(lhs, rhs, &res)) {
+	return BigInteger::make(BigInt(lhs) * BigInt(rhs));
+      }
+      return Integer::make(res); 
+    case InfixOp::div:
+      if (rhs == 0) {
+	return std::make_shared<Error>("division by zero");
+      }
+      if (lhs == INT64_MIN && rhs == -1) {
+	return BigInteger::make(-BigInt(lhs));
+      }
+      return Integer::make(lhs / rhs); 
+    case InfixOp::lt:
+      return native_bool_to_boolean(lhs < rhs); 
+    case InfixOp::le:
+      return native_bool_to_boolean(lhs <= rhs); 
+    case InfixOp::gt:
+      return native_bool_to_boolean(lhs > rhs); 
+    case InfixOp::ge:
+      return native_bool_to_boolean(lhs >= rhs); 
+    case InfixOp::eq:
+      return native_bool_to_boolean(lhs == rhs); 
+    case InfixOp::ne:
+      return native_bool_to_boolean(lhs != rhs);
+    case InfixOp::other:
+      break;
+    }
+    return std::make_shared<Error>();
+  }
+
+  std::shared_ptr<Object> Evaluator::eval_big_integer_infix_expression(std::string const& op, BigInt const& left, BigInt const& right) {
     if (op == "+") {
-      return std::make_shared<Integer>(left->value() + right->value()); 
+      return BigInteger::make(left + right); 
     } else if (op == "-") {
-      return std::make_shared<Integer>(left->value() - right->value());
+      return BigInteger::make(left - right);
     } else if (op == "*") {
-      return std::make_shared<Integer>(left->value() * right->value()); 
+      return BigInteger::make(left * right); 
     } else if (op == "/") {
-      return std::make_shared<Integer>(left->value() / right->value()); 
+      if (right.is_zero()) {
+	return std::make_shared<Error>("division by zero");
+      }
+      return BigInteger::make(left / right); 
     } else if (op == "<") {
-      return std::make_shared<Boolean>(left->value() < right->value()); 
+      return native_bool_to_boolean(left < right); 
     } else if (op == "<=") {
-      return std::make_shared<Boolean>(left->value() <= right->value()); 
+      return native_bool_to_boolean(left <= right); 
     } else if (op == ">") {
-      return std::make_shared<Boolean>(left->value() > right->value()); 
+      return native_bool_to_boolean(left > right); 
     } else if (op == ">=") {
-      return std::make_shared<Boolean>(left->value() >= right->value()); 
+      return native_bool_to_boolean(left >= right); 
     } else if (op == "==") {
-      return std::make_shared<Boolean>(left->value() == right->value()); 
+      return native_bool_to_boolean(left == right); 
     } else if (op == "!=") {
-      return std::make_shared<Boolean>(left->value() != right->value());
+      return native_bool_to_boolean(left != right);
     } else {
       return std::make_shared<Error>();
     }
   }
 
-  std::shared_ptr<Object> Evaluator::eval_string_infix_expression(std::string const& op, String* left, String* right) {
+  std::shared_ptr<Object> Evaluator::eval_string_infix_expression(std::string const& op, std::shared_ptr<String> const& left, std::shared_ptr<String> const& right) {
     if (op == "+") {
-      return std::make_shared<String>(left->value() + right->value()); 
+      return String::concat(left, right); 
     } else if (op == "<") {
-      return std::make_shared<Boolean>(left->value() < right->value()); 
+      return native_bool_to_boolean(left->value() < right->value()); 
     } else if (op == "<=") {
-      return std::make_shared<Boolean>(left->value() <= right->value()); 
+      return native_bool_to_boolean(left->value() <= right->value()); 
     } else if (op == ">") {
-      return std::make_shared<Boolean>(left->value() > right->value()); 
+      return native_bool_to_boolean(left->value() > right->value()); 
     } else if (op == ">=") {
-      return std::make_shared<Boolean>(left->value() >= right->value()); 
+      return native_bool_to_boolean(left->value() >= right->value()); 
     } else if (op == "==") {
-      return std::make_shared<Boolean>(left->value() == right->value()); 
+      if (left->interned() && right->interned()) {
+	return native_bool_to_boolean(left == right);
+      }
+      return native_bool_to_boolean(left->value() == right->value()); 
     } else if (op == "!=") {
-      return std::make_shared<Boolean>(left->value() != right->value());
+      if (left->interned() && right->interned()) {
+	return native_bool_to_boolean(left != right);
+      }
+      return native_bool_to_boolean(left->value() != right->value());
     } else {
       return std::make_shared<Error>();
     }
@@ -316,24 +804,122 @@ namespace Void {
 
   std::shared_ptr<Object> Evaluator::eval_array_infix_expression(std::string const& op, Array* left, Array* right) {
     if (op == "+") {
-      auto arr = std::make_shared<Array>();
-      for (auto& elem : left->elements()) {
-	arr->append(elem);
+      return std::make_shared<Array>(left->elements().concat(right->elements()));
+    } else {
+      return std::make_shared<Null>();
+    }
+  }
+
+  std::shared_ptr<Object> Evaluator::eval_int_array_infix_expression(std::string const& op, Object* left, Object* right) {
+    // an IntArray with an IntArray of the same size, or with an Integer on either side
+    auto larr = left->cast<IntArray>(), rarr = right->cast<IntArray>();
+    if (larr && rarr) {
+      if (op == "==" || op == "!=") {
+	return native_bool_to_boolean((larr->values() == rarr->values()) == (op == "=="));
       }
-      for (auto& elem : right->elements()) {
-	arr->append(elem); 
+      if (larr->values().size() != rarr->values().size()) {
+	return std::make_shared<Error>();
+      }
+    } else if (!larr && left->type() != Object::integer_object_t) {
+      return std::make_shared<Error>();
+    } else if (!rarr && right->type() != Object::integer_object_t) {
+      return std::make_shared<Error>();
+    }
+
+    auto& values = (larr ? larr : rarr)->values();
+    auto n = values.size();
+    IntArray::Values res(n);
+    bool ok;
+    if (larr && rarr) {
+      auto a = larr->values().data(), b = rarr->values().data();
+      if (op == "+") {
+	ok = simd::add(a, b, res.data(), n);
+      } else if (op == "-") {
+	ok = simd::sub(a, b, res.data(), n);
+      } else if (op == "*") {
+	ok = simd::mul(a, b, res.data(), n);
+      } else {
+	return std::make_shared<Error>();
       }
-      return arr;
     } else {
-      return std::make_shared<Null>();
+      auto a = values.data();
+      auto s = (larr ? right : left)->cast<Integer>()->value();
+      if (op == "+") {
+	ok = simd::add_scalar(a, s, res.data(), n);
+      } else if (op == "-") {
+	ok = larr ? simd::sub_scalar(a, s, res.data(), n) : simd::rsub_scalar(a, s, res.data(), n);
+      } else if (op == "*") {
+	ok = simd::mul_scalar(a, s, res.data(), n);
+      } else {
+	return std::make_shared<Error>();
+      }
+    }
+    if (ok) {
+      return std::make_shared<IntArray>(std::move(res));
+    }
+
+    // some element overflowed, the result is a plain Array holding BigIntegers
+    auto arr = std::make_shared<Array>();
+    for (std::size_t i = 0; i < n; ++i) {
+      auto lhs = larr ? BigInt(larr->values()[i]) : to_big_int(left);
+      auto rhs = rarr ? BigInt(rarr->values()[i]) : to_big_int(right);
+      arr->append(eval_big_integer_infix_expression(op, lhs, rhs));
     }
+    return arr;
   }
 
-  std::shared_ptr<Object> Evaluator::eval_apply_function(Function* func, Environment* env) {
-    auto stmt = func->function()->body();
-    return eval(stmt, env);
+  std::shared_ptr<Object> Evaluator::eval_apply_function(Function* func, Args args) {
+    if (args.size() != func->function()->parameters().size()) {
+      return std::make_shared<Error>("wrong number of arguments");
+    }
+    return eval_apply_checked_function(func, args);
+  }
+
+  std::shared_ptr<Object> Evaluator::eval_apply_checked_function(Function* func, Args args) {
+    // a fresh scope per call, closures created by the body may outlive it
+    auto env = std::make_shared<Environment>(func->env());
+    env->bind(*func->function(), args);
+
+    CallStack::Scope frame(_calls, func->function(), func->function()->line());
+    tracer::Span span(func->function());
+    perf_counters::Scope counted(func->function());
+    auto outer = std::exchange(_program, &func->program());
+    if constexpr (stats_enabled) {
+      ++_counters.function_calls;
+      _counters.max_depth = std::max(_counters.max_depth, ++_counters.depth);
+    }
+    auto res = eval(func->function()->body(), env.get());
+    if constexpr (stats_enabled) {
+      --_counters.depth;
+    }
+    _program = outer;
+    // a closure bound in the scope and not escaping would keep both alive
+    // until the evaluator dies
+    if (closed_cycle(env)) {
+      env->clear();
+    }
+    if (res->type() == Object::return_object_t) {
+      return res->cast<Return>()->value();
+    }
+    return res;
   }
   
+  void Evaluator::record_call_target(CallFeedback& feedback, Object* function, void const* target) {
+    auto name = function->type() == Object::builtin_object_t ? function->cast<Builtin>()->name()
+							       : profiler::frame_name(function->cast<Function>()->function());
+    // a site seeded from a profile knows the name of its target, not its address
+    if (!feedback.target && (feedback.name.empty() || feedback.name == name)) {
+      feedback.target = target;
+      feedback.name = std::move(name);
+    } else {
+      feedback.polymorphic = true;
+    }
+  }
+
+  std::shared_ptr<Object> Evaluator::native_bool_to_boolean(bool value) {
+    return value ? true_obj : false_obj;
+  }
+
   bool Evaluator::is_truthy(Object* obj) {
     if (obj == false_obj.get() || obj == null_obj.get()) {
       return false; 
@@ -341,6 +927,17 @@ namespace Void {
     return true;
   }
 
+  bool Evaluator::is_integer(Object* obj) {
+    return obj->type() == Object::integer_object_t || obj->type() == Object::big_integer_object_t;
+  }
+
+  BigInt Evaluator::to_big_int(Object* obj) {
+    if (obj->type() == Object::integer_object_t) {
+      return BigInt(obj->cast<Integer>()->value());
+    }
+    return obj->cast<BigInteger>()->value();
+  }
+
   bool Evaluator::is_error(Object* obj) {
     return obj->type() == Object::error_object_t;
   }
@@ -0,0 +1,107 @@
+#include <void/gc.hpp>
+#include <void/object.hpp>
+
+namespace Void {
+  namespace {
+    thread_local bool shutting_down = false;
+  }
+
+  Collector* Collector::local() {
+    static thread_local Collector collector;
+    return shutting_down ? nullptr : &collector;
+  }
+
+  Collector::~Collector() {
+    _mode = immediate_mode;
+    collect();
+    shutting_down = true;
+  }
+
+  Collector::Mode Collector::mode() const {
+    return _mode;
+  }
+
+  void Collector::set_mode(Mode mode) {
+    _mode = mode;
+    if (_mode == immediate_mode) {
+      collect();
+    }
+  }
+
+  std::chrono::microseconds Collector::pause_budget() const {
+    return _pause_budget;
+  }
+
+  void Collector::set_pause_budget(std::chrono::microseconds budget) {
+    _pause_budget = budget;
+  }
+
+  void Collector::defer(Chunk& chunk) {
+    if (_mode == immediate_mode && !_draining) {
+      return;
+    }
+    if (chunk.empty()) {
+      return;
+    }
+    _stats.pending += chunk.size();
+    _pending.emplace_back(std::move(chunk));
+  }
+
+  void Collector::step() {
+    if (_pending.empty() || _draining) {
+      return;
+    }
+    drain(std::chrono::steady_clock::now() + _pause_budget, true);
+  }
+
+  void Collector::collect() {
+    if (_pending.empty() || _draining) {
+      return;
+    }
+    drain(std::chrono::steady_clock::time_point::max(), false);
+  }
+
+  GcStats const& Collector::stats() const {
+    return _stats;
+  }
+
+  void Collector::drain(std::chrono::steady_clock::time_point deadline, bool bounded) {
+    // checking the clock is not free, only look at it every few releases
+    static constexpr std::uint64_t check_interval = 64;
+
+    auto start = std::chrono::steady_clock::now();
+    _draining = true;
+
+    std::uint64_t released = 0;
+    while (!_pending.empty()) {
+      auto& chunk = _pending.back();
+      if (chunk.empty()) {
+	_pending.pop_back();
+	continue;
+      }
+
+      // releasing may push new chunks, so take the reference out first
+      auto obj = std::move(chunk.back());
+      chunk.pop_back();
+      obj.reset();
+      ++released;
+
+      if (bounded && released % check_interval == 0 &&
+	  std::chrono::steady_clock::now() >= deadline) {
+	break;
+      }
+    }
+
+    _draining = false;
+
+    auto end = std::chrono::steady_clock::now();
+    _stats.pause_ns.record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    ++_stats.slices;
+    _stats.reclaimed += released;
+    _stats.pending -= std::min(_stats.pending, released);
+    if (_pending.empty()) {
+      _stats.pending = 0;
+      ++_stats.collections;
+    }
+  }
+}
@@ -0,0 +1,221 @@
+#include <void/hash_table.hpp>
+#include <void/object.hpp>
+
+#include <functional>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Void {
+  namespace {
+    std::uint64_t mix(std::uint64_t x) {
+      // splitmix64 finalizer
+      x ^= x >> 30;
+      x *= 0xbf58476d1ce4e5b9ULL;
+      x ^= x >> 27;
+      x *= 0x94d049bb133111ebULL;
+      x ^= x >> 31;
+      return x;
+    }
+
+    // bit i is set when ctrl[i] == value
+    std::uint32_t match(std::int8_t const* ctrl, std::int8_t value) {
+#if defined(__SSE2__)
+      auto group = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ctrl));
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+      std::uint32_t res = 0;
+      for (int i = 0; i < 16; ++i) {
+	res |= static_cast<std::uint32_t>(ctrl[i] == value) << i;
+      }
+      return res;
+#endif
+    }
+  }
+
+  bool HashTable::hashable(Object const* obj) {
+    switch (obj->type()) {
+    case Object::integer_object_t:
+    case Object::big_integer_object_t:
+    case Object::boolean_object_t:
+    case Object::string_object_t:
+      return true;
+    case Object::array_object_t:
+      for (auto& elem : obj->cast<Array>()->elements()) {
+	if (!hashable(elem.get())) {
+	  return false;
+	}
+      }
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  std::uint64_t HashTable::hash(Object const* obj) {
+    switch (obj->type()) {
+    case Object::integer_object_t:
+      return obj->cast<Integer>()->hash();
+    case Object::big_integer_object_t:
+      return mix(obj->cast<BigInteger>()->hash());
+    case Object::boolean_object_t:
+      return mix(obj->cast<Boolean>()->value() ? 0x9e3779b97f4a7c15ULL : 0x7f4a7c159e3779b9ULL);
+    case Object::string_object_t:
+      return obj->cast<String>()->hash();
+    case Object::array_object_t: {
+      std::uint64_t res = mix(obj->cast<Array>()->elements().size());
+      for (auto& elem : obj->cast<Array>()->elements()) {
+	res = mix(res ^ hash(elem.get()));
+      }
+      return res;
+    }
+    default:
+      return 0;
+    }
+  }
+
+  bool HashTable::equal(Object const* left, Object const* right) {
+    if (left == right) {
+      return true;
+    }
+    if (left->type() != right->type()) {
+      return false;
+    }
+    switch (left->type()) {
+    case Object::integer_object_t:
+      return left->cast<Integer>()->value() == right->cast<Integer>()->value();
+    case Object::big_integer_object_t:
+      return left->cast<BigInteger>()->value() == right->cast<BigInteger>()->value();
+    case Object::boolean_object_t:
+      return left->cast<Boolean>()->value() == right->cast<Boolean>()->value();
+    case Object::string_object_t:
+      if (left->cast<String>()->interned() && right->cast<String>()->interned()) {
+	return false;
+      }
+      return left->cast<String>()->value() == right->cast<String>()->value();
+    case Object::array_object_t: {
+      auto& lhs = left->cast<Array>()->elements();
+      auto& rhs = right->cast<Array>()->elements();
+      if (lhs.size() != rhs.size()) {
+	return false;
+      }
+      for (std::size_t i = 0; i < lhs.size(); ++i) {
+	if (!equal(lhs[i].get(), rhs[i].get())) {
+	  return false;
+	}
+      }
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+
+  std::size_t HashTable::size() const {
+    return _entries.size();
+  }
+
+  bool HashTable::empty() const {
+    return _entries.empty();
+  }
+
+  std::vector<HashTable::Entry> const& HashTable::entries() const {
+    return _entries;
+  }
+
+  HashTable::Entry const* HashTable::find(Object const* key, std::uint64_t hash) const {
+    if (_slots.empty()) {
+      return nullptr;
+    }
+    bool found = false;
+    auto slot = probe(key, hash, found);
+    return found ? &_entries[_slots[slot]] : nullptr;
+  }
+
+  void HashTable::insert(std::shared_ptr<Object> key, std::shared_ptr<Object> value, std::uint64_t hash) {
+    if ((_entries.size() + 1) * 8 > _slots.size() * 7) {
+      rehash(_slots.empty() ? group_width : _slots.size() * 2);
+    }
+
+    bool found = false;
+    auto slot = probe(key.get(), hash, found);
+    if (found) {
+      _entries[_slots[slot]].value = std::move(value);
+      return;
+    }
+
+    set_ctrl(slot, h2(hash));
+    _slots[slot] = static_cast<std::uint32_t>(_entries.size());
+    _entries.push_back({hash, std::move(key), std::move(value)});
+  }
+
+  void HashTable::reserve(std::size_t count) {
+    std::size_t capacity = group_width;
+    while (count * 8 > capacity * 7) {
+      capacity *= 2;
+    }
+    if (capacity > _slots.size()) {
+      rehash(capacity);
+    }
+    _entries.reserve(count);
+  }
+
+  std::int8_t HashTable::h2(std::uint64_t hash) {
+    return static_cast<std::int8_t>(hash & 0x7f);
+  }
+
+  std::size_t HashTable::h1(std::uint64_t hash) const {
+    return (hash >> 7) & _mask;
+  }
+
+  std::size_t HashTable::probe(Object const* key, std::uint64_t hash, bool& found) const {
+    auto tag = h2(hash);
+    auto pos = h1(hash);
+    for (std::size_t step = group_width; ; step += group_width) {
+      auto ctrl = _ctrl.data() + pos;
+      for (auto bits = match(ctrl, tag); bits != 0; bits &= bits - 1) {
+	auto slot = (pos + __builtin_ctz(bits)) & _mask;
+	auto& entry = _entries[_slots[slot]];
+	if (entry.hash == hash && equal(entry.key.get(), key)) {
+	  found = true;
+	  return slot;
+	}
+      }
+      if (auto empties = match(ctrl, empty_ctrl); empties != 0) {
+	found = false;
+	return (pos + __builtin_ctz(empties)) & _mask;
+      }
+      // triangular probing visits every group once the table is a power of two
+      pos = (pos + step) & _mask;
+    }
+  }
+
+  void HashTable::set_ctrl(std::size_t slot, std::int8_t ctrl) {
+    _ctrl[slot] = ctrl;
+    if (slot < group_width - 1) {
+      _ctrl[_slots.size() + slot] = ctrl;
+    }
+  }
+
+  void HashTable::rehash(std::size_t capacity) {
+    _ctrl.assign(capacity + group_width - 1, empty_ctrl);
+    _slots.assign(capacity, 0);
+    _mask = capacity - 1;
+
+    // hashes are cached in the entries, keys are never hashed again
+    for (std::size_t i = 0; i < _entries.size(); ++i) {
+      auto pos = h1(_entries[i].hash);
+      for (std::size_t step = group_width; ; step += group_width) {
+	if (auto empties = match(_ctrl.data() + pos, empty_ctrl); empties != 0) {
+	  auto slot = (pos + __builtin_ctz(empties)) & _mask;
+	  set_ctrl(slot, h2(_entries[i].hash));
+	  _slots[slot] = static_cast<std::uint32_t>(i);
+	  break;
+	}
+	pos = (pos + step) & _mask;
+      }
+    }
+  }
+}
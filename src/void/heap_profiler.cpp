@@ -0,0 +1,240 @@
+#include <void/heap_profiler.hpp>
+#include <void/ast.hpp>
+#include <void/object.hpp>
+#include <void/profiler.hpp>
+
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+
+namespace Void {
+  namespace heap_profiler {
+    namespace detail {
+      std::atomic<bool> tracking{false};
+    }
+
+    namespace {
+      // the type alone decides it, a report never reads an object that
+      // another thread may be destroying
+      std::uint32_t object_size(Object::ObjectType type) {
+	switch (type) {
+	case Object::integer_object_t: return sizeof(Integer);
+	case Object::boolean_object_t: return sizeof(Boolean);
+	case Object::string_object_t: return sizeof(String);
+	case Object::error_object_t: return sizeof(Error);
+	case Object::null_object_t: return sizeof(Null);
+	case Object::return_object_t: return sizeof(Return);
+	case Object::function_object_t: return sizeof(Function);
+	case Object::array_object_t: return sizeof(Array);
+	case Object::builtin_object_t: return sizeof(Builtin);
+	case Object::hash_object_t: return sizeof(Hash);
+	case Object::big_integer_object_t: return sizeof(BigInteger);
+	case Object::int_array_object_t: return sizeof(IntArray);
+	}
+	return sizeof(Object);
+      }
+
+      struct Live {
+	std::uint64_t objects{};
+	std::uint64_t bytes{};
+
+	void add(std::uint32_t size) {
+	  ++objects;
+	  bytes += size;
+	}
+
+	void remove(std::uint32_t size) {
+	  --objects;
+	  bytes -= size;
+	}
+      };
+
+      struct Tracked {
+	std::uint32_t site;
+	std::uint32_t size;
+	Object::ObjectType type;
+      };
+
+      struct SiteRecord {
+	std::string name;
+	Live live;
+      };
+
+      thread_local AstNode const* current_node = nullptr;
+      thread_local FunctionLiteral const* current_function = nullptr;
+
+      std::mutex mutex;
+      std::unordered_map<Object const*, Tracked> objects;
+      // a record outlives its node, objects made there may still be alive,
+      // and is shared by every node with its name: each REPL line is a new
+      // program, so the same source site comes back under new nodes
+      std::unordered_map<AstNode const*, std::uint32_t> site_ids;
+      std::unordered_map<std::string, std::uint32_t> site_names;
+      std::vector<SiteRecord> sites;
+      std::array<Live, object_type_count> types;
+      std::atomic<bool> dump_requested{false};
+
+      int line_of(AstNode const* node) {
+	if (auto stmt = dynamic_cast<Statement const*>(node)) {
+	  return stmt->line();
+	}
+	if (auto expr = dynamic_cast<Expression const*>(node)) {
+	  return expr->line();
+	}
+	return 0;
+      }
+
+      // id 0 stands for objects made outside of any evaluation
+      std::uint32_t site_id() {
+	if (!current_node) {
+	  return 0;
+	}
+	auto it = site_ids.find(current_node);
+	if (it != site_ids.end()) {
+	  return it->second;
+	}
+	auto name = std::string(to_string(current_node->kind())) + " at line " + std::to_string(line_of(current_node)) +
+		    " in " + profiler::frame_name(current_function);
+	auto [named, inserted] = site_names.emplace(name, static_cast<std::uint32_t>(sites.size()));
+	if (inserted) {
+	  sites.push_back({std::move(name), {}});
+	}
+	site_ids.emplace(current_node, named->second);
+	return named->second;
+      }
+
+      void on_dump_signal(int) {
+	dump_requested.store(true, std::memory_order_relaxed);
+      }
+
+      std::vector<Entry> sorted(std::vector<Entry> entries) {
+	std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) {
+	  return a.bytes != b.bytes ? a.bytes > b.bytes : a.name < b.name;
+	});
+	return entries;
+      }
+    }
+
+    void start() {
+      std::lock_guard<std::mutex> lock(mutex);
+      detail::tracking.store(true);
+    }
+
+    void stop() {
+      std::lock_guard<std::mutex> lock(mutex);
+      detail::tracking.store(false);
+      objects.clear();
+      site_ids.clear();
+      site_names.clear();
+      sites.clear();
+      types = {};
+    }
+
+    void Site::enter(AstNode const* node, CallStack const& calls) {
+      _entered = true;
+      _outer_node = current_node;
+      _outer_function = current_function;
+      current_node = node;
+      auto depth = std::min(calls.depth(), CallStack::capacity);
+      current_function = depth ? calls.frames()[depth - 1].function : nullptr;
+    }
+
+    void Site::leave() {
+      current_node = _outer_node;
+      current_function = _outer_function;
+    }
+
+    void track(Object const* obj) {
+      auto type = obj->type();
+      auto size = object_size(type);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!active()) {
+	return;
+      }
+      if (sites.empty()) {
+	sites.push_back({"[host]", {}});
+      }
+      auto site = site_id();
+      objects[obj] = {site, size, type};
+      sites[site].live.add(size);
+      types[type].add(size);
+    }
+
+    void untrack(Object const* obj) {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = objects.find(obj);
+      if (it == objects.end()) {
+	return;
+      }
+      sites[it->second.site].live.remove(it->second.size);
+      types[it->second.type].remove(it->second.size);
+      objects.erase(it);
+    }
+
+    void forget(AstNode const* node) {
+      std::lock_guard<std::mutex> lock(mutex);
+      site_ids.erase(node);
+    }
+
+    Report report() {
+      std::lock_guard<std::mutex> lock(mutex);
+      Report res{};
+      std::vector<Entry> entries;
+      for (std::size_t i = 0; i < object_type_count; ++i) {
+	if (types[i].objects) {
+	  entries.push_back({to_string(static_cast<Object::ObjectType>(i)), types[i].objects, types[i].bytes});
+	  res.objects += types[i].objects;
+	  res.bytes += types[i].bytes;
+	}
+      }
+      res.types = sorted(std::move(entries));
+      entries.clear();
+      for (auto& site : sites) {
+	if (site.live.objects) {
+	  entries.push_back({site.name, site.live.objects, site.live.bytes});
+	}
+      }
+      res.sites = sorted(std::move(entries));
+      res.known_sites = sites.size();
+      return res;
+    }
+
+    void write_report(std::ostream& os, std::size_t top_sites) {
+      auto res = report();
+      char line[64];
+      auto write_entry = [&](Entry const& entry) {
+	std::snprintf(line, sizeof(line), "%12llu %10llu  ",
+		      static_cast<unsigned long long>(entry.bytes), static_cast<unsigned long long>(entry.objects));
+	os << line << entry.name << '\n';
+      };
+
+      os << "heap profile: " << res.objects << " live objects, " << res.bytes << " bytes\n"
+	 << "       bytes    objects  type\n";
+      for (auto& entry : res.types) {
+	write_entry(entry);
+      }
+      os << "       bytes    objects  site\n";
+      for (std::size_t i = 0; i < res.sites.size() && i < top_sites; ++i) {
+	write_entry(res.sites[i]);
+      }
+      if (res.sites.size() > top_sites) {
+	os << "  (" << res.sites.size() - top_sites << " more sites)\n";
+      }
+    }
+
+    bool dump_on_signal() {
+      struct sigaction action{};
+      action.sa_handler = on_dump_signal;
+      action.sa_flags = SA_RESTART;
+      sigemptyset(&action.sa_mask);
+      return sigaction(SIGUSR1, &action, nullptr) == 0;
+    }
+
+    bool take_dump_request() {
+      return dump_requested.load(std::memory_order_relaxed) && dump_requested.exchange(false);
+    }
+  }
+}
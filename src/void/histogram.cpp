@@ -0,0 +1,89 @@
+#include <void/histogram.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Void {
+  void Histogram::record(std::uint64_t value) {
+    ++_buckets[bucket_of(value)];
+    if (_count == 0 || value < _min) {
+      _min = value;
+    }
+    if (value > _max) {
+      _max = value;
+    }
+    ++_count;
+    _sum += value;
+  }
+
+  void Histogram::merge(Histogram const& other) {
+    if (other._count == 0) {
+      return;
+    }
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      _buckets[i] += other._buckets[i];
+    }
+    _min = _count == 0 ? other._min : std::min(_min, other._min);
+    _max = std::max(_max, other._max);
+    _count += other._count;
+    _sum += other._sum;
+  }
+
+  void Histogram::reset() {
+    *this = Histogram{};
+  }
+
+  std::uint64_t Histogram::count() const {
+    return _count;
+  }
+
+  std::uint64_t Histogram::sum() const {
+    return _sum;
+  }
+
+  std::uint64_t Histogram::min() const {
+    return _min;
+  }
+
+  std::uint64_t Histogram::max() const {
+    return _max;
+  }
+
+  std::uint64_t Histogram::percentile(double p) const {
+    if (_count == 0) {
+      return 0;
+    }
+    p = std::clamp(p, 0.0, 100.0);
+    auto rank = static_cast<std::uint64_t>(std::ceil(p / 100.0 * _count));
+    rank = std::max<std::uint64_t>(rank, 1);
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucket_count; ++i) {
+      seen += _buckets[i];
+      if (seen >= rank) {
+	return std::clamp(bucket_upper(i), _min, _max);
+      }
+    }
+    return _max;
+  }
+
+  std::size_t Histogram::bucket_of(std::uint64_t value) {
+    if (value < sub_count) {
+      return value;
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - sub_bits;
+    std::size_t sub = (value >> shift) & (sub_count - 1);
+    return (shift + 1) * sub_count + sub;
+  }
+
+  std::uint64_t Histogram::bucket_upper(std::size_t index) {
+    if (index < sub_count) {
+      return index;
+    }
+    int shift = static_cast<int>(index / sub_count) - 1;
+    std::uint64_t sub = index % sub_count;
+    std::uint64_t lower = (sub_count + sub) << shift;
+    return lower + ((std::uint64_t{1} << shift) - 1);
+  }
+}
@@ -0,0 +1,9 @@
+#include <void/host.hpp>
+
+namespace Void {
+  namespace host {
+    std::shared_ptr<Object> argument_error(std::size_t index, char const* expected) {
+      return std::make_shared<Error>("argument " + std::to_string(index + 1) + ": expected " + expected);
+    }
+  }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Void {
+  class Object;
+
+  // Call arguments live here instead of in a vector per call. Frames are
+  // carved LIFO out of fixed blocks that are never reallocated, so the
+  // slots of a frame stay put while nested calls push frames above it.
+  class ArgStack {
+  public:
+    using Slot = std::shared_ptr<Object>;
+
+    ArgStack() = default;
+    ArgStack(ArgStack const&) = delete;
+    ArgStack& operator=(ArgStack const&) = delete;
+
+    // pushes size slots on construction and pops them on destruction
+    class Frame {
+    public:
+      Frame(ArgStack& stack, std::size_t size)
+	: _stack(stack), _slots(stack.push_frame(size)), _size(size) {}
+      Frame(Frame const&) = delete;
+      Frame& operator=(Frame const&) = delete;
+      ~Frame() { _stack.pop_frame(_size); }
+
+      Slot* data() const { return _slots; }
+      std::size_t size() const { return _size; }
+      Slot& operator[](std::size_t i) const { return _slots[i]; }
+
+    private:
+      ArgStack& _stack;
+      Slot* _slots;
+      std::size_t _size;
+    };
+
+    Slot* push_frame(std::size_t size); // size contiguous empty slots
+    void pop_frame(std::size_t size);   // releases the slots of the top frame
+
+  private:
+    static constexpr std::size_t block_size = 1024;
+
+    struct Block {
+      std::unique_ptr<Slot[]> slots;
+      std::size_t capacity;
+      std::size_t top;
+    };
+
+    std::vector<Block> _blocks;
+    std::size_t _current{};
+  };
+}
@@ -2,16 +2,144 @@
 
 #include <void/token.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 
 namespace Void {
+  class Object;
+  class String;
+  class FunctionLiteral;
+
+  struct AstStats {
+    std::size_t nodes{}; // live nodes in every program
+    std::size_t bytes{}; // their size, not counting strings they own
+  };
+
+  // what an AstNode is, for dispatching without dynamic_cast
+  enum class NodeKind {
+    program,
+    identifier,
+    let_statement,
+    return_statement,
+    expression_statement,
+    block_statement,
+    integer_literal,
+    boolean_literal,
+    string_literal,
+    array_literal,
+    hash_literal,
+    function_literal,
+    if_expression,
+    call_expression,
+    index_expression,
+    prefix_expression,
+    infix_expression,
+  };
+  constexpr std::size_t node_kind_count = static_cast<std::size_t>(NodeKind::infix_expression) + 1;
+  char const* to_string(NodeKind);
+
+  // the operator of an InfixExpression, decoded once by the parser
+  enum class InfixOp : std::uint8_t { add, sub, mul, div, lt, le, gt, ge, eq, ne, other };
+
+  // How the evaluator runs a node. A node starts out collecting feedback,
+  // specializes once it has seen enough of it and falls back to generic
+  // when a guard of its specialization fails.
+  enum class Quick : std::uint8_t {
+    none,
+    int_int,   // infix with two Integers
+    bool_cond, // if with a Boolean condition
+    slot,      // identifier read from the binding it was last found in
+    generic,
+  };
+
+  // where an Identifier was last found: the scope hops out and its
+  // Environment::id(), and the binding in it
+  struct SlotCache {
+    std::uint32_t hops{};
+    std::uint32_t misses{};
+    std::uint64_t env{};
+    std::shared_ptr<Object> const* slot{};
+  };
+
+  // the bit of a name in Environment::names(), one of 64 picked by hash
+  std::uint64_t name_bit(std::string const&);
+
+  // What evaluation has seen at a node, see type_feedback.hpp. Type masks
+  // have bit 1 << ObjectType set for every type seen, counts saturate.
+  struct InfixFeedback {
+    std::uint32_t count{};
+    std::uint16_t left{};
+    std::uint16_t right{};
+
+    void record(unsigned left_type, unsigned right_type) {
+      count += count != UINT32_MAX;
+      left |= 1u << left_type;
+      right |= 1u << right_type;
+    }
+  };
+
+  struct CallFeedback {
+    std::uint32_t count{};
+    void const* target{}; // FunctionLiteral or Builtin, only compared
+    std::string name;     // of the first target, kept by profiles
+    bool polymorphic{};
+  };
+
+  // A target a call site called and the binding its callee Identifier
+  // read it from, found like a SlotCache: the scope hops out and its
+  // Environment::id(), and the slot. A hit needs the slot to still hold
+  // the target, so rebinding the name misses. The target is held weakly:
+  // a function keeps its program alive and with it the site, a strong
+  // reference would keep both forever. While it has not expired no other
+  // object can take its address, and its literal cannot change.
+  struct CallTarget {
+    std::weak_ptr<Object> object;           // Function or Builtin
+    Object const* raw{};                    // its address, compared with *slot
+    FunctionLiteral const* function{};      // nullptr for a Builtin
+    std::shared_ptr<Object> const* slot{};
+    std::uint64_t env{};
+    std::uint32_t hops{};
+  };
+
+  // The targets of a call site, each a function whose parameters match
+  // the site's arguments or a builtin. A site that keeps missing, such as
+  // one calling a parameter, drops them and stops caching.
+  struct CallCache {
+    static constexpr std::size_t ways = 4;
+
+    CallTarget targets[ways];
+    std::uint8_t size{};
+    std::uint8_t next{}; // replaced once all ways are taken
+    bool megamorphic{};
+    std::uint32_t hits{};
+    std::uint32_t misses{};
+  };
+
+  struct IfFeedback {
+    std::uint32_t taken{};
+    std::uint32_t not_taken{};
+
+    void record(bool truthy) {
+      auto& count = truthy ? taken : not_taken;
+      count += count != UINT32_MAX;
+    }
+  };
+
   class AstNode {
   public:
     virtual std::string token_literal() const = 0; 
     virtual std::string to_string() const = 0; 
+    virtual NodeKind kind() const = 0;
     virtual ~AstNode() {}
+
+    // nodes count themselves so retained ASTs show up in stats
+    static void* operator new(std::size_t);
+    static void operator delete(void*, std::size_t);
+    static AstStats stats();
+    static std::size_t made_on_thread(); // nodes ever allocated by this thread
   };
 
   class Statement : public AstNode {
@@ -19,6 +147,7 @@ namespace Void {
     Statement(Token);
 
     std::string token_literal() const override;
+    int line() const;
     
   protected:
     Token _token;
@@ -29,6 +158,7 @@ namespace Void {
     Expression(Token);
 
     std::string token_literal() const override;
+    int line() const;
     
   protected:
     Token _token;
@@ -36,30 +166,49 @@ namespace Void {
 
   class Program : public AstNode {
   public:
+    NodeKind kind() const override;
     std::string to_string() const override;
     std::string token_literal() const override;
     std::vector<std::unique_ptr<Statement>> const& statements() const;
     void append(std::unique_ptr<Statement>);
 
+    // kept so a snapshot can rebuild the AST its functions point into
+    std::string const& source() const;
+    void set_source(std::string);
+    // every function literal, in the order the parser finished them
+    std::vector<FunctionLiteral*> const& functions() const;
+    void set_functions(std::vector<FunctionLiteral*>);
+
   private:
     std::vector<std::unique_ptr<Statement>> _statements;
+    std::string _source;
+    std::vector<FunctionLiteral*> _functions;
   };
 
   class Identifier : public Expression {
   public:
     Identifier(Token);
 
+    NodeKind kind() const override;
     std::string to_string() const override;
-    std::string value() const;
+    std::string const& value() const;
+    std::uint64_t bit() const; // name_bit(value())
+    SlotCache& slot_cache();
+    Quick quick() const;
+    void set_quick(Quick);
     
   private:
     std::string _value;
+    std::uint64_t _bit;
+    Quick _quick{};
+    SlotCache _slot_cache;
   };
 
   class LetStatement : public Statement {
   public: 
     using Statement::Statement;
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     Identifier* identier() const;
     Expression* expression() const;
@@ -75,6 +224,7 @@ namespace Void {
   public: 
     using Statement::Statement;
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     Expression* expression() const;
     void set_expression(std::unique_ptr<Expression>);
@@ -87,6 +237,7 @@ namespace Void {
   public:
     using Statement::Statement;
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     Expression* expression() const;
     void set_expression(std::unique_ptr<Expression>);
@@ -99,6 +250,7 @@ namespace Void {
   public:
     using Statement::Statement;
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     std::vector<std::unique_ptr<Statement>> const& statements() const;
     void append(std::unique_ptr<Statement>);
@@ -110,17 +262,24 @@ namespace Void {
   public:
     IntegerLiteral(Token);
 
+    NodeKind kind() const override;
     std::string to_string() const override;
-    int value() const; 
+    std::int64_t value() const; 
+    bool is_big() const; // the literal does not fit in value(), see token_literal()
+    std::shared_ptr<Object> const& object() const; // built on first evaluation
+    void set_object(std::shared_ptr<Object>);
     
   private:
-    int _value;
+    std::int64_t _value{};
+    bool _big{};
+    std::shared_ptr<Object> _object;
   };
 
   class BooleanLiteral : public Expression {
   public:
     BooleanLiteral(Token);
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     bool value() const;
     
@@ -132,17 +291,22 @@ namespace Void {
   public:
     StringLiteral(Token);
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     std::string value() const;
+    std::shared_ptr<String> const& object() const; // interned on first evaluation
+    void set_object(std::shared_ptr<String>);
     
   private:
     std::string _value;
+    std::shared_ptr<String> _object;
   };
 
   class ArrayLiteral : public Expression {
   public:
     using Expression::Expression;
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     std::vector<std::unique_ptr<Expression>> const& expressions() const;
     void append(std::unique_ptr<Expression>); 
@@ -151,26 +315,52 @@ namespace Void {
     std::vector<std::unique_ptr<Expression>> _expressions;
   };
 
+  class HashLiteral : public Expression {
+  public:
+    using Expression::Expression;
+    using Pair = std::pair<std::unique_ptr<Expression>, std::unique_ptr<Expression>>;
+
+    NodeKind kind() const override;
+    std::string to_string() const override;
+    std::vector<Pair> const& pairs() const;
+    void append(std::unique_ptr<Expression>, std::unique_ptr<Expression>);
+
+  private:
+    std::vector<Pair> _pairs;
+  };
+
   class FunctionLiteral : public Expression {
   public:
     using Expression::Expression;
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     std::vector<std::unique_ptr<Identifier>> const& parameters() const;
     BlockStatement* body() const;
     //void set_parameters(std::vector<std::unique_ptr<Identifier>>) const;
     void append_parameters(std::unique_ptr<Identifier>);
     void set_body(std::unique_ptr<BlockStatement>);
+    std::string const& name() const; // the let it is bound by, if any
+    void set_name(std::string);
+    // How a call binds the parameters: their indices in name order, the
+    // last of each name, so each one appends to the call's scope, and the
+    // name_bit() of all of them
+    std::vector<std::uint32_t> const& binding_order() const;
+    std::uint64_t parameter_names() const;
     
   private:
     std::vector<std::unique_ptr<Identifier>> _parameters;
+    std::vector<std::uint32_t> _binding_order;
+    std::uint64_t _parameter_names{};
     std::unique_ptr<BlockStatement> _body;
+    std::string _name;
   };
 
   class IfExpression : public Expression {
   public:
     using Expression::Expression;
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     Expression* condition() const;
     BlockStatement* consequence() const;
@@ -178,32 +368,43 @@ namespace Void {
     void set_condition(std::unique_ptr<Expression>);
     void set_consequence(std::unique_ptr<BlockStatement>);
     void set_alternative(std::unique_ptr<BlockStatement>);
+    IfFeedback& feedback();
+    Quick quick() const;
+    void set_quick(Quick);
     
   private:
     std::unique_ptr<Expression> _condition;
     std::unique_ptr<BlockStatement> _consequence;
     std::unique_ptr<BlockStatement> _alternative;
+    Quick _quick{};
+    IfFeedback _feedback;
   };
 
   class CallExpression : public Expression {
   public:
     using Expression::Expression;
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     Expression* function() const; 
     std::vector<std::unique_ptr<Expression>> const& arguments() const;
     void set_function(std::unique_ptr<Expression>);
     void append_arguments(std::unique_ptr<Expression>); 
+    CallFeedback& feedback();
+    CallCache& cache();
     
   private:
     std::unique_ptr<Expression> _function; 
     std::vector<std::unique_ptr<Expression>> _arguments;
+    CallFeedback _feedback;
+    CallCache _cache;
   };
 
   class IndexExpression : public Expression {
   public:
     using Expression::Expression;
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     Expression* index() const;
     Expression* array() const;
@@ -219,6 +420,7 @@ namespace Void {
   public:
     PrefixExpression(Token);
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     std::string op() const;
     Expression* right() const;
@@ -233,16 +435,24 @@ namespace Void {
   public:
     InfixExpression(Token);
 
+    NodeKind kind() const override;
     std::string to_string() const override;
     std::string op() const;
+    InfixOp infix_op() const;
     Expression* left() const;
     Expression* right() const;
     void set_right(std::unique_ptr<Expression>);
     void set_left(std::unique_ptr<Expression>);
+    InfixFeedback& feedback();
+    Quick quick() const;
+    void set_quick(Quick);
     
   private:
     std::unique_ptr<Expression> _left;
     std::string _op;
     std::unique_ptr<Expression> _right;
+    InfixOp _infix_op;
+    Quick _quick{};
+    InfixFeedback _feedback;
   };
 }
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Void {
+  // Arbitrary precision integer, sign and magnitude in base 2^32 limbs
+  // (least significant first). Multiplication switches to Karatsuba once
+  // both operands are large. Division truncates toward zero like int64_t.
+  class BigInt {
+  public:
+    using Limbs = std::vector<std::uint32_t>;
+
+    BigInt() = default;
+    BigInt(std::int64_t);
+
+    static bool parse(std::string_view digits, BigInt& res); // decimal, optional leading '-'
+
+    std::string to_string() const;
+    bool is_zero() const;
+    bool is_negative() const;
+    bool fits_int64() const;
+    std::int64_t to_int64() const; // only valid when fits_int64()
+    int compare(BigInt const&) const;
+    std::uint64_t hash() const;
+
+    BigInt operator-() const;
+    friend BigInt operator+(BigInt const&, BigInt const&);
+    friend BigInt operator-(BigInt const&, BigInt const&);
+    friend BigInt operator*(BigInt const&, BigInt const&);
+    // the divisor must not be zero
+    friend BigInt operator/(BigInt const&, BigInt const&);
+    friend BigInt operator%(BigInt const&, BigInt const&);
+
+    static Limbs add_magnitude(Limbs const&, Limbs const&);
+    static Limbs sub_magnitude(Limbs const&, Limbs const&); // requires a >= b
+    static Limbs mul_magnitude(Limbs const&, Limbs const&);
+    static void divmod_magnitude(Limbs const&, Limbs const&, Limbs& quot, Limbs& rem);
+    static int compare_magnitude(Limbs const&, Limbs const&);
+
+  private:
+    static constexpr std::size_t karatsuba_threshold = 32;
+
+    static Limbs mul_schoolbook(Limbs const&, Limbs const&);
+    static Limbs mul_karatsuba(Limbs const&, Limbs const&);
+    static std::uint32_t divmod_small(Limbs&, std::uint32_t); // in place, returns remainder
+    static void trim(Limbs&);
+
+    bool _negative{};
+    Limbs _limbs;
+  };
+
+  inline bool operator==(BigInt const& left, BigInt const& right) { return left.compare(right) == 0; }
+  inline bool operator!=(BigInt const& left, BigInt const& right) { return left.compare(right) != 0; }
+  inline bool operator<(BigInt const& left, BigInt const& right) { return left.compare(right) < 0; }
+  inline bool operator<=(BigInt const& left, BigInt const& right) { return left.compare(right) <= 0; }
+  inline bool operator>(BigInt const& left, BigInt const& right) { return left.compare(right) > 0; }
+  inline bool operator>=(BigInt const& left, BigInt const& right) { return left.compare(right) >= 0; }
+}
@@ -8,10 +8,24 @@
 namespace Void {
   extern std::map<std::string, std::shared_ptr<Builtin>> builtin_func_map;
 
-  extern std::shared_ptr<Object> len(std::vector<std::shared_ptr<Object>> const&);
-  extern std::shared_ptr<Object> first(std::vector<std::shared_ptr<Object>> const&);
-  extern std::shared_ptr<Object> last(std::vector<std::shared_ptr<Object>> const&);
-  extern std::shared_ptr<Object> push(std::vector<std::shared_ptr<Object>> const&);
-  extern std::shared_ptr<Object> pop(std::vector<std::shared_ptr<Object>> const&);
-  extern std::shared_ptr<Object> puts(std::vector<std::shared_ptr<Object>> const&);
+  extern std::shared_ptr<Object> len(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> first(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> last(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> push(std::shared_ptr<Object> const&, std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> pop(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> puts(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> keys(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> values(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> get(std::shared_ptr<Object> const&, std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> set(Args);
+  extern std::shared_ptr<Object> substr(Args);
+  extern std::shared_ptr<Object> intern(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> int_array(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> to_array(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> sum(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> dot(std::shared_ptr<Object> const&, std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> min(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> max(std::shared_ptr<Object> const&);
+  extern std::shared_ptr<Object> stats(); // the running evaluator's Counters
+  extern std::shared_ptr<Object> heap_profile(); // heap_profiler::write_report
 }
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <void/ast.hpp>
+#include <void/object.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace Void {
+  // Event counts of one Evaluator, to find out what makes a script
+  // expensive. They are only kept when built with VOID_STATS, otherwise
+  // the count_ functions are empty and every counter stays zero.
+  struct Counters {
+    std::array<std::uint64_t, node_kind_count> nodes{};     // evaluated, per kind
+    std::uint64_t env_gets{};
+    std::uint64_t env_hops{};                                 // outer scopes walked by them
+    std::array<std::uint64_t, object_type_count> objects{}; // constructed, per type
+    // keyed by the builtin object, which the key keeps alive for its name
+    std::unordered_map<std::shared_ptr<Object>, std::uint64_t> builtin_calls;
+    std::uint64_t function_calls{};
+    std::uint32_t depth{};     // function calls in progress
+    std::uint32_t max_depth{};
+
+    // calls per builtin name, several objects may share one
+    std::map<std::string, std::uint64_t> builtin_calls_by_name() const;
+    // {"nodes": {"call_expression": 3, ...}, "env_gets": 9, ...}
+    std::string to_json() const;
+    // the same as a Hash, for the stats() builtin
+    std::shared_ptr<Object> to_object() const;
+
+    // counts on this thread go to the given counters while alive
+    class Activation {
+    public:
+      explicit Activation(Counters&);
+      Activation(Activation const&) = delete;
+      Activation& operator=(Activation const&) = delete;
+      ~Activation();
+
+    private:
+      Counters* _outer;
+    };
+
+    // the counters of the evaluator running on this thread, if any
+    static Counters* active();
+  };
+
+#ifdef VOID_STATS
+  constexpr bool stats_enabled = true;
+
+  namespace detail {
+    extern thread_local Counters* active_counters;
+  }
+
+  inline void count_object(Object::ObjectType type) {
+    if (auto counters = detail::active_counters) {
+      ++counters->objects[type];
+    }
+  }
+
+  inline void count_env_get(std::size_t hops) {
+    if (auto counters = detail::active_counters) {
+      ++counters->env_gets;
+      counters->env_hops += hops;
+    }
+  }
+#else
+  constexpr bool stats_enabled = false;
+
+  inline void count_object(Object::ObjectType) {}
+  inline void count_env_get(std::size_t) {}
+#endif
+}
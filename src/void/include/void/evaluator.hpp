@@ -6,17 +6,130 @@
 #include <void/ast.hpp>
 #include <void/parser.hpp>
 #include <void/object.hpp>
+#include <void/gc.hpp>
+#include <void/arg_stack.hpp>
+#include <void/host.hpp>
+#include <void/profiler.hpp>
+#include <void/counters.hpp>
+#include <void/timing.hpp>
 
+#include <array>
+#include <chrono>
+#include <map>
 #include <memory>
+#include <string_view>
 
 namespace Void {
+  namespace type_feedback {
+    class Profile;
+  }
+  namespace type_inference {
+    struct Report;
+  }
+
+  struct EvaluatorStats {
+    GcStats gc;
+    // ASTs still referenced by scripts or functions, process wide: every
+    // evaluator and parser on every thread, not this evaluator alone
+    AstStats ast;
+    Counters counters; // since construction, zero without VOID_STATS
+  };
+
+  class Evaluator;
+
+  // A parsed program bound to the evaluator that compiled it. Running it
+  // again evaluates the same AST in the global scope without reparsing.
+  // The AST lives as long as the script or a function defined by it.
+  class Script {
+  public:
+    std::shared_ptr<Object> run() const;
+    bool ok() const;
+    std::vector<std::string> const& errors() const; // parse errors
+
+  private:
+    friend class Evaluator;
+    Script(Evaluator*, std::shared_ptr<Program>, std::vector<std::string>);
+
+    Evaluator* _evaluator;
+    std::shared_ptr<Program> _program;
+    std::vector<std::string> _errors;
+  };
+
+  // A function resolved once by name. Calls marshal their arguments onto
+  // the stack with host::Marshal and go straight to the function object.
+  class Callable {
+  public:
+    Callable() = default;
+
+    explicit operator bool() const { return _function != nullptr; }
+    std::shared_ptr<Object> const& function() const { return _function; }
+
+    template <typename... A>
+    std::shared_ptr<Object> call(A&&... args) const;
+
+  private:
+    friend class Evaluator;
+    Callable(Evaluator* evaluator, std::shared_ptr<Object> function)
+      : _evaluator(evaluator), _function(std::move(function)) {}
+
+    Evaluator* _evaluator{};
+    std::shared_ptr<Object> _function;
+  };
+
   class Evaluator {
   public:
     Evaluator();
+    ~Evaluator();
+    Evaluator(Evaluator const&) = delete;
+    Evaluator& operator=(Evaluator const&) = delete;
 
     std::shared_ptr<Object> eval(std::string const&); 
+    // the same, filling in everything in the timing but print
+    std::shared_ptr<Object> eval(std::string const&, EvalTiming&);
+
+    Script compile(std::string const&);
+    // a script function, host function or builtin; empty if there is none
+    Callable lookup_function(std::string const&);
+    // calls a function or builtin object with evaluated arguments
+    std::shared_ptr<Object> call(std::shared_ptr<Object> const& function, Args);
+
+    // Binary image of the global scope and everything reachable from it,
+    // closures and the source of the programs they live in included.
+    // restore() rebuilds that scope in this evaluator, reparsing those
+    // programs but not running them; host functions referenced by the
+    // image must have been def'd first. Returns null or an Error.
+    std::string snapshot() const;
+    std::shared_ptr<Object> restore(std::string_view image);
+
+    // Exposes a C++ function to scripts run by this evaluator. Arguments
+    // and the result are converted by host::Marshal, a call with values of
+    // the wrong type returns an error. Host functions shadow builtins.
+    template <typename R, typename... A>
+    void def(std::string const& name, R (*fn)(A...)) {
+      _functions[name] = host::bind(name, fn);
+    }
+    void def(std::string const& name, BuiltinFunction, int arity = Builtin::variadic);
+
+    // the collector is per thread and shared by every Evaluator on it
+    void set_gc_mode(Collector::Mode);
+    void set_gc_pause_budget(std::chrono::microseconds);
+    void collect_garbage();
+    EvaluatorStats stats() const;
+
+    // programs compiled from now on are attached to the profile, which
+    // must outlive them; nullptr detaches
+    void set_profile(type_feedback::Profile*);
+    // programs compiled from now on go through type_inference::infer
+    // first, which adds what it could not prove to the report; nullptr
+    // turns it off
+    void set_inference(type_inference::Report*);
     
   private:
+    friend class Script;
+
+    void safepoint();
+    std::shared_ptr<Object> run(std::shared_ptr<Program> const&);
+
     std::shared_ptr<Object> eval(AstNode*, Environment*);
     
     std::shared_ptr<Object> eval_program(Program*, Environment*);
@@ -38,23 +151,52 @@ namespace Void {
     std::shared_ptr<Object> eval_boolean_literal(BooleanLiteral*, Environment*);
     std::shared_ptr<Object> eval_string_literal(StringLiteral*, Environment*);
     std::shared_ptr<Object> eval_array_literal(ArrayLiteral*, Environment*);
+    std::shared_ptr<Object> eval_hash_literal(HashLiteral*, Environment*);
     std::shared_ptr<Object> eval_function_literal(FunctionLiteral*, Environment*);
 
     std::shared_ptr<Object> eval_bang_operator_expression(Object*);
     std::shared_ptr<Object> eval_minus_operator_expression(Object*);
-    std::shared_ptr<Object> eval_integer_infix_expression(std::string const& op, Integer*, Integer*);
-    std::shared_ptr<Object> eval_string_infix_expression(std::string const& op, String*, String*);
+    std::shared_ptr<Object> eval_integer_infix_expression(InfixOp, Integer*, Integer*);
+    std::shared_ptr<Object> eval_big_integer_infix_expression(std::string const& op, BigInt const&, BigInt const&);
+    std::shared_ptr<Object> eval_string_infix_expression(std::string const& op, std::shared_ptr<String> const&, std::shared_ptr<String> const&);
     std::shared_ptr<Object> eval_array_infix_expression(std::string const& op, Array*, Array*);
-    std::shared_ptr<Object> eval_apply_function(Function*, Environment*);
+    std::shared_ptr<Object> eval_int_array_infix_expression(std::string const& op, Object*, Object*);
+    std::shared_ptr<Object> eval_apply_function(Function*, Args);
+    // the same for arguments already known to match the parameters
+    std::shared_ptr<Object> eval_apply_checked_function(Function*, Args);
+
+    void record_call_target(CallFeedback&, Object* function, void const* target);
 
+    std::shared_ptr<Object> native_bool_to_boolean(bool);
     bool is_truthy(Object*);
+    bool is_integer(Object*); // Integer or BigInteger
+    BigInt to_big_int(Object*);
     bool is_error(Object*);
     bool is_null(Object*);
     
   private:
-    std::unique_ptr<Environment> _env;
+    std::shared_ptr<Environment> _env;
+    // scopes captured by closures, cleared on destruction to break cycles
+    std::vector<std::weak_ptr<Environment>> _captured;
+    ArgStack _stack;
+    CallStack _calls;
+    Counters _counters;
+    std::map<std::string, std::shared_ptr<Builtin>> _functions;
+    type_feedback::Profile* _profile{};
+    type_inference::Report* _inference{};
 
-    std::vector<std::unique_ptr<Program>> _programs; // 
+    // handle of the program being evaluated, owned by the running Script
+    // or Function, for function literals to hold on to
+    std::shared_ptr<Program> const* _program{};
   };
+
+  template <typename... A>
+  std::shared_ptr<Object> Callable::call(A&&... args) const {
+    if (!_function) {
+      return std::make_shared<Error>("not a function");
+    }
+    std::array<std::shared_ptr<Object>, sizeof...(A)> values{host::MarshalFor<A>::make(std::forward<A>(args))...};
+    return _evaluator->call(_function, Args(values.data(), values.size()));
+  }
 }
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <void/histogram.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Void {
+  class Object;
+
+  struct GcStats {
+    std::uint64_t collections{}; // times the pending queue was fully drained
+    std::uint64_t slices{};      // bounded work slices run
+    std::uint64_t reclaimed{};   // references released by the collector
+    std::uint64_t pending{};     // references still waiting to be released
+    Histogram pause_ns;          // duration of every slice
+  };
+
+  // Objects are reference counted, so the only stop-the-world pause is the
+  // cascade of destructors when the last reference to a large container goes
+  // away. In incremental mode containers hand their children to the
+  // collector instead of releasing them recursively, and the evaluator
+  // releases them in slices bounded by the pause budget.
+  class Collector {
+  public:
+    enum Mode {
+      immediate_mode,
+      incremental_mode,
+    };
+
+    using Chunk = std::vector<std::shared_ptr<Object>>;
+
+    // one collector per thread, null once the thread is shutting down
+    static Collector* local();
+
+    Collector() = default;
+    Collector(Collector const&) = delete;
+    Collector& operator=(Collector const&) = delete;
+    ~Collector();
+
+    Mode mode() const;
+    void set_mode(Mode);
+    std::chrono::microseconds pause_budget() const;
+    void set_pause_budget(std::chrono::microseconds);
+
+    // called by containers on destruction, takes over the children
+    void defer(Chunk&);
+
+    bool has_pending() const;
+    void step();    // run one slice bounded by the pause budget
+    void collect(); // drain everything
+
+    GcStats const& stats() const;
+
+  private:
+    void drain(std::chrono::steady_clock::time_point deadline, bool bounded);
+
+    Mode _mode{immediate_mode};
+    std::chrono::microseconds _pause_budget{500};
+    std::vector<Chunk> _pending;
+    bool _draining{};
+    GcStats _stats;
+  };
+
+  inline bool Collector::has_pending() const {
+    return !_pending.empty();
+  }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Void {
+  class Object;
+
+  // Open addressing table in the style of SwissTable: one control byte per
+  // slot holds the low 7 bits of the hash (or empty), and lookups compare a
+  // whole group of 16 control bytes at once with SSE2. Entries live in a
+  // dense vector in insertion order, slots only store their index, so
+  // iteration is ordered and the probed arrays stay small.
+  class HashTable {
+  public:
+    struct Entry {
+      std::uint64_t hash;
+      std::shared_ptr<Object> key;
+      std::shared_ptr<Object> value;
+    };
+
+    // Integer, BigInteger, Boolean, String, and Arrays of those can be keys
+    static bool hashable(Object const*);
+    static std::uint64_t hash(Object const*);
+    static bool equal(Object const*, Object const*);
+
+    std::size_t size() const;
+    bool empty() const;
+    std::vector<Entry> const& entries() const;
+
+    Entry const* find(Object const* key, std::uint64_t hash) const;
+    void insert(std::shared_ptr<Object> key, std::shared_ptr<Object> value, std::uint64_t hash);
+    void reserve(std::size_t);
+
+  private:
+    static constexpr std::size_t group_width = 16;
+    static constexpr std::int8_t empty_ctrl = -128;
+
+    static std::int8_t h2(std::uint64_t hash);
+    std::size_t h1(std::uint64_t hash) const;
+
+    // returns the slot holding key, or the first empty slot on its probe path
+    std::size_t probe(Object const* key, std::uint64_t hash, bool& found) const;
+    void set_ctrl(std::size_t slot, std::int8_t ctrl);
+    void rehash(std::size_t capacity);
+
+    std::vector<std::int8_t> _ctrl; // capacity + group_width - 1, head mirrored at the end
+    std::vector<std::uint32_t> _slots;
+    std::vector<Entry> _entries;
+    std::size_t _mask{};
+  };
+}
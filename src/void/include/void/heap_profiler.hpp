@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Void {
+  class AstNode;
+  class CallStack;
+  class FunctionLiteral;
+  class Object;
+
+  // Process wide allocation tracking. While it is on every Object made is
+  // tagged with the AST node being evaluated on its thread, its site, and
+  // live objects and bytes are kept per type and per site. Bytes are the
+  // size of the object itself, not of buffers it may share with others.
+  namespace heap_profiler {
+    namespace detail {
+      extern std::atomic<bool> tracking;
+    }
+
+    inline bool active() {
+      return detail::tracking.load(std::memory_order_relaxed);
+    }
+
+    void start();
+    // forgets every tracked object and site
+    void stop();
+
+    // the site of objects made on this thread while alive, no-op when off
+    class Site {
+    public:
+      Site(AstNode const* node, CallStack const& calls) {
+	if (active()) {
+	  enter(node, calls);
+	}
+      }
+      Site(Site const&) = delete;
+      Site& operator=(Site const&) = delete;
+      ~Site() {
+	if (_entered) {
+	  leave();
+	}
+      }
+
+    private:
+      void enter(AstNode const*, CallStack const&);
+      void leave();
+
+      bool _entered{};
+      AstNode const* _outer_node{};
+      FunctionLiteral const* _outer_function{};
+    };
+
+    // hooks for Object and AstNode, only called while active()
+    void track(Object const*);
+    void untrack(Object const*);
+    void forget(AstNode const*);
+
+    struct Entry {
+      std::string name; // object type, or "kind at line N in function"
+      std::uint64_t objects;
+      std::uint64_t bytes;
+    };
+
+    struct Report {
+      std::uint64_t objects;
+      std::uint64_t bytes;
+      std::vector<Entry> types; // most bytes first
+      std::vector<Entry> sites; // most bytes first, sites with live objects
+      std::size_t known_sites;  // site records kept, one per name
+    };
+    Report report();
+    // a text table of the types and the top sites
+    void write_report(std::ostream&, std::size_t top_sites = 20);
+
+    // SIGUSR1 asks for a report on stderr, written by the next evaluator
+    // to reach a safepoint since a signal handler cannot take the lock
+    bool dump_on_signal();
+    bool take_dump_request();
+  }
+}
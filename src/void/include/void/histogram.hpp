@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Void {
+  // Log-linear histogram: every power of two is split into 8 linear
+  // sub-buckets, so percentiles are accurate to within 12.5%.
+  class Histogram {
+  public:
+    void record(std::uint64_t);
+    void merge(Histogram const&);
+    void reset();
+
+    std::uint64_t count() const;
+    std::uint64_t sum() const;
+    std::uint64_t min() const;
+    std::uint64_t max() const;
+    std::uint64_t percentile(double) const; // 0.0 ~ 100.0
+
+  private:
+    static constexpr int sub_bits = 3;
+    static constexpr std::size_t sub_count = 1 << sub_bits;
+    static constexpr std::size_t bucket_count = 64 * sub_count;
+
+    static std::size_t bucket_of(std::uint64_t);
+    static std::uint64_t bucket_upper(std::size_t);
+
+    std::array<std::uint64_t, bucket_count> _buckets{};
+    std::uint64_t _count{};
+    std::uint64_t _sum{};
+    std::uint64_t _min{};
+    std::uint64_t _max{};
+  };
+}
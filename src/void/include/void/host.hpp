@@ -0,0 +1,142 @@
+#pragma once
+
+#include <void/object.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace Void {
+  // Marshalling between script values and C++ types for host functions
+  // bound with Evaluator::def. Marshal<T> knows how to check an argument,
+  // convert it without copying where T allows, and wrap a result.
+  namespace host {
+    template <typename T, typename = void>
+    struct Marshal {
+      static_assert(sizeof(T) == 0, "no marshalling for this host function type");
+    };
+
+    template <typename T>
+    struct Marshal<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+      static constexpr char const* name = "integer";
+
+      static bool check(Object const* obj) {
+	if (obj->type() != Object::integer_object_t) {
+	  return false;
+	}
+	auto value = obj->cast<Integer>()->value();
+	if constexpr (std::is_signed_v<T>) {
+	  return value >= std::numeric_limits<T>::min() && value <= std::numeric_limits<T>::max();
+	} else {
+	  return value >= 0 && static_cast<std::uint64_t>(value) <= std::numeric_limits<T>::max();
+	}
+      }
+      static T get(std::shared_ptr<Object> const& obj) {
+	return static_cast<T>(obj->cast<Integer>()->value());
+      }
+      static std::shared_ptr<Object> make(T value) {
+	if constexpr (std::is_unsigned_v<T> && sizeof(T) >= sizeof(std::int64_t)) {
+	  if (value > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+	    BigInt big;
+	    BigInt::parse(std::to_string(value), big);
+	    return BigInteger::make(std::move(big));
+	  }
+	}
+	return Integer::make(static_cast<std::int64_t>(value));
+      }
+    };
+
+    template <>
+    struct Marshal<bool> {
+      static constexpr char const* name = "boolean";
+
+      static bool check(Object const* obj) { return obj->type() == Object::boolean_object_t; }
+      static bool get(std::shared_ptr<Object> const& obj) { return obj.get() == true_obj.get(); }
+      static std::shared_ptr<Object> make(bool value) { return value ? true_obj : false_obj; }
+    };
+
+    template <>
+    struct Marshal<std::string_view> {
+      static constexpr char const* name = "string";
+
+      static bool check(Object const* obj) { return obj->type() == Object::string_object_t; }
+      static std::string_view get(std::shared_ptr<Object> const& obj) { return obj->cast<String>()->value(); }
+      static std::shared_ptr<Object> make(std::string_view value) { return std::make_shared<String>(std::string(value)); }
+    };
+
+    template <>
+    struct Marshal<std::string> {
+      static constexpr char const* name = "string";
+
+      static bool check(Object const* obj) { return obj->type() == Object::string_object_t; }
+      static std::string get(std::shared_ptr<Object> const& obj) { return std::string(obj->cast<String>()->value()); }
+      static std::shared_ptr<Object> make(std::string value) { return std::make_shared<String>(std::move(value)); }
+    };
+
+    // results only, lets Callable::call take string literals
+    template <>
+    struct Marshal<char const*> {
+      static constexpr char const* name = "string";
+
+      static std::shared_ptr<Object> make(char const* value) { return std::make_shared<String>(std::string(value)); }
+    };
+
+    template <>
+    struct Marshal<IntArray::Values> {
+      static constexpr char const* name = "int array";
+
+      static bool check(Object const* obj) { return obj->type() == Object::int_array_object_t; }
+      static IntArray::Values const& get(std::shared_ptr<Object> const& obj) { return obj->cast<IntArray>()->values(); }
+      static std::shared_ptr<Object> make(IntArray::Values value) { return std::make_shared<IntArray>(std::move(value)); }
+    };
+
+    template <>
+    struct Marshal<std::shared_ptr<Object>> {
+      static constexpr char const* name = "value";
+
+      static bool check(Object const*) { return true; }
+      static std::shared_ptr<Object> const& get(std::shared_ptr<Object> const& obj) { return obj; }
+      static std::shared_ptr<Object> make(std::shared_ptr<Object> value) { return value ? value : null_obj; }
+    };
+
+    template <typename T>
+    using MarshalFor = Marshal<std::decay_t<T>>;
+
+    std::shared_ptr<Object> argument_error(std::size_t index, char const* expected);
+
+    template <typename R, typename... A, std::size_t... I>
+    std::shared_ptr<Object> call(R (*fn)(A...), Args args, std::index_sequence<I...>) {
+      if constexpr (sizeof...(A) > 0) {
+	std::size_t bad = sizeof...(A);
+	((bad == sizeof...(A) && !MarshalFor<A>::check(args[I].get()) ? (void)(bad = I) : (void)0), ...);
+	if (bad != sizeof...(A)) {
+	  char const* names[] = {MarshalFor<A>::name...};
+	  return argument_error(bad, names[bad]);
+	}
+      }
+
+      if constexpr (std::is_void_v<R>) {
+	fn(MarshalFor<A>::get(args[I])...);
+	return null_obj;
+      } else {
+	return MarshalFor<R>::make(fn(MarshalFor<A>::get(args[I])...));
+      }
+    }
+
+    // the Builtin holds the host function type erased, this restores it
+    template <typename R, typename... A>
+    std::shared_ptr<Object> trampoline(void (*target)(), Args args) {
+      return call(reinterpret_cast<R (*)(A...)>(target), args, std::index_sequence_for<A...>{});
+    }
+
+    template <typename R, typename... A>
+    std::shared_ptr<Builtin> bind(std::string const& name, R (*fn)(A...)) {
+      return std::make_shared<Builtin>(&trampoline<R, A...>, reinterpret_cast<void (*)()>(fn), name, static_cast<int>(sizeof...(A)));
+    }
+  }
+}
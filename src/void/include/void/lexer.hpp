@@ -3,12 +3,14 @@
 #include "token.hpp"
 
 #include <string>
+#include <vector>
 
 namespace Void {
   class Lexer {
   public:
     Lexer(std::string const&); 
     Token read_token();
+    std::vector<Token> tokenize(); // every token left, the last one is eof
   private:
     char read_char();
     char peek_char();
@@ -24,6 +26,7 @@ namespace Void {
     char _ch{}; // current char 
     int _cur{}; // current pos
     int _nxt{}; // next pos
+    int _line{1}; // line of the current char
   };
 }
 
@@ -4,10 +4,17 @@
 #include <void/lexer.hpp>
 #include <void/ast.hpp>
 #include <void/parser.hpp>
+#include <void/persistent_vector.hpp>
+#include <void/hash_table.hpp>
+#include <void/bigint.hpp>
+#include <void/sink.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 
 namespace Void {
@@ -23,12 +30,17 @@ namespace Void {
       function_object_t,
       array_object_t,
       builtin_object_t,
+      hash_object_t,
+      big_integer_object_t,
+      int_array_object_t,
     };
 
     static std::map<ObjectType, std::string> t_to_s;
 
     explicit Object(ObjectType);
-    virtual ~Object() {}
+    Object(Object const&);
+    Object& operator=(Object const&) = default;
+    virtual ~Object();
 
     template <typename T>
     T* cast() {
@@ -41,50 +53,115 @@ namespace Void {
     }
 
     ObjectType type() const;
-    virtual std::string inspect() const = 0;
+    std::string inspect() const; // write_to a string, without limits
+    virtual void write_to(Sink&) const = 0;
 
   private:
     ObjectType _type;
   };
 
+  constexpr std::size_t object_type_count = Object::int_array_object_t + 1;
+  // "integer", "big_integer", ..., as reports and counters name them
+  char const* to_string(Object::ObjectType);
+
   class Integer : public Object {
   public:
-    explicit Integer(int);
+    explicit Integer(std::int64_t);
+
+    static std::shared_ptr<Integer> make(std::int64_t); // small values are shared
 
-    std::string inspect() const override;
-    int value() const;
+    void write_to(Sink&) const override;
+    std::int64_t value() const;
+    std::uint64_t hash() const;
     
   private:
-    int _value;
+    std::int64_t _value;
+  };
+
+  // Integer outside the int64_t range. Results are normalized through
+  // make(), so a BigInteger never holds a value an Integer could.
+  class BigInteger : public Object {
+  public:
+    explicit BigInteger(BigInt);
+
+    static std::shared_ptr<Object> make(BigInt);
+
+    void write_to(Sink&) const override;
+    BigInt const& value() const;
+    std::uint64_t hash() const;
+
+  private:
+    BigInt _value;
   };
 
   class Boolean : public Object {
   public:
     explicit Boolean(bool);
 
-    std::string inspect() const override;
+    void write_to(Sink&) const override;
     bool value() const;
 
   private:
     bool _value;
   };
 
+  // Immutable string. Short strings are stored inline, longer ones as a
+  // slice of a shared buffer, so substrings are O(1). A buffer is never
+  // reallocated; a string that ends at the last used byte of its buffer
+  // may append into the spare capacity in place, which makes `s = s + x`
+  // loops linear. Interned strings are shared across threads and never
+  // share or append into a buffer. Other large concatenations build a rope node that is
+  // flattened the first time its characters are needed.
   class String : public Object {
   public:
+    using Buffer = std::shared_ptr<std::string>;
+
     explicit String(std::string);
+    String(Buffer, std::size_t offset, std::size_t size);
+    String(std::shared_ptr<String>, std::shared_ptr<String>);
+    ~String() override;
 
-    std::string inspect() const override;
-    std::string value() const;
+    static std::shared_ptr<String> concat(std::shared_ptr<String> const&, std::shared_ptr<String> const&);
+
+    // Interned strings are unique per content, so two interned strings are
+    // equal iff they are the same object. The table only holds weak
+    // references, a string leaves it when it dies.
+    static std::shared_ptr<String> intern(std::string_view);
+    static std::shared_ptr<String> intern(std::shared_ptr<String> const&);
+    bool interned() const;
+
+    void write_to(Sink&) const override;
+    std::string_view value() const; // valid as long as this string is alive
+    std::size_t size() const;
+    std::shared_ptr<String> substr(std::size_t pos, std::size_t len) const;
+    std::uint64_t hash() const; // computed once
 
   private:
-    std::string _value;
+    static constexpr std::size_t small_capacity = 15;
+    static constexpr std::size_t rope_threshold = 256;
+    static constexpr std::size_t max_rope_depth = 48;
+
+    bool is_rope() const;
+    void flatten() const;
+    std::size_t depth() const;
+
+    std::size_t _size;
+    mutable Buffer _buffer;
+    mutable std::size_t _offset{};
+    mutable std::shared_ptr<String> _left;
+    mutable std::shared_ptr<String> _right;
+    std::size_t _depth{};
+    char _small[small_capacity]{};
+    mutable std::uint64_t _hash{};
+    mutable bool _hashed{};
+    bool _interned{};
   };
 
   class Return : public Object {
   public:
     explicit Return(std::shared_ptr<Object>);
 
-    std::string inspect() const override;
+    void write_to(Sink&) const override;
     std::shared_ptr<Object> value() const;
     
   private:
@@ -96,7 +173,7 @@ namespace Void {
     Error();
     explicit Error(std::string);
 
-    std::string inspect() const override;
+    void write_to(Sink&) const override;
     std::string value() const;
     
   private:
@@ -107,48 +184,129 @@ namespace Void {
   public:
     Null();
     
-    std::string inspect() const override; 
+    void write_to(Sink&) const override;
   };
 
   class Environment; 
   class Function : public Object {
   public:
-    Function(FunctionLiteral*, Environment*);
+    // the program handle keeps the AST the literal lives in alive
+    Function(FunctionLiteral*, std::shared_ptr<Program>, std::shared_ptr<Environment>);
+    ~Function() override;
 
-    std::string inspect() const override;
+    void write_to(Sink&) const override;
     FunctionLiteral* value() const;
     FunctionLiteral* function() const;
-    Environment* env() const;
+    std::shared_ptr<Program> const& program() const;
+    std::shared_ptr<Environment> const& env() const; // the defining scope
     
   private:
     FunctionLiteral* _function;
-    std::unique_ptr<Environment> _env;
+    std::shared_ptr<Program> _program;
+    std::shared_ptr<Environment> _env;
+  };
+
+  struct ArrayReleaseHooks {
+    static void release(std::vector<std::shared_ptr<Object>>&);
   };
 
   class Array : public Object {
   public:
+    using Elements = PersistentVector<std::shared_ptr<Object>, ArrayReleaseHooks>;
+
     Array();
+    explicit Array(Elements);
 
-    std::string inspect() const override;
-    std::vector<std::shared_ptr<Object>> const& elements() const;
-    std::vector<std::shared_ptr<Object>> const& value() const;
+    void write_to(Sink&) const override;
+    Elements const& elements() const;
+    Elements const& value() const;
     void append(std::shared_ptr<Object>); 
     
   private:
-    std::vector<std::shared_ptr<Object>> _elements;
+    Elements _elements;
   };
   
-  using BuiltinFunction = std::function<std::shared_ptr<Object>(std::vector<std::shared_ptr<Object>> const&)>;
+  // Packed int64_t array for numeric work. Arithmetic and the sum, dot,
+  // min and max builtins on it run the vectorized kernels in simd.hpp.
+  class IntArray : public Object {
+  public:
+    using Values = std::vector<std::int64_t>;
+
+    IntArray();
+    explicit IntArray(Values);
+
+    void write_to(Sink&) const override;
+    Values const& values() const;
 
+  private:
+    Values _values;
+  };
+
+  class Hash : public Object {
+  public:
+    Hash();
+
+    void write_to(Sink&) const override;
+    HashTable const& pairs() const;
+    std::shared_ptr<Object> get(Object const* key) const; // nullptr if absent
+    void set(std::shared_ptr<Object> key, std::shared_ptr<Object> value);
+
+  private:
+    HashTable _pairs;
+  };
+
+  // Non-owning view of call arguments, valid until the call returns
+  class Args {
+  public:
+    Args() = default;
+    Args(std::shared_ptr<Object> const* data, std::size_t size)
+      : _data(data), _size(size) {}
+    Args(std::vector<std::shared_ptr<Object>> const& args)
+      : _data(args.data()), _size(args.size()) {}
+
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    std::shared_ptr<Object> const& operator[](std::size_t i) const { return _data[i]; }
+    std::shared_ptr<Object> const* begin() const { return _data; }
+    std::shared_ptr<Object> const* end() const { return _data + _size; }
+
+  private:
+    std::shared_ptr<Object> const* _data{};
+    std::size_t _size{};
+  };
+
+  using BuiltinFunction0 = std::shared_ptr<Object> (*)();
+  using BuiltinFunction1 = std::shared_ptr<Object> (*)(std::shared_ptr<Object> const&);
+  using BuiltinFunction2 = std::shared_ptr<Object> (*)(std::shared_ptr<Object> const&, std::shared_ptr<Object> const&);
+  using BuiltinFunction = std::shared_ptr<Object> (*)(Args);
+  // calls a type erased host function, see host.hpp
+  using HostFunction = std::shared_ptr<Object> (*)(void (*)(), Args);
+
+  // A builtin declares its arity once; run() checks it, so fixed arity
+  // functions get their arguments unpacked and never check the count.
   class Builtin : public Object {
   public:
-    Builtin(BuiltinFunction, std::string const&);
+    static constexpr int variadic = -1;
+
+    Builtin(BuiltinFunction0, std::string const&);
+    Builtin(BuiltinFunction1, std::string const&);
+    Builtin(BuiltinFunction2, std::string const&);
+    Builtin(BuiltinFunction, std::string const&, int arity = variadic);
+    Builtin(HostFunction, void (*target)(), std::string const&, int arity);
 
-    std::string inspect() const override; 
-    std::shared_ptr<Object> run(std::vector<std::shared_ptr<Object>> const&);
+    void write_to(Sink&) const override;
+    int arity() const;
+    std::string const& name() const;
+    std::shared_ptr<Object> run(Args);
     
   private:
-    BuiltinFunction _function;
+    BuiltinFunction0 _function0{};
+    BuiltinFunction1 _function1{};
+    BuiltinFunction2 _function2{};
+    BuiltinFunction _function{};
+    HostFunction _host{};
+    void (*_target)(){};
+    int _arity;
     std::string _name;
   };
 
@@ -156,16 +314,42 @@ namespace Void {
   extern std::shared_ptr<Boolean> true_obj;
   extern std::shared_ptr<Boolean> false_obj;
   
-  class Environment {
+  // Scopes are shared: closures keep their defining scope alive and every
+  // call gets a fresh scope whose outer is the function's.
+  class Environment : public std::enable_shared_from_this<Environment> {
   public:
     Environment(); 
-    explicit Environment(Environment* outer);
+    explicit Environment(std::shared_ptr<Environment> outer);
 
-    std::shared_ptr<Object> get(std::string); 
+    std::shared_ptr<Object> get(std::string const&) const; 
     void set(std::string, std::shared_ptr<Object>);
+    void set(std::string const&, std::uint64_t bit, std::shared_ptr<Object>); // bit is name_bit() of the name
+    // binds a function's parameters to a call's arguments in a scope that
+    // binds nothing yet, in FunctionLiteral::binding_order()
+    void bind(FunctionLiteral const&, Args);
+    void clear(); // drops the bindings, breaking cycles through closures
+
+    // the nearest binding of a name, slot is nullptr if there is none; a
+    // slot stays valid until the scope holding it is cleared
+    struct Binding {
+      std::shared_ptr<Object> const* slot;
+      Environment const* scope;
+      std::uint32_t hops;
+    };
+    Binding lookup(std::string const&) const;
+    // name_bit() of every name bound here, a clear bit proves it unbound
+    std::uint64_t names() const { return _names; }
+    // unique among scopes, renewed by clear()
+    std::uint64_t id() const { return _id; }
+
+    std::map<std::string, std::shared_ptr<Object>> const& store() const;
+    std::shared_ptr<Environment> const& outer() const;
+    void set_outer(std::shared_ptr<Environment>);
     
   private:
     std::map<std::string, std::shared_ptr<Object>> _store;
-    Environment* _outer;
+    std::shared_ptr<Environment> _outer;
+    std::uint64_t _names{};
+    std::uint64_t _id;
   };
 }
@@ -25,6 +25,7 @@ namespace Void {
     };
     
     Parser(std::string const&);
+    explicit Parser(std::vector<Token>); // from Lexer::tokenize
 
     std::unique_ptr<Program> parse();
     std::vector<std::string> const& error() const;
@@ -56,6 +57,7 @@ namespace Void {
     std::unique_ptr<Expression> parse_boolean_literal();
     std::unique_ptr<Expression> parse_function_literal();
     std::unique_ptr<Expression> parse_array_literal();
+    std::unique_ptr<Expression> parse_hash_literal();
 
     Token next_token();
     Token peek_token();
@@ -77,6 +79,7 @@ namespace Void {
     static std::map<Token::TokenType, Precedence> _t_to_p; 
 
     std::vector<std::string> _errors;
+    std::vector<FunctionLiteral*> _functions;
     
     std::vector<Token> _tokens;
     Token _token;
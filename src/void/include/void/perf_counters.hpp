@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Void {
+  class FunctionLiteral;
+
+  // Hardware counters per script function, Linux only. Each thread opens
+  // its own perf_event_open group the first time it calls a function
+  // while counting is on, reads it at every call and return, and charges
+  // the difference to the function on top of its stack, so counts are
+  // self counts and recursion is not counted twice. Code outside of any
+  // function is charged to [main]. Works unprivileged when
+  // /proc/sys/kernel/perf_event_paranoid is 2 or less.
+  namespace perf_counters {
+    namespace detail {
+      extern std::atomic<bool> counting;
+    }
+
+    inline bool active() {
+      return detail::counting.load(std::memory_order_relaxed);
+    }
+
+    enum Event : std::size_t {
+      cycles,
+      instructions,
+      cache_misses,
+      branch_misses,
+      task_clock, // ns on cpu, a software event that works without a PMU
+      event_count
+    };
+
+    char const* to_string(Event);
+
+    // false if already counting or no event can be opened on this host
+    bool start();
+    void stop();
+    // the events start() could open, a VM without a PMU has task_clock alone
+    std::array<bool, event_count> available();
+
+    struct Entry {
+      std::string name; // see profiler::frame_name
+      std::uint64_t calls;
+      std::array<std::uint64_t, event_count> values;
+
+      // instructions per cycle, 0 without both
+      double ipc() const;
+      // misses per thousand instructions
+      double per_kilo_instruction(Event) const;
+    };
+    // the functions of every thread merged by name, most cycles first, or
+    // most task clock when cycles are not available
+    std::vector<Entry> report();
+    // a text table of calls, counts, IPC and miss rates
+    void write_report(std::ostream&);
+    void reset();
+
+    // charges the counts until the function returns to it, no-op when off
+    class Scope {
+    public:
+      explicit Scope(FunctionLiteral const* function) {
+	if (active()) {
+	  enter(function);
+	}
+      }
+      Scope(Scope const&) = delete;
+      Scope& operator=(Scope const&) = delete;
+      ~Scope() {
+	if (_entered) {
+	  leave();
+	}
+      }
+
+    private:
+      void enter(FunctionLiteral const*);
+      void leave();
+
+      bool _entered{};
+      unsigned _generation{};
+    };
+  }
+}
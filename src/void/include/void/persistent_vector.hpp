@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Void {
+  struct NoReleaseHooks {
+    template <typename T>
+    static void release(std::vector<T>&) {}
+  };
+
+  // Persistent bit-partitioned vector trie (32-way) with a tail buffer, in
+  // the style of Clojure's PersistentVector. Every "modifying" operation
+  // returns a new vector which shares all untouched nodes with the old one.
+  //
+  // Leaves are fixed capacity buffers. Elements in a leaf below a vector's
+  // own length are never modified, so a vector whose length equals the
+  // number of slots used in its tail may claim the next slot in place;
+  // `let a = push(a, x)` in a loop therefore never copies the tail.
+  // Hooks::release is called with the elements of a leaf being destroyed.
+  template <typename T, typename Hooks = NoReleaseHooks>
+  class PersistentVector {
+    static constexpr std::size_t bits = 5;
+    static constexpr std::size_t width = std::size_t{1} << bits;
+    static constexpr std::size_t mask = width - 1;
+
+    struct Node {
+      Node() {}
+      Node(Node const&) = default;
+      ~Node() { Hooks::release(values); }
+
+      std::vector<std::shared_ptr<Node>> children;
+      std::vector<T> values;
+    };
+
+    using NodePtr = std::shared_ptr<Node>;
+
+  public:
+    class const_iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+      using pointer = T const*;
+      using reference = T const&;
+
+      const_iterator() = default;
+      const_iterator(PersistentVector const* vec, std::size_t index)
+	: _vec(vec), _index(index) {}
+
+      reference operator*() const {
+	if (_leaf == nullptr || (_index & ~mask) != _base) {
+	  _base = _index & ~mask;
+	  _leaf = _vec->leaf_for(_index);
+	}
+	return _leaf->values[_index & mask];
+      }
+      pointer operator->() const { return &**this; }
+      const_iterator& operator++() { ++_index; return *this; }
+      const_iterator operator++(int) { auto it = *this; ++_index; return it; }
+      bool operator==(const_iterator const& other) const { return _index == other._index; }
+      bool operator!=(const_iterator const& other) const { return _index != other._index; }
+
+    private:
+      PersistentVector const* _vec{};
+      std::size_t _index{};
+      mutable Node const* _leaf{};
+      mutable std::size_t _base{};
+    };
+
+    PersistentVector()
+      : _root(std::make_shared<Node>()) {}
+
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    T const& operator[](std::size_t index) const {
+      return leaf_for(index)->values[index & mask];
+    }
+
+    T const& at(std::size_t index) const {
+      if (index >= _size) {
+	throw std::out_of_range("PersistentVector::at");
+      }
+      return (*this)[index];
+    }
+
+    T const& front() const { return (*this)[0]; }
+    T const& back() const { return (*this)[_size - 1]; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, _size); }
+
+    // append in place, only this handle observes the new element
+    void append(T value) {
+      if (_size - tail_offset() < width) {
+	append_tail(std::move(value));
+	return;
+      }
+
+      // tail is full, move it into the trie
+      NodePtr root;
+      auto shift = _shift;
+      if ((_size >> bits) > (std::size_t{1} << _shift)) {
+	root = std::make_shared<Node>();
+	root->children.push_back(_root);
+	root->children.push_back(new_path(_shift, _tail));
+	shift += bits;
+      } else {
+	root = push_tail(_shift, _root, _tail);
+      }
+
+      _root = std::move(root);
+      _shift = shift;
+      _tail = new_leaf();
+      _tail->values.push_back(std::move(value));
+      ++_size;
+    }
+
+    PersistentVector push_back(T value) const {
+      auto res = *this;
+      res.append(std::move(value));
+      return res;
+    }
+
+    PersistentVector pop_back() const {
+      if (_size == 0) {
+	throw std::out_of_range("PersistentVector::pop_back");
+      }
+      if (_size == 1) {
+	return PersistentVector();
+      }
+
+      auto res = *this;
+      if (_size - tail_offset() > 1) {
+	// the tail keeps its elements, they are just no longer visible
+	--res._size;
+	return res;
+      }
+
+      auto tail = leaf_ptr_for(_size - 2);
+      auto root = pop_tail(_shift, _root);
+      auto shift = _shift;
+      if (root == nullptr) {
+	root = std::make_shared<Node>();
+      }
+      if (shift > bits && root->children.size() == 1) {
+	root = root->children[0];
+	shift -= bits;
+      }
+
+      res._root = std::move(root);
+      res._shift = shift;
+      res._tail = tail;
+      --res._size;
+      return res;
+    }
+
+    // O(other.size()) appends, the left side is shared untouched
+    PersistentVector concat(PersistentVector const& other) const {
+      if (empty()) {
+	return other;
+      }
+      auto res = *this;
+      for (auto& value : other) {
+	res.append(value);
+      }
+      return res;
+    }
+
+  private:
+    std::size_t tail_offset() const {
+      return _size < width ? 0 : ((_size - 1) >> bits) << bits;
+    }
+
+    static NodePtr new_leaf() {
+      auto leaf = std::make_shared<Node>();
+      leaf->values.reserve(width);
+      return leaf;
+    }
+
+    void append_tail(T value) {
+      auto tail_size = _size - tail_offset();
+      if (_tail == nullptr) {
+	_tail = new_leaf();
+      } else if (_tail->values.size() != tail_size) {
+	// someone else already claimed the next slot
+	auto tail = new_leaf();
+	tail->values.assign(_tail->values.begin(), _tail->values.begin() + tail_size);
+	_tail = std::move(tail);
+      }
+      _tail->values.push_back(std::move(value));
+      ++_size;
+    }
+
+    Node const* leaf_for(std::size_t index) const {
+      return leaf_ptr_for(index).get();
+    }
+
+    NodePtr const& leaf_ptr_for(std::size_t index) const {
+      if (index >= tail_offset()) {
+	return _tail;
+      }
+      NodePtr const* node = &_root;
+      for (auto level = _shift; level > 0; level -= bits) {
+	node = &(*node)->children[(index >> level) & mask];
+      }
+      return *node;
+    }
+
+    NodePtr push_tail(std::size_t level, NodePtr const& parent, NodePtr const& tail) const {
+      auto res = std::make_shared<Node>(*parent);
+      auto index = ((_size - 1) >> level) & mask;
+
+      NodePtr child;
+      if (level == bits) {
+	child = tail;
+      } else if (index < parent->children.size()) {
+	child = push_tail(level - bits, parent->children[index], tail);
+      } else {
+	child = new_path(level - bits, tail);
+      }
+
+      if (index < res->children.size()) {
+	res->children[index] = std::move(child);
+      } else {
+	res->children.push_back(std::move(child));
+      }
+      return res;
+    }
+
+    static NodePtr new_path(std::size_t level, NodePtr const& node) {
+      if (level == 0) {
+	return node;
+      }
+      auto res = std::make_shared<Node>();
+      res->children.push_back(new_path(level - bits, node));
+      return res;
+    }
+
+    NodePtr pop_tail(std::size_t level, NodePtr const& node) const {
+      auto index = ((_size - 2) >> level) & mask;
+      if (level > bits) {
+	auto child = pop_tail(level - bits, node->children[index]);
+	if (child == nullptr && index == 0) {
+	  return nullptr;
+	}
+	auto res = std::make_shared<Node>(*node);
+	if (child == nullptr) {
+	  res->children.pop_back();
+	} else {
+	  res->children[index] = std::move(child);
+	}
+	return res;
+      } else if (index == 0) {
+	return nullptr;
+      } else {
+	auto res = std::make_shared<Node>(*node);
+	res->children.pop_back();
+	return res;
+      }
+    }
+
+    std::size_t _size{};
+    std::size_t _shift{bits};
+    NodePtr _root;
+    NodePtr _tail;
+  };
+}
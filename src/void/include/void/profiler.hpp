@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace Void {
+  class FunctionLiteral;
+  class Program;
+
+  // Script level call stack of an Evaluator, kept for the sampling
+  // profiler. A push or pop is a store and a depth update, frames deeper
+  // than the capacity are counted but not recorded.
+  class CallStack {
+  public:
+    struct Frame {
+      FunctionLiteral const* function; // nullptr for top level code
+      std::int32_t line;               // being executed in that function
+    };
+
+    static constexpr std::uint32_t capacity = 1024;
+
+    CallStack();
+
+    void push(FunctionLiteral const* function, std::int32_t line) {
+      auto depth = _depth.load(std::memory_order_relaxed);
+      if (depth < capacity) {
+	_frames[depth] = {function, line};
+      }
+      // the frame must be complete before a signal handler can see it
+      std::atomic_signal_fence(std::memory_order_release);
+      _depth.store(depth + 1, std::memory_order_relaxed);
+    }
+
+    void pop() {
+      _depth.store(_depth.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+
+    void set_line(std::int32_t line) {
+      auto depth = _depth.load(std::memory_order_relaxed);
+      if (depth != 0 && depth <= capacity) {
+	_frames[depth - 1].line = line;
+      }
+    }
+
+    // pushes on construction and pops on destruction
+    class Scope {
+    public:
+      Scope(CallStack& stack, FunctionLiteral const* function, std::int32_t line)
+	: _stack(stack) { stack.push(function, line); }
+      Scope(Scope const&) = delete;
+      Scope& operator=(Scope const&) = delete;
+      ~Scope() { _stack.pop(); }
+
+    private:
+      CallStack& _stack;
+    };
+
+    // makes this the stack sampled on the current thread while alive
+    class Activation {
+    public:
+      explicit Activation(CallStack&);
+      Activation(Activation const&) = delete;
+      Activation& operator=(Activation const&) = delete;
+      ~Activation();
+
+    private:
+      CallStack* _outer;
+    };
+
+    Frame const* frames() const { return _frames.get(); }
+    std::uint32_t depth() const { return _depth.load(std::memory_order_relaxed); }
+
+  private:
+    std::unique_ptr<Frame[]> _frames;
+    std::atomic<std::uint32_t> _depth{0};
+  };
+
+  // Process wide sampling profiler. A SIGPROF timer copies the active call
+  // stack of the interrupted thread into a preallocated buffer; samples
+  // are aggregated per stack of (function, line) when written out.
+  namespace profiler {
+    // false if it is already running or the timer cannot be set up
+    bool start(std::chrono::microseconds interval = std::chrono::microseconds(1000));
+    void stop();
+    bool active();
+
+    // samples point into the AST, a function that dies while profiling
+    // hands its program here to keep it alive until the profile is reset
+    void retain(std::shared_ptr<Program> const&);
+
+    struct Summary {
+      std::uint64_t samples;
+      std::uint64_t dropped; // the buffer was full
+    };
+    Summary summary();
+
+    // "[main]:3;fib:2;fib:1 12" per distinct stack, for flamegraph.pl
+    void write_folded(std::ostream&);
+    // profile.proto, uncompressed, for pprof
+    void write_pprof(std::ostream&);
+    // drops the samples and retained programs
+    void reset();
+
+    // a function as it is named in profiles: its let binding, fn@LINE if
+    // it has none, [main] for top level code
+    std::string frame_name(FunctionLiteral const*);
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Void {
+  // Kernels over packed int64_t arrays. Every implementation is selected
+  // once at startup from the cpu features (AVX2 when available, otherwise
+  // portable scalar loops). Kernels that can overflow return false and
+  // leave the output unspecified, the caller redoes the work with BigInt.
+  namespace simd {
+    enum class Isa {
+      scalar,
+      avx2,
+    };
+
+    Isa best_isa();
+    Isa isa();
+    void set_isa(Isa); // falls back to scalar if the cpu lacks the isa
+
+    bool sum(std::int64_t const* a, std::size_t n, std::int64_t& res);
+    bool dot(std::int64_t const* a, std::int64_t const* b, std::size_t n, std::int64_t& res);
+    // n must not be zero
+    std::int64_t min(std::int64_t const* a, std::size_t n);
+    std::int64_t max(std::int64_t const* a, std::size_t n);
+
+    // out[i] = a[i] op b[i]
+    bool add(std::int64_t const* a, std::int64_t const* b, std::int64_t* out, std::size_t n);
+    bool sub(std::int64_t const* a, std::int64_t const* b, std::int64_t* out, std::size_t n);
+    bool mul(std::int64_t const* a, std::int64_t const* b, std::int64_t* out, std::size_t n);
+
+    // out[i] = a[i] op s, or s op a[i] for rsub
+    bool add_scalar(std::int64_t const* a, std::int64_t s, std::int64_t* out, std::size_t n);
+    bool sub_scalar(std::int64_t const* a, std::int64_t s, std::int64_t* out, std::size_t n);
+    bool rsub_scalar(std::int64_t const* a, std::int64_t s, std::int64_t* out, std::size_t n);
+    bool mul_scalar(std::int64_t const* a, std::int64_t s, std::int64_t* out, std::size_t n);
+  }
+}
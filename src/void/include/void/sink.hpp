@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace Void {
+  struct PrintLimits {
+    std::size_t max_depth = std::numeric_limits<std::size_t>::max(); // nested containers
+    std::size_t max_size = std::numeric_limits<std::size_t>::max();  // bytes of output
+  };
+
+  // used where values are shown to people, the REPL and puts
+  inline constexpr PrintLimits display_limits{64, std::size_t{1} << 20};
+
+  // Buffered output for Object::write_to. Containers print through
+  // enter()/leave() and stop early once full(), so a limited print of a
+  // huge value costs as much as the output, not the value. Output past
+  // a limit is replaced with "...".
+  class Sink {
+  public:
+    explicit Sink(PrintLimits = {});
+    Sink(Sink const&) = delete;
+    Sink& operator=(Sink const&) = delete;
+    virtual ~Sink() = default;
+
+    void write(std::string_view);
+    void put(char);
+    void write_int(std::int64_t);
+    // what closes the output, such as its newline; written even past the
+    // size limit, so a truncated line still ends
+    void finish(std::string_view);
+    void flush();
+
+    // false when the depth limit is reached, "..." has been written instead
+    bool enter();
+    void leave();
+    bool full() const;      // the size limit was reached, stop writing
+    bool truncated() const; // some output was dropped by either limit
+
+  protected:
+    // derived destructors must call flush(), the buffer is gone by ~Sink
+    virtual void write_out(char const*, std::size_t) = 0;
+
+  private:
+    static constexpr std::size_t buffer_size = 4096;
+
+    void mark_truncated();
+
+    PrintLimits _limits;
+    std::size_t _written{};
+    std::size_t _depth{};
+    bool _truncated{};
+    bool _elided{};
+    std::size_t _used{};
+    char _buffer[buffer_size];
+  };
+
+  class StreamSink : public Sink {
+  public:
+    explicit StreamSink(std::ostream&, PrintLimits = {});
+    ~StreamSink() override;
+
+  protected:
+    void write_out(char const*, std::size_t) override;
+
+  private:
+    std::ostream& _os;
+  };
+
+  class StringSink : public Sink {
+  public:
+    explicit StringSink(PrintLimits = {});
+
+    std::string& str(); // flushes first
+
+  protected:
+    void write_out(char const*, std::size_t) override;
+
+  private:
+    std::string _str;
+  };
+}
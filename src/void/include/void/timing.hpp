@@ -0,0 +1,50 @@
+#pragma once
+
+#include <void/histogram.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Void {
+  // Where one eval spent its time and how much source it parsed. print
+  // is the caller's, it is the time taken to write the result out.
+  struct EvalTiming {
+    std::chrono::nanoseconds lex{};
+    std::chrono::nanoseconds parse{};
+    std::chrono::nanoseconds eval{};
+    std::chrono::nanoseconds print{};
+    std::size_t tokens{};
+    std::size_t nodes{};
+
+    // {"lex_ns": 812, "parse_ns": 2301, ..., "tokens": 24, "nodes": 17}
+    std::string to_json() const;
+  };
+
+  // Cumulative per phase durations in nanoseconds, for processes that
+  // serve many evals
+  class TimingHistograms {
+  public:
+    void record(EvalTiming const&);
+    void merge(TimingHistograms const&);
+
+    Histogram const& lex() const { return _lex; }
+    Histogram const& parse() const { return _parse; }
+    Histogram const& eval() const { return _eval; }
+    Histogram const& print() const { return _print; }
+    std::uint64_t tokens() const { return _tokens; }
+    std::uint64_t nodes() const { return _nodes; }
+
+    // count, mean, p50, p99 and max of every phase
+    std::string to_json() const;
+
+  private:
+    Histogram _lex;
+    Histogram _parse;
+    Histogram _eval;
+    Histogram _print;
+    std::uint64_t _tokens{};
+    std::uint64_t _nodes{};
+  };
+}
@@ -41,5 +41,6 @@ namespace Void {
 
     TokenType type; 
     std::string literal;
+    int line = 1; // where the token starts
   };
 }
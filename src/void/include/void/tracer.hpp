@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Void {
+  class Builtin;
+  class FunctionLiteral;
+
+  // Deterministic tracing of script function and builtin calls. Every
+  // call that passes the filter becomes one event with its start and
+  // duration, written to a ring buffer owned by the calling thread, so
+  // recording takes no lock. A full ring overwrites its oldest events.
+  namespace tracer {
+    namespace detail {
+      extern std::atomic<bool> tracing;
+    }
+
+    inline bool active() {
+      return detail::tracing.load(std::memory_order_relaxed);
+    }
+
+    // names: functions (by let binding, see profiler::frame_name) and
+    // builtins to trace, every one if empty. false if already running.
+    bool start(std::vector<std::string> names = {}, std::size_t events_per_thread = std::size_t{1} << 20);
+    // waits for calls being recorded to finish
+    void stop();
+
+    struct Summary {
+      std::uint64_t events;      // still in the buffers
+      std::uint64_t overwritten; // lost to full rings
+    };
+    Summary summary();
+
+    // Chrome trace event JSON, which Perfetto opens as well. Call after
+    // stop().
+    void write_chrome_json(std::ostream&);
+    // drops the buffers of every thread
+    void reset();
+
+    // records the call it lives through, no-op when not tracing
+    class Span {
+    public:
+      explicit Span(FunctionLiteral const* function) {
+	if (active()) {
+	  begin(function, false);
+	}
+      }
+      explicit Span(Builtin const* builtin) {
+	if (active()) {
+	  begin(builtin, true);
+	}
+      }
+      Span(Span const&) = delete;
+      Span& operator=(Span const&) = delete;
+      ~Span() {
+	if (_name) {
+	  end();
+	}
+      }
+
+    private:
+      void begin(void const* key, bool builtin);
+      void end();
+
+      std::uint32_t _name{}; // 0 when the call is not recorded
+      std::chrono::steady_clock::time_point _start;
+    };
+  }
+}
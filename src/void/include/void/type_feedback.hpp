@@ -0,0 +1,58 @@
+#pragma once
+
+#include <void/ast.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace Void {
+  // Operand types at infix expressions, call targets and branch bias of
+  // if expressions, saved across runs. A profile is keyed by the hash of
+  // each program's source: a program whose source it knows starts with the
+  // feedback of earlier runs, so its hot sites specialize on their first
+  // execution instead of after warm_up of them.
+  namespace type_feedback {
+    // executions of a site before it specializes on its own feedback
+    constexpr std::uint32_t warm_up = 8;
+
+    // FNV-1a
+    std::uint64_t source_hash(std::string_view);
+
+    // the infix, call and if expressions of a program in source order
+    std::vector<Expression*> sites(Program&);
+
+    struct Site {
+      NodeKind kind;
+      InfixFeedback infix;
+      CallFeedback call; // target is not kept, only name
+      IfFeedback branch;
+    };
+
+    class Profile {
+    public:
+      // false on a file that is not a profile, which leaves this one empty
+      bool read(std::istream&);
+      // the programs read and the attached ones, with what they saw so far
+      void write(std::ostream&) const;
+
+      // Seeds the program's sites if its source is known, true if it was.
+      // Replaces the pointer with one that folds the program's feedback
+      // into the profile when its last copy dies, so the profile does not
+      // keep it alive; run the program through that one.
+      bool attach(std::shared_ptr<Program>&);
+      std::size_t programs() const; // known, read or attached
+
+    private:
+      void fold(Program&);
+
+      std::map<std::uint64_t, std::vector<Site>> _programs;
+      std::vector<std::weak_ptr<Program>> _attached; // still alive
+    };
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <void/ast.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Void {
+  // Flow-insensitive inference of the Object types each expression of a
+  // program can evaluate to. Parameters take the types of the arguments
+  // at every call of their function that the pass can resolve to its
+  // literal, let bindings the types of what they are bound to, and the
+  // whole program is iterated until nothing grows. The types are
+  // optimistic: an operation that fails or overflows is assumed not to,
+  // and only this program is seen, not earlier REPL lines or the host.
+  // So the evaluator keeps its guards and a wrong guess costs a fallback
+  // to the generic path, never a wrong result.
+  namespace type_inference {
+    // bit 1 << Object::ObjectType per type the value may have, 0 if the
+    // pass never saw it get one (e.g. a function no call reaches)
+    using Types = std::uint16_t;
+    constexpr Types any = 0xffff;
+
+    // "integer or string", "unknown" for 0 and "any type" for any
+    std::string to_string(Types);
+
+    struct Failure {
+      int line;
+      NodeKind kind; // infix, if, call or index expression
+      std::string reason;
+    };
+
+    struct Report {
+      std::size_t sites{};  // infix, if, call and index expressions seen
+      std::size_t proven{}; // those whose operands have a single type
+      std::vector<Failure> failures; // the rest, in source order
+
+      void merge(Report const&);
+    };
+
+    // Infers the program and specializes its infix expressions proven to
+    // take two Integers and its if expressions proven to test a Boolean
+    // before they run, instead of after type_feedback::warm_up runs.
+    Report infer(Program&);
+
+    // one line per failure under a "proven of sites" summary
+    void write_report(std::ostream&, Report const&);
+  }
+}
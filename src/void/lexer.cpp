@@ -16,9 +16,18 @@ namespace Void {
     }
   }
 
+  std::vector<Token> Lexer::tokenize() {
+    std::vector<Token> tokens;
+    do {
+      tokens.push_back(read_token());
+    } while (tokens.back().type != Token::eof_t);
+    return tokens;
+  }
+
   Token Lexer::read_token() {
     skip_whitespace();
     Token token;
+    int line = _line;
     
     switch (_ch) {
     case '-':
@@ -121,14 +130,20 @@ namespace Void {
 	std::string word = read_identifier();
 	token = {Token::lookup(word), word};
       } else {
-	token = {Token::illegal_t, ""};
+	// consume it, or the parser would see the same token forever
+	token = {Token::illegal_t, std::string(1, _ch)};
+	read_char();
       }
       break;
     }
+    token.line = line;
     return token; 
   }
 
   char Lexer::read_char() {
+    if (_ch == '\n') {
+      ++_line;
+    }
     _cur = _nxt++;
     if (static_cast<std::size_t>(_cur) < _input.size()) {
       _ch = _input.at(_cur);
@@ -171,9 +186,10 @@ namespace Void {
 
   std::string Lexer::read_string() {
     int cur = _cur + 1;
+    // an unterminated string ends with the input
     do {
       read_char(); 
-    } while (_ch != '"');
+    } while (_ch != '"' && static_cast<std::size_t>(_cur) < _input.size());
     std::string str = _input.substr(cur, _cur - cur);
     read_char();
     return str; 
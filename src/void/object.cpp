@@ -1,39 +1,138 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 #include <void/ast.hpp>
 #include <memory>
 #include <type_traits>
 #include <void/object.hpp>
+#include <void/gc.hpp>
+#include <void/profiler.hpp>
+#include <void/counters.hpp>
+#include <void/heap_profiler.hpp>
+#include <void/tracer.hpp>
 
 namespace Void {
   // Object
-  Object::Object(ObjectType type) : _type(type) {}
+  Object::Object(ObjectType type) : _type(type) {
+    count_object(type);
+    if (heap_profiler::active()) {
+      heap_profiler::track(this);
+    }
+  }
+
+  Object::Object(Object const& other) : _type(other._type) {
+    count_object(_type);
+    if (heap_profiler::active()) {
+      heap_profiler::track(this);
+    }
+  }
+
+  Object::~Object() {
+    if (heap_profiler::active()) {
+      heap_profiler::untrack(this);
+    }
+  }
 
   Object::ObjectType Object::type() const {
     return _type;
   }
 
+  char const* to_string(Object::ObjectType type) {
+    static char const* const names[] = {
+      "integer",
+      "boolean",
+      "string",
+      "error",
+      "null",
+      "return",
+      "function",
+      "array",
+      "builtin",
+      "hash",
+      "big_integer",
+      "int_array",
+    };
+    static_assert(sizeof(names) / sizeof(*names) == object_type_count);
+    return names[type];
+  }
+
+  std::string Object::inspect() const {
+    StringSink sink;
+    write_to(sink);
+    return std::move(sink.str());
+  }
+
   // Integer
-  Integer::Integer(int value)
+  Integer::Integer(std::int64_t value)
     : Object(ObjectType::integer_object_t),
       _value(value)
   {}
 
-  std::string Integer::inspect() const {
-    return std::to_string(_value);
+  void Integer::write_to(Sink& sink) const {
+    sink.write_int(_value);
+  }
+
+  std::shared_ptr<Integer> Integer::make(std::int64_t value) {
+    static constexpr std::int64_t min_cached = -128, max_cached = 1023;
+    static auto const cache = [] {
+      std::vector<std::shared_ptr<Integer>> res;
+      for (auto i = min_cached; i <= max_cached; ++i) {
+	res.push_back(std::make_shared<Integer>(i));
+      }
+      return res;
+    }();
+    if (value >= min_cached && value <= max_cached) {
+      return cache[value - min_cached];
+    }
+    return std::make_shared<Integer>(value);
   }
 
-  int Integer::value() const {
+  std::int64_t Integer::value() const {
     return _value;
   } 
 
+  std::uint64_t Integer::hash() const {
+    auto x = static_cast<std::uint64_t>(_value);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  // BigInteger
+  BigInteger::BigInteger(BigInt value)
+    : Object(ObjectType::big_integer_object_t),
+      _value(std::move(value))
+  {}
+
+  std::shared_ptr<Object> BigInteger::make(BigInt value) {
+    if (value.fits_int64()) {
+      return Integer::make(value.to_int64());
+    }
+    return std::make_shared<BigInteger>(std::move(value));
+  }
+
+  void BigInteger::write_to(Sink& sink) const {
+    sink.write(_value.to_string());
+  }
+
+  BigInt const& BigInteger::value() const {
+    return _value;
+  }
+
+  std::uint64_t BigInteger::hash() const {
+    return _value.hash();
+  }
+
   // Boolean
   Boolean::Boolean(bool value)
     : Object(ObjectType::boolean_object_t),
       _value(value)
   {}
 
-  std::string Boolean::inspect() const {
-    return _value ? "true" : "false";
+  void Boolean::write_to(Sink& sink) const {
+    sink.write(_value ? "true" : "false");
   }
 
   bool Boolean::value() const {
@@ -41,27 +140,218 @@ namespace Void {
   }
 
   // String
+  namespace {
+    struct InternEntry {
+      String* ptr;
+      std::weak_ptr<String> ref;
+    };
+
+    struct InternTable {
+      std::mutex mutex;
+      std::unordered_map<std::string_view, InternEntry> strings;
+    };
+
+    InternTable& intern_table() {
+      // never destroyed, strings may die after static destruction began
+      static auto table = new InternTable;
+      return *table;
+    }
+  }
+
   String::String(std::string value)
     : Object(ObjectType::string_object_t),
-      _value(value)
+      _size(value.size())
+  {
+    if (_size <= small_capacity) {
+      value.copy(_small, _size);
+    } else {
+      _buffer = std::make_shared<std::string>(std::move(value));
+    }
+  }
+
+  String::String(Buffer buffer, std::size_t offset, std::size_t size)
+    : Object(ObjectType::string_object_t),
+      _size(size),
+      _buffer(std::move(buffer)),
+      _offset(offset)
   {}
 
-  std::string String::inspect() const {
-    return _value;
+  String::String(std::shared_ptr<String> left, std::shared_ptr<String> right)
+    : Object(ObjectType::string_object_t),
+      _size(left->size() + right->size()),
+      _depth(std::max(left->depth(), right->depth()) + 1)
+  {
+    _left = std::move(left);
+    _right = std::move(right);
+    if (_depth > max_rope_depth) {
+      flatten();
+    }
   }
 
-  std::string String::value() const {
-    return _value;
+  String::~String() {
+    if (_interned) {
+      auto& table = intern_table();
+      std::lock_guard<std::mutex> lock(table.mutex);
+      auto it = table.strings.find(value());
+      if (it != table.strings.end() && it->second.ptr == this) {
+	table.strings.erase(it);
+      }
+    }
+  }
+
+  std::shared_ptr<String> String::intern(std::string_view value) {
+    return intern(std::make_shared<String>(std::string(value)));
+  }
+
+  std::shared_ptr<String> String::intern(std::shared_ptr<String> const& str) {
+    if (str->_interned) {
+      return str;
+    }
+
+    auto& table = intern_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto view = str->value();
+    auto it = table.strings.find(view);
+    if (it != table.strings.end()) {
+      if (auto res = it->second.ref.lock()) {
+	return res;
+      }
+      // dying, its destructor will not find itself any more
+      table.strings.erase(it);
+    }
+
+    // Other threads read it from now on, so it gets a buffer no other
+    // string shares and nothing appends into. The key views that storage,
+    // which never moves.
+    if (str->_buffer) {
+      str->_buffer = std::make_shared<std::string>(view);
+      str->_offset = 0;
+      view = str->value();
+    }
+    str->hash();
+    str->_interned = true;
+    table.strings.emplace(view, InternEntry{str.get(), str});
+    return str;
+  }
+
+  bool String::interned() const {
+    return _interned;
+  }
+
+  std::shared_ptr<String> String::concat(std::shared_ptr<String> const& left, std::shared_ptr<String> const& right) {
+    if (right->size() == 0) {
+      return left;
+    }
+    if (left->size() == 0) {
+      return right;
+    }
+
+    auto size = left->size() + right->size();
+    if (size <= small_capacity) {
+      std::string res;
+      res.reserve(size);
+      res.append(left->value());
+      res.append(right->value());
+      return std::make_shared<String>(std::move(res));
+    }
+
+    // claim the spare capacity behind left, unless other threads may be
+    // reading its buffer
+    auto& buffer = left->_buffer;
+    if (!left->is_rope() && !left->_interned && buffer != nullptr &&
+	left->_offset + left->_size == buffer->size() &&
+	buffer->size() + right->size() <= buffer->capacity()) {
+      buffer->append(right->value());
+      return std::make_shared<String>(buffer, left->_offset, size);
+    }
+
+    if (size >= rope_threshold) {
+      return std::make_shared<String>(left, right);
+    }
+
+    auto res = std::make_shared<std::string>();
+    res->reserve(size * 2);
+    res->append(left->value());
+    res->append(right->value());
+    return std::make_shared<String>(std::move(res), 0, size);
+  }
+
+  void String::write_to(Sink& sink) const {
+    sink.write(value());
+  }
+
+  std::string_view String::value() const {
+    if (is_rope()) {
+      flatten();
+    }
+    if (_buffer == nullptr) {
+      return std::string_view(_small, _size);
+    }
+    return std::string_view(_buffer->data() + _offset, _size);
+  }
+
+  std::size_t String::size() const {
+    return _size;
+  }
+
+  std::shared_ptr<String> String::substr(std::size_t pos, std::size_t len) const {
+    pos = std::min(pos, _size);
+    len = std::min(len, _size - pos);
+    // a slice of an interned string could append into its buffer
+    if (len <= small_capacity || _interned) {
+      return std::make_shared<String>(std::string(value().substr(pos, len)));
+    }
+    value();
+    return std::make_shared<String>(_buffer, _offset + pos, len);
+  }
+
+  std::uint64_t String::hash() const {
+    if (!_hashed) {
+      _hash = std::hash<std::string_view>{}(value());
+      _hashed = true;
+    }
+    return _hash;
+  }
+
+  bool String::is_rope() const {
+    return _left != nullptr;
+  }
+
+  std::size_t String::depth() const {
+    return is_rope() ? _depth : 0;
+  }
+
+  void String::flatten() const {
+    // leave room so that appending to the result can claim it in place
+    auto buffer = std::make_shared<std::string>();
+    buffer->reserve(_size * 2);
+
+    std::vector<String const*> stack{this};
+    while (!stack.empty()) {
+      auto node = stack.back();
+      stack.pop_back();
+      if (node->is_rope()) {
+	stack.push_back(node->_right.get());
+	stack.push_back(node->_left.get());
+      } else {
+	buffer->append(node->value());
+      }
+    }
+
+    _buffer = std::move(buffer);
+    _offset = 0;
+    _left.reset();
+    _right.reset();
   }
 
   // Return
   Return::Return(std::shared_ptr<Object> obj)
-    :Object(ObjectType::null_object_t),
+    :Object(ObjectType::return_object_t),
      _value(std::move(obj))
   {}
 
-  std::string Return::inspect() const {
-    return _value->inspect();
+  void Return::write_to(Sink& sink) const {
+    _value->write_to(sink);
   }
 
   std::shared_ptr<Object> Return::value() const {
@@ -77,8 +367,10 @@ namespace Void {
       _value(value)
   {}
 
-  std::string Error::inspect() const {
-    return "<error: " + _value + ">";
+  void Error::write_to(Sink& sink) const {
+    sink.write("<error: ");
+    sink.write(_value);
+    sink.put('>');
   }
 
   std::string Error::value() const {
@@ -90,19 +382,26 @@ namespace Void {
     : Object(ObjectType::null_object_t)
   {}
 
-  std::string Null::inspect() const {
-    return "null"; 
+  void Null::write_to(Sink& sink) const {
+    sink.write("null"); 
   }
 
   // Function
-  Function::Function(FunctionLiteral* func, Environment* env)
+  Function::Function(FunctionLiteral* func, std::shared_ptr<Program> program, std::shared_ptr<Environment> env)
     : Object(ObjectType::function_object_t),
-      _env(std::make_unique<Environment>(env)),
-      _function(func)
+      _function(func),
+      _program(std::move(program)),
+      _env(std::move(env))
   {}
 
-  std::string Function::inspect() const {
-    return _function->to_string();
+  Function::~Function() {
+    if (profiler::active()) {
+      profiler::retain(_program);
+    }
+  }
+
+  void Function::write_to(Sink& sink) const {
+    sink.write(_function->to_string());
   }
 
   FunctionLiteral* Function::value() const {
@@ -113,53 +412,198 @@ namespace Void {
     return _function;
   }
 
-  Environment* Function::env() const {
-    return _env.get();
+  std::shared_ptr<Program> const& Function::program() const {
+    return _program;
+  }
+
+  std::shared_ptr<Environment> const& Function::env() const {
+    return _env;
   }
 
   // Array
+  void ArrayReleaseHooks::release(std::vector<std::shared_ptr<Object>>& elems) {
+    if (auto collector = Collector::local()) {
+      collector->defer(elems);
+    }
+  }
+
   Array::Array()
     : Object(ObjectType::array_object_t)
   {}
 
-  std::string Array::inspect() const {
-    std::string res;
+  Array::Array(Elements elems)
+    : Object(ObjectType::array_object_t),
+      _elements(std::move(elems))
+  {}
+
+  void Array::write_to(Sink& sink) const {
+    if (!sink.enter()) {
+      return;
+    }
+    sink.put('[');
     bool first = false;
     for (auto& elem : _elements) {
+      if (sink.full()) {
+	break;
+      }
       if (first) {
-	res += ", ";
+	sink.write(", ");
       }
       first = true;
-      res += elem->inspect(); 
+      elem->write_to(sink); 
     }
-    return "[" + res + "]";
+    sink.put(']');
+    sink.leave();
   }
 
-  std::vector<std::shared_ptr<Object>> const& Array::value() const {
+  Array::Elements const& Array::value() const {
     return _elements; 
   }
   
-  std::vector<std::shared_ptr<Object>> const& Array::elements() const {
+  Array::Elements const& Array::elements() const {
     return _elements; 
   }
 
   void Array::append(std::shared_ptr<Object> obj) {
-    _elements.emplace_back(std::move(obj)); 
+    _elements.append(std::move(obj)); 
+  }
+
+  // IntArray
+  IntArray::IntArray()
+    : Object(ObjectType::int_array_object_t)
+  {}
+
+  IntArray::IntArray(Values values)
+    : Object(ObjectType::int_array_object_t),
+      _values(std::move(values))
+  {}
+
+  void IntArray::write_to(Sink& sink) const {
+    sink.put('[');
+    for (std::size_t i = 0; i < _values.size() && !sink.full(); ++i) {
+      if (i != 0) {
+	sink.write(", ");
+      }
+      sink.write_int(_values[i]);
+    }
+    sink.put(']');
+  }
+
+  IntArray::Values const& IntArray::values() const {
+    return _values;
+  }
+
+  // Hash
+  Hash::Hash()
+    : Object(ObjectType::hash_object_t)
+  {}
+
+  void Hash::write_to(Sink& sink) const {
+    if (!sink.enter()) {
+      return;
+    }
+    sink.put('{');
+    bool first = false;
+    for (auto& entry : _pairs.entries()) {
+      if (sink.full()) {
+	break;
+      }
+      if (first) {
+	sink.write(", ");
+      }
+      first = true;
+      entry.key->write_to(sink);
+      sink.write(": ");
+      entry.value->write_to(sink);
+    }
+    sink.put('}');
+    sink.leave();
+  }
+
+  HashTable const& Hash::pairs() const {
+    return _pairs;
+  }
+
+  std::shared_ptr<Object> Hash::get(Object const* key) const {
+    auto entry = _pairs.find(key, HashTable::hash(key));
+    return entry ? entry->value : nullptr;
+  }
+
+  void Hash::set(std::shared_ptr<Object> key, std::shared_ptr<Object> value) {
+    auto hash = HashTable::hash(key.get());
+    _pairs.insert(std::move(key), std::move(value), hash);
   }
 
   // Builtin
-  Builtin::Builtin(BuiltinFunction fn, std::string const& name)
+  Builtin::Builtin(BuiltinFunction0 fn, std::string const& name)
+    : Object(ObjectType::builtin_object_t),
+      _function0(fn),
+      _arity(0),
+      _name(name)
+  {}
+
+  Builtin::Builtin(BuiltinFunction1 fn, std::string const& name)
+    : Object(ObjectType::builtin_object_t),
+      _function1(fn),
+      _arity(1),
+      _name(name)
+  {}
+
+  Builtin::Builtin(BuiltinFunction2 fn, std::string const& name)
+    : Object(ObjectType::builtin_object_t),
+      _function2(fn),
+      _arity(2),
+      _name(name)
+  {}
+
+  Builtin::Builtin(BuiltinFunction fn, std::string const& name, int arity)
     : Object(ObjectType::builtin_object_t),
       _function(fn),
+      _arity(arity),
       _name(name)
   {}
 
-  std::string Builtin::inspect() const {
-    return "<builtin: " + _name + ">";
+  Builtin::Builtin(HostFunction host, void (*target)(), std::string const& name, int arity)
+    : Object(ObjectType::builtin_object_t),
+      _host(host),
+      _target(target),
+      _arity(arity),
+      _name(name)
+  {}
+
+  void Builtin::write_to(Sink& sink) const {
+    sink.write("<builtin: ");
+    sink.write(_name);
+    sink.put('>');
+  }
+
+  int Builtin::arity() const {
+    return _arity;
   }
 
-  std::shared_ptr<Object> Builtin::run(std::vector<std::shared_ptr<Object>> const& args) {
-    return _function(args);
+  std::string const& Builtin::name() const {
+    return _name;
+  }
+
+  std::shared_ptr<Object> Builtin::run(Args args) {
+    tracer::Span span(this);
+    if (_arity != variadic && args.size() != static_cast<std::size_t>(_arity)) {
+      return std::make_shared<Error>("wrong number of arguments");
+    }
+    if (_host) {
+      return _host(_target, args);
+    }
+    if (_function) {
+      return _function(args);
+    }
+    switch (_arity) {
+    case 0:
+      return _function0();
+    case 1:
+      return _function1(args[0]);
+    default:
+      return _function2(args[0], args[1]);
+    }
   }
   
 
@@ -168,28 +612,81 @@ namespace Void {
   std::shared_ptr<Boolean> false_obj = std::make_shared<Boolean>(false);
 
   // Environment
+  namespace {
+    // blocks of ids per thread, so making a scope touches no shared line
+    std::atomic<std::uint64_t> environment_ids{0};
+
+    std::uint64_t next_environment_id() {
+      constexpr std::uint64_t block = 1 << 20;
+      thread_local std::uint64_t next = 0, end = 0;
+      if (next == end) {
+	next = environment_ids.fetch_add(block, std::memory_order_relaxed);
+	end = next + block;
+      }
+      return ++next;
+    }
+  }
+
   Environment::Environment()
-    : _outer(nullptr)
+    : _outer(nullptr), _id(next_environment_id())
   {}
   
-  Environment::Environment(Environment* outer)
-    : _outer(outer)
+  Environment::Environment(std::shared_ptr<Environment> outer)
+    : _outer(std::move(outer)), _id(next_environment_id())
   {}
 
-  std::shared_ptr<Object> Environment::get(std::string name) {
-    auto it = _store.find(name);
-    if (it != _store.end()) {
-      return it->second;
-    } else if (_outer) {
-      auto res = _outer->get(name);
-      if (res->type() != Object::null_object_t) {
-	return res;
+  std::shared_ptr<Object> Environment::get(std::string const& name) const {
+    auto binding = lookup(name);
+    return binding.slot ? *binding.slot : null_obj;
+  }
+
+  Environment::Binding Environment::lookup(std::string const& name) const {
+    std::uint32_t hops = 0;
+    for (auto env = this; env; env = env->_outer.get(), ++hops) {
+      auto it = env->_store.find(name);
+      if (it != env->_store.end()) {
+	count_env_get(hops);
+	return {&it->second, env, hops};
       }
     }
-    return null_obj; 
+    count_env_get(hops - 1);
+    return {nullptr, nullptr, hops};
   }
 
   void Environment::set(std::string name, std::shared_ptr<Object> obj) {
-    _store[name] = std::move(obj); 
+    _names |= name_bit(name);
+    _store[std::move(name)] = std::move(obj); 
+  }
+
+  void Environment::set(std::string const& name, std::uint64_t bit, std::shared_ptr<Object> obj) {
+    _names |= bit;
+    _store[name] = std::move(obj);
+  }
+
+  void Environment::bind(FunctionLiteral const& function, Args args) {
+    auto& params = function.parameters();
+    _names |= function.parameter_names();
+    for (auto i : function.binding_order()) {
+      _store.emplace_hint(_store.end(), params[i]->value(), args[i]);
+    }
+  }
+
+  std::map<std::string, std::shared_ptr<Object>> const& Environment::store() const {
+    return _store;
+  }
+
+  std::shared_ptr<Environment> const& Environment::outer() const {
+    return _outer;
+  }
+
+  void Environment::set_outer(std::shared_ptr<Environment> outer) {
+    _outer = std::move(outer);
+  }
+
+  void Environment::clear() {
+    _store.clear();
+    _outer.reset();
+    _names = 0;
+    _id = next_environment_id();
   }
 }
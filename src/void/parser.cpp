@@ -21,6 +21,7 @@ namespace Void {
     _prefix_parse_func_map[Token::function_t] = std::bind(&Parser::parse_function_literal, this);
     _prefix_parse_func_map[Token::ident_t] = std::bind(&Parser::parse_identifier, this);
     _prefix_parse_func_map[Token::left_bracket_t] = std::bind(&Parser::parse_array_literal, this); 
+    _prefix_parse_func_map[Token::left_brace_t] = std::bind(&Parser::parse_hash_literal, this);
     
     // register infix parse function
     using std::placeholders::_1;
@@ -39,14 +40,11 @@ namespace Void {
   }
 
   Parser::Parser(std::string const& input)
-    : Parser() {
-    Lexer lexer(input);
-    Token token;
-    do {
-      token = lexer.read_token();
-      _tokens.push_back(token); 
-    } while (token.type != Token::eof_t);
+    : Parser(Lexer(input).tokenize()) {}
 
+  Parser::Parser(std::vector<Token> tokens)
+    : Parser() {
+    _tokens = std::move(tokens);
     _cur = 0;
     _nxt = 1;
     if (static_cast<std::size_t>(_cur) < _tokens.size()) {
@@ -66,6 +64,7 @@ namespace Void {
       }
       next_token(); 
     }
+    program->set_functions(std::move(_functions));
 
     return program; 
   }
@@ -126,6 +125,10 @@ namespace Void {
     next_token();
 
     if (auto expr = parse_expression(Precedence::lowest_p); expr) {
+      // functions are named after their binding in profiles
+      if (auto func = dynamic_cast<FunctionLiteral*>(expr.get())) {
+	func->set_name(stmt->identier()->value());
+      }
       stmt->set_expression(std::move(expr));
     } else {
       parse_error("expression", "let");
@@ -400,6 +403,7 @@ namespace Void {
       return nullptr;
     }
 
+    _functions.push_back(func.get());
     return func;
   }
 
@@ -426,6 +430,48 @@ namespace Void {
 
     return arr; 
   }
+
+  std::unique_ptr<Expression> Parser::parse_hash_literal() {
+    auto hash = std::make_unique<HashLiteral>(_token);
+
+    while (!peek_token_type_is(Token::right_brace_t) &&
+	   !peek_token_type_is(Token::eof_t)) {
+      next_token();
+
+      auto key = parse_expression(Precedence::lowest_p);
+      if (key == nullptr) {
+	parse_error("expression", "hash key");
+	return nullptr;
+      }
+
+      if (!expect_token_type_is(Token::colon_t)) {
+	parse_error(Token::colon_t, peek_token());
+	return nullptr;
+      }
+
+      next_token();
+
+      auto value = parse_expression(Precedence::lowest_p);
+      if (value == nullptr) {
+	parse_error("expression", "hash value");
+	return nullptr;
+      }
+      hash->append(std::move(key), std::move(value));
+
+      if (!peek_token_type_is(Token::right_brace_t) &&
+	  !expect_token_type_is(Token::comma_t)) {
+	parse_error(Token::comma_t, peek_token());
+	return nullptr;
+      }
+    }
+
+    if (!expect_token_type_is(Token::right_brace_t)) {
+      parse_error(Token::right_brace_t, peek_token());
+      return nullptr;
+    }
+
+    return hash;
+  }
   
   Token Parser::next_token() {
     _cur = _nxt++;
@@ -0,0 +1,340 @@
+#include <void/perf_counters.hpp>
+#include <void/ast.hpp>
+#include <void/profiler.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Void {
+  namespace perf_counters {
+    namespace detail {
+      std::atomic<bool> counting{false};
+    }
+
+    namespace {
+      using Values = std::array<std::uint64_t, event_count>;
+
+      // one perf_event_open group of the calling thread, a slot is the
+      // position of an event in what the leader reads, -1 if not opened
+      struct Group {
+	int leader{-1};
+	std::array<int, event_count> fds;
+	std::array<int, event_count> slots;
+
+	Group() {
+	  fds.fill(-1);
+	  slots.fill(-1);
+	}
+      };
+
+#if defined(__linux__)
+      bool config_of(Event event, __u32& type, __u64& config) {
+	switch (event) {
+	case cycles: type = PERF_TYPE_HARDWARE; config = PERF_COUNT_HW_CPU_CYCLES; return true;
+	case instructions: type = PERF_TYPE_HARDWARE; config = PERF_COUNT_HW_INSTRUCTIONS; return true;
+	case cache_misses: type = PERF_TYPE_HARDWARE; config = PERF_COUNT_HW_CACHE_MISSES; return true;
+	case branch_misses: type = PERF_TYPE_HARDWARE; config = PERF_COUNT_HW_BRANCH_MISSES; return true;
+	case task_clock: type = PERF_TYPE_SOFTWARE; config = PERF_COUNT_SW_TASK_CLOCK; return true;
+	case event_count: break;
+	}
+	return false;
+      }
+
+      // user space only, which perf_event_paranoid 2 still allows
+      Group open_group() {
+	Group group;
+	int next_slot = 0;
+	for (std::size_t i = 0; i < event_count; ++i) {
+	  perf_event_attr attr{};
+	  attr.size = sizeof(attr);
+	  if (!config_of(static_cast<Event>(i), attr.type, attr.config)) {
+	    continue;
+	  }
+	  attr.read_format = PERF_FORMAT_GROUP;
+	  attr.exclude_kernel = 1;
+	  attr.exclude_hv = 1;
+	  auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group.leader, 0));
+	  if (fd < 0) {
+	    continue;
+	  }
+	  if (group.leader < 0) {
+	    group.leader = fd;
+	  }
+	  group.fds[i] = fd;
+	  group.slots[i] = next_slot++;
+	}
+	return group;
+      }
+
+      void close_group(Group& group) {
+	for (auto& fd : group.fds) {
+	  if (fd >= 0) {
+	    close(fd);
+	  }
+	}
+	group = Group();
+      }
+
+      bool read_group(Group const& group, Values& values) {
+	std::uint64_t buf[1 + event_count];
+	if (group.leader < 0 || read(group.leader, buf, sizeof(buf)) < static_cast<ssize_t>(sizeof(std::uint64_t))) {
+	  return false;
+	}
+	for (std::size_t i = 0; i < event_count; ++i) {
+	  values[i] = group.slots[i] >= 0 && static_cast<std::uint64_t>(group.slots[i]) < buf[0] ? buf[1 + group.slots[i]] : 0;
+	}
+	return true;
+      }
+#else
+      Group open_group() {
+	return Group();
+      }
+
+      void close_group(Group&) {}
+
+      bool read_group(Group const&, Values&) {
+	return false;
+      }
+#endif
+
+      // Owned by its thread, which charges under the mutex. report() and
+      // start() take it from other threads, so it is never contended
+      // for long. Never freed, the counts outlive the thread.
+      struct ThreadData {
+	std::mutex mutex;
+	Group group;
+	unsigned generation{};
+	std::vector<Entry> entries; // [main] first
+	std::unordered_map<FunctionLiteral const*, std::size_t> ids;
+	std::vector<std::size_t> stack;
+	Values last{};
+
+	void clear() {
+	  entries.assign(1, {profiler::frame_name(nullptr), 0, {}});
+	  ids.clear();
+	}
+
+	// charges what the group counted since the last read
+	void charge() {
+	  Values now;
+	  if (!read_group(group, now)) {
+	    return;
+	  }
+	  auto& values = entries[stack.empty() ? 0 : stack.back()].values;
+	  for (std::size_t i = 0; i < event_count; ++i) {
+	    values[i] += now[i] - last[i];
+	  }
+	  last = now;
+	}
+      };
+
+      std::mutex mutex;
+      std::vector<std::unique_ptr<ThreadData>> threads;
+      std::array<bool, event_count> opened{};
+      // bumped by start() and reset()
+      std::atomic<unsigned> generation{0};
+
+      // closes the group when its thread exits
+      struct Owner {
+	ThreadData* data{};
+
+	~Owner() {
+	  if (data) {
+	    std::lock_guard<std::mutex> lock(data->mutex);
+	    close_group(data->group);
+	  }
+	}
+      };
+      thread_local Owner owner;
+
+      ThreadData& thread_data() {
+	if (!owner.data) {
+	  std::lock_guard<std::mutex> lock(mutex);
+	  threads.push_back(std::make_unique<ThreadData>());
+	  owner.data = threads.back().get();
+	  owner.data->group = open_group();
+	  owner.data->generation = generation.load();
+	  owner.data->clear();
+	  read_group(owner.data->group, owner.data->last);
+	}
+	return *owner.data;
+      }
+
+      std::size_t entry_id(ThreadData& data, FunctionLiteral const* function) {
+	auto [it, inserted] = data.ids.emplace(function, data.entries.size());
+	if (inserted) {
+	  data.entries.push_back({profiler::frame_name(function), 0, {}});
+	}
+	return it->second;
+      }
+
+      // a frame entered before is not charged on return
+      void clear_threads() {
+	auto current = generation.fetch_add(1) + 1;
+	for (auto& data : threads) {
+	  std::lock_guard<std::mutex> lock(data->mutex);
+	  data->clear();
+	  data->stack.clear();
+	  data->generation = current;
+	  read_group(data->group, data->last);
+	}
+      }
+    }
+
+    char const* to_string(Event event) {
+      switch (event) {
+      case cycles: return "cycles";
+      case instructions: return "instructions";
+      case cache_misses: return "cache_misses";
+      case branch_misses: return "branch_misses";
+      case task_clock: return "task_clock";
+      case event_count: break;
+      }
+      return "unknown";
+    }
+
+    bool start() {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (active()) {
+	return false;
+      }
+      // a thread opens its own group on its first call, this probe tells
+      // which events it will get
+      auto probe = open_group();
+      for (std::size_t i = 0; i < event_count; ++i) {
+	opened[i] = probe.slots[i] >= 0;
+      }
+      bool any = probe.leader >= 0;
+      close_group(probe);
+      if (!any) {
+	return false;
+      }
+      clear_threads();
+      detail::counting.store(true);
+      return true;
+    }
+
+    void stop() {
+      std::lock_guard<std::mutex> lock(mutex);
+      detail::counting.store(false);
+      // waits for charges in flight
+      for (auto& data : threads) {
+	std::lock_guard<std::mutex> data_lock(data->mutex);
+      }
+    }
+
+    std::array<bool, event_count> available() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return opened;
+    }
+
+    double Entry::ipc() const {
+      return values[cycles] ? static_cast<double>(values[instructions]) / static_cast<double>(values[cycles]) : 0;
+    }
+
+    double Entry::per_kilo_instruction(Event event) const {
+      return values[instructions] ? 1000.0 * static_cast<double>(values[event]) / static_cast<double>(values[instructions]) : 0;
+    }
+
+    std::vector<Entry> report() {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::unordered_map<std::string, Entry> by_name;
+      for (auto& data : threads) {
+	std::lock_guard<std::mutex> data_lock(data->mutex);
+	for (auto& entry : data->entries) {
+	  auto [it, inserted] = by_name.emplace(entry.name, entry);
+	  if (!inserted) {
+	    it->second.calls += entry.calls;
+	    for (std::size_t i = 0; i < event_count; ++i) {
+	      it->second.values[i] += entry.values[i];
+	    }
+	  }
+	}
+      }
+
+      std::vector<Entry> res;
+      for (auto& [name, entry] : by_name) {
+	if (entry.calls || std::any_of(entry.values.begin(), entry.values.end(), [](std::uint64_t v) { return v != 0; })) {
+	  res.push_back(std::move(entry));
+	}
+      }
+      auto key = opened[cycles] ? cycles : task_clock;
+      std::sort(res.begin(), res.end(), [key](Entry const& a, Entry const& b) {
+	return a.values[key] != b.values[key] ? a.values[key] > b.values[key] : a.name < b.name;
+      });
+      return res;
+    }
+
+    void write_report(std::ostream& os) {
+      auto open = available();
+      auto entries = report();
+      os << "perf counters:";
+      for (std::size_t i = 0; i < event_count; ++i) {
+	os << ' ' << to_string(static_cast<Event>(i)) << (open[i] ? "" : " (unavailable)");
+      }
+      os << "\n       calls         cycles   instructions   IPC  cache-miss/ki  branch-miss/ki   task-ms  function\n";
+
+      char line[160];
+      auto count = [&](Entry const& entry, Event event) -> std::string {
+	return open[event] ? std::to_string(entry.values[event]) : "-";
+      };
+      auto ratio = [&](double value, bool known) -> std::string {
+	if (!known) {
+	  return "-";
+	}
+	char buf[32];
+	std::snprintf(buf, sizeof(buf), "%.2f", value);
+	return buf;
+      };
+      for (auto& entry : entries) {
+	bool ipc = open[cycles] && open[instructions];
+	std::snprintf(line, sizeof(line), "%12llu %14s %14s %5s %14s %15s %9s  ",
+		      static_cast<unsigned long long>(entry.calls), count(entry, cycles).c_str(),
+		      count(entry, instructions).c_str(), ratio(entry.ipc(), ipc).c_str(),
+		      ratio(entry.per_kilo_instruction(cache_misses), open[instructions] && open[cache_misses]).c_str(),
+		      ratio(entry.per_kilo_instruction(branch_misses), open[instructions] && open[branch_misses]).c_str(),
+		      ratio(static_cast<double>(entry.values[task_clock]) / 1e6, open[task_clock]).c_str());
+	os << line << entry.name << '\n';
+      }
+    }
+
+    void reset() {
+      std::lock_guard<std::mutex> lock(mutex);
+      clear_threads();
+    }
+
+    void Scope::enter(FunctionLiteral const* function) {
+      auto& data = thread_data();
+      std::lock_guard<std::mutex> lock(data.mutex);
+      if (!detail::counting.load()) {
+	return;
+      }
+      data.charge();
+      auto id = entry_id(data, function);
+      ++data.entries[id].calls;
+      data.stack.push_back(id);
+      _entered = true;
+      _generation = data.generation;
+    }
+
+    void Scope::leave() {
+      auto& data = *owner.data;
+      std::lock_guard<std::mutex> lock(data.mutex);
+      // a start() or reset() since enter() dropped the frame
+      if (!detail::counting.load() || data.generation != _generation || data.stack.empty()) {
+	return;
+      }
+      data.charge();
+      data.stack.pop_back();
+    }
+  }
+}
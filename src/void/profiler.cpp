@@ -0,0 +1,289 @@
+#include <void/profiler.hpp>
+#include <void/ast.hpp>
+
+#include <algorithm>
+#include <csignal>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/time.h>
+
+namespace Void {
+  namespace {
+    thread_local CallStack* current_stack = nullptr;
+
+    // A sample is a header slot, function nullptr and line the number of
+    // frames, followed by its frames from the outermost in. A header with
+    // line -1 marks where a sample did not fit and the buffer ends.
+    constexpr std::size_t buffer_slots = std::size_t{1} << 20;
+    std::unique_ptr<CallStack::Frame[]> buffer;
+    std::atomic<std::size_t> used{0};
+    std::atomic<std::uint64_t> samples{0};
+    std::atomic<std::uint64_t> dropped{0};
+    std::atomic<bool> running{false};
+    std::atomic<int> in_handler{0};
+
+    std::chrono::microseconds period{};
+    std::chrono::system_clock::time_point started;
+    std::chrono::steady_clock::duration duration{};
+
+    std::mutex retained_mutex;
+    std::unordered_map<Program const*, std::shared_ptr<Program>> retained;
+
+    void on_sample(int) {
+      in_handler.fetch_add(1, std::memory_order_acquire);
+      if (running.load(std::memory_order_relaxed)) {
+	auto stack = current_stack;
+	std::uint32_t depth = stack ? std::min(stack->depth(), CallStack::capacity) : 0;
+	std::atomic_signal_fence(std::memory_order_acquire);
+
+	auto pos = used.fetch_add(depth + 1, std::memory_order_relaxed);
+	if (pos + depth + 1 <= buffer_slots) {
+	  buffer[pos] = {nullptr, static_cast<std::int32_t>(depth)};
+	  std::copy(stack ? stack->frames() : nullptr, stack ? stack->frames() + depth : nullptr, buffer.get() + pos + 1);
+	  samples.fetch_add(1, std::memory_order_relaxed);
+	} else {
+	  if (pos < buffer_slots) {
+	    buffer[pos] = {nullptr, -1};
+	  }
+	  dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+      }
+      in_handler.fetch_sub(1, std::memory_order_release);
+    }
+
+    using Stack = std::vector<std::pair<FunctionLiteral const*, std::int32_t>>;
+
+    // distinct stacks, outermost frame first, and how often they were seen
+    std::map<Stack, std::uint64_t> aggregate() {
+      std::map<Stack, std::uint64_t> res;
+      auto end = std::min(used.load(), buffer_slots);
+      Stack stack;
+      for (std::size_t pos = 0; pos < end;) {
+	auto count = buffer[pos].line;
+	if (count < 0 || pos + 1 + count > end) {
+	  break;
+	}
+	stack.clear();
+	for (std::int32_t i = 0; i < count; ++i) {
+	  auto& frame = buffer[pos + 1 + i];
+	  stack.emplace_back(frame.function, frame.line);
+	}
+	++res[stack];
+	pos += 1 + count;
+      }
+      return res;
+    }
+
+    // protobuf wire format, just what profile.proto needs
+    void put_varint(std::string& out, std::uint64_t value) {
+      while (value >= 0x80) {
+	out.push_back(static_cast<char>(value | 0x80));
+	value >>= 7;
+      }
+      out.push_back(static_cast<char>(value));
+    }
+
+    void put_int(std::string& out, int field, std::uint64_t value) {
+      put_varint(out, static_cast<std::uint64_t>(field) << 3);
+      put_varint(out, value);
+    }
+
+    void put_bytes(std::string& out, int field, std::string const& bytes) {
+      put_varint(out, static_cast<std::uint64_t>(field) << 3 | 2);
+      put_varint(out, bytes.size());
+      out += bytes;
+    }
+
+    void put_packed(std::string& out, int field, std::vector<std::uint64_t> const& values) {
+      std::string packed;
+      for (auto value : values) {
+	put_varint(packed, value);
+      }
+      put_bytes(out, field, packed);
+    }
+  }
+
+  // CallStack
+  CallStack::CallStack()
+    : _frames(std::make_unique<Frame[]>(capacity)) {}
+
+  CallStack::Activation::Activation(CallStack& stack)
+    : _outer(current_stack) {
+    current_stack = &stack;
+  }
+
+  CallStack::Activation::~Activation() {
+    current_stack = _outer;
+  }
+
+  namespace profiler {
+    bool start(std::chrono::microseconds interval) {
+      if (running.load() || interval.count() <= 0) {
+	return false;
+      }
+      if (!buffer) {
+	buffer = std::make_unique<CallStack::Frame[]>(buffer_slots);
+      }
+      reset();
+
+      // the handler stays installed after stop, a late SIGPROF must not
+      // take the default action and kill the process
+      struct sigaction action{};
+      action.sa_handler = on_sample;
+      action.sa_flags = SA_RESTART;
+      sigemptyset(&action.sa_mask);
+      if (sigaction(SIGPROF, &action, nullptr) != 0) {
+	return false;
+      }
+
+      period = interval;
+      started = std::chrono::system_clock::now();
+      duration = -std::chrono::steady_clock::now().time_since_epoch();
+      running.store(true);
+
+      itimerval timer{};
+      timer.it_interval.tv_sec = interval.count() / 1000000;
+      timer.it_interval.tv_usec = interval.count() % 1000000;
+      timer.it_value = timer.it_interval;
+      if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+	running.store(false);
+	return false;
+      }
+      return true;
+    }
+
+    void stop() {
+      if (!running.load()) {
+	return;
+      }
+      itimerval timer{};
+      setitimer(ITIMER_PROF, &timer, nullptr);
+      running.store(false);
+      while (in_handler.load(std::memory_order_acquire) != 0) {
+	std::this_thread::yield();
+      }
+      duration += std::chrono::steady_clock::now().time_since_epoch();
+    }
+
+    bool active() {
+      return running.load(std::memory_order_relaxed);
+    }
+
+    void retain(std::shared_ptr<Program> const& program) {
+      // samples only point at function literals
+      if (!program || program->functions().empty()) {
+	return;
+      }
+      std::lock_guard<std::mutex> lock(retained_mutex);
+      retained.emplace(program.get(), program);
+    }
+
+    Summary summary() {
+      return {samples.load(), dropped.load()};
+    }
+
+    void write_folded(std::ostream& os) {
+      for (auto& [stack, count] : aggregate()) {
+	if (stack.empty()) {
+	  os << "[host]";
+	}
+	for (std::size_t i = 0; i < stack.size(); ++i) {
+	  os << (i ? ";" : "") << frame_name(stack[i].first) << ':' << stack[i].second;
+	}
+	os << ' ' << count << '\n';
+      }
+    }
+
+    void write_pprof(std::ostream& os) {
+      std::vector<std::string> strings{""};
+      std::map<std::string, std::uint64_t> string_ids{{"", 0}};
+      auto string_id = [&](std::string const& str) {
+	auto [it, inserted] = string_ids.emplace(str, strings.size());
+	if (inserted) {
+	  strings.push_back(str);
+	}
+	return it->second;
+      };
+      std::map<FunctionLiteral const*, std::uint64_t> function_ids;
+      std::map<std::pair<FunctionLiteral const*, std::int32_t>, std::uint64_t> location_ids;
+
+      std::string profile;
+      auto value_type = [&](std::string const& type, std::string const& unit) {
+	std::string res;
+	put_int(res, 1, string_id(type));
+	put_int(res, 2, string_id(unit));
+	return res;
+      };
+      put_bytes(profile, 1, value_type("samples", "count"));
+      put_bytes(profile, 1, value_type("cpu", "nanoseconds"));
+
+      auto period_ns = static_cast<std::uint64_t>(std::chrono::nanoseconds(period).count());
+      for (auto& [stack, count] : aggregate()) {
+	std::vector<std::uint64_t> locations;
+	// pprof lists the leaf first
+	for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+	  auto [loc, inserted] = location_ids.emplace(*it, location_ids.size() + 1);
+	  function_ids.emplace(it->first, function_ids.size() + 1);
+	  locations.push_back(loc->second);
+	}
+	std::string sample;
+	put_packed(sample, 1, locations);
+	put_packed(sample, 2, {count, count * period_ns});
+	put_bytes(profile, 2, sample);
+      }
+
+      for (auto& [frame, id] : location_ids) {
+	std::string line;
+	put_int(line, 1, function_ids.at(frame.first));
+	put_int(line, 2, static_cast<std::uint64_t>(frame.second));
+	std::string location;
+	put_int(location, 1, id);
+	put_bytes(location, 4, line);
+	put_bytes(profile, 4, location);
+      }
+      for (auto& [function, id] : function_ids) {
+	std::string message;
+	put_int(message, 1, id);
+	put_int(message, 2, string_id(frame_name(function)));
+	put_int(message, 3, string_id(frame_name(function)));
+	put_int(message, 4, string_id("<script>"));
+	put_int(message, 5, function ? function->line() : 0);
+	put_bytes(profile, 5, message);
+      }
+
+      put_int(profile, 9, std::chrono::duration_cast<std::chrono::nanoseconds>(started.time_since_epoch()).count());
+      put_int(profile, 10, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+      put_bytes(profile, 11, value_type("cpu", "nanoseconds"));
+      put_int(profile, 12, period_ns);
+      // the string table goes last, every id above has been handed out
+      for (auto& str : strings) {
+	put_bytes(profile, 6, str);
+      }
+      os.write(profile.data(), profile.size());
+    }
+
+    std::string frame_name(FunctionLiteral const* function) {
+      if (!function) {
+	return "[main]";
+      }
+      if (!function->name().empty()) {
+	return function->name();
+      }
+      return "fn@" + std::to_string(function->line());
+    }
+
+    void reset() {
+      used.store(0);
+      samples.store(0);
+      dropped.store(0);
+      std::lock_guard<std::mutex> lock(retained_mutex);
+      retained.clear();
+    }
+  }
+}
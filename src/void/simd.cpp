@@ -0,0 +1,384 @@
+#include <void/simd.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VOID_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace Void {
+  namespace simd {
+    namespace {
+      struct AddOp {
+	static bool scalar(std::int64_t x, std::int64_t y, std::int64_t* res) {
+	  return !__builtin_add_overflow(x, y, res);
+	}
+      };
+
+      struct SubOp {
+	static bool scalar(std::int64_t x, std::int64_t y, std::int64_t* res) {
+	  return !__builtin_sub_overflow(x, y, res);
+	}
+      };
+
+      struct RSubOp {
+	static bool scalar(std::int64_t x, std::int64_t y, std::int64_t* res) {
+	  return !__builtin_sub_overflow(y, x, res);
+	}
+      };
+
+      struct MulOp {
+	static bool scalar(std::int64_t x, std::int64_t y, std::int64_t* res) {
+	  return !__builtin_mul_overflow(x, y, res);
+	}
+      };
+
+      // portable kernels
+
+      bool sum_scalar(std::int64_t const* a, std::size_t n, std::int64_t& res) {
+	std::int64_t acc = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+	  if (__builtin_add_overflow(acc, a[i], &acc)) {
+	    return false;
+	  }
+	}
+	res = acc;
+	return true;
+      }
+
+      bool dot_scalar(std::int64_t const* a, std::int64_t const* b, std::size_t n, std::int64_t& res) {
+	std::int64_t acc = 0, prod;
+	for (std::size_t i = 0; i < n; ++i) {
+	  if (__builtin_mul_overflow(a[i], b[i], &prod) || __builtin_add_overflow(acc, prod, &acc)) {
+	    return false;
+	  }
+	}
+	res = acc;
+	return true;
+      }
+
+      std::int64_t min_scalar(std::int64_t const* a, std::size_t n) {
+	auto res = a[0];
+	for (std::size_t i = 1; i < n; ++i) {
+	  res = a[i] < res ? a[i] : res;
+	}
+	return res;
+      }
+
+      std::int64_t max_scalar(std::int64_t const* a, std::size_t n) {
+	auto res = a[0];
+	for (std::size_t i = 1; i < n; ++i) {
+	  res = a[i] > res ? a[i] : res;
+	}
+	return res;
+      }
+
+      // with Broadcast, b points to a single value used for every element
+      template <typename Op, bool Broadcast>
+      bool binary_scalar(std::int64_t const* a, std::int64_t const* b, std::int64_t* out, std::size_t n) {
+	for (std::size_t i = 0; i < n; ++i) {
+	  if (!Op::scalar(a[i], Broadcast ? b[0] : b[i], out + i)) {
+	    return false;
+	  }
+	}
+	return true;
+      }
+
+#if VOID_SIMD_X86
+#define VOID_AVX2 __attribute__((target("avx2")))
+
+      VOID_AVX2 __m256i load(std::int64_t const* p) {
+	return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+      }
+
+      VOID_AVX2 void store(std::int64_t* p, __m256i v) {
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+      }
+
+      VOID_AVX2 bool any_sign(__m256i v) {
+	return _mm256_movemask_pd(_mm256_castsi256_pd(v)) != 0;
+      }
+
+      // every lane equals its low 32 bits sign extended
+      VOID_AVX2 bool fits32(__m256i v) {
+	auto lo = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+	auto ext = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(lo));
+	return _mm256_movemask_epi8(_mm256_cmpeq_epi64(v, ext)) == -1;
+      }
+
+      // r = x + y, the sign bit of ovf is set in lanes that overflowed
+      VOID_AVX2 __m256i add_checked(__m256i x, __m256i y, __m256i& ovf) {
+	auto r = _mm256_add_epi64(x, y);
+	ovf = _mm256_or_si256(ovf, _mm256_and_si256(_mm256_xor_si256(x, r), _mm256_xor_si256(y, r)));
+	return r;
+      }
+
+      VOID_AVX2 __m256i sub_checked(__m256i x, __m256i y, __m256i& ovf) {
+	auto r = _mm256_sub_epi64(x, y);
+	ovf = _mm256_or_si256(ovf, _mm256_and_si256(_mm256_xor_si256(x, y), _mm256_xor_si256(x, r)));
+	return r;
+      }
+
+      VOID_AVX2 bool reduce_add(__m256i acc, std::int64_t tail, std::int64_t& res) {
+	alignas(32) std::int64_t lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+	for (auto lane : lanes) {
+	  if (__builtin_add_overflow(tail, lane, &tail)) {
+	    return false;
+	  }
+	}
+	res = tail;
+	return true;
+      }
+
+      VOID_AVX2 bool sum_avx2(std::int64_t const* a, std::size_t n, std::int64_t& res) {
+	auto acc = _mm256_setzero_si256(), ovf = _mm256_setzero_si256();
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+	  acc = add_checked(acc, load(a + i), ovf);
+	}
+	std::int64_t tail = 0;
+	for (; i < n; ++i) {
+	  if (__builtin_add_overflow(tail, a[i], &tail)) {
+	    return false;
+	  }
+	}
+	return !any_sign(ovf) && reduce_add(acc, tail, res);
+      }
+
+      // AVX2 has no 64 bit multiply; chunks whose lanes fit in 32 bits use
+      // the exact 32x32->64 multiply, others go through the checked scalar path
+      VOID_AVX2 bool dot_avx2(std::int64_t const* a, std::int64_t const* b, std::size_t n, std::int64_t& res) {
+	auto acc = _mm256_setzero_si256(), ovf = _mm256_setzero_si256();
+	std::int64_t tail = 0, prod;
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+	  auto x = load(a + i), y = load(b + i);
+	  if (fits32(x) && fits32(y)) {
+	    acc = add_checked(acc, _mm256_mul_epi32(x, y), ovf);
+	    continue;
+	  }
+	  for (std::size_t j = i; j < i + 4; ++j) {
+	    if (__builtin_mul_overflow(a[j], b[j], &prod) || __builtin_add_overflow(tail, prod, &tail)) {
+	      return false;
+	    }
+	  }
+	}
+	for (; i < n; ++i) {
+	  if (__builtin_mul_overflow(a[i], b[i], &prod) || __builtin_add_overflow(tail, prod, &tail)) {
+	    return false;
+	  }
+	}
+	return !any_sign(ovf) && reduce_add(acc, tail, res);
+      }
+
+      VOID_AVX2 std::int64_t min_avx2(std::int64_t const* a, std::size_t n) {
+	if (n < 4) {
+	  return min_scalar(a, n);
+	}
+	auto acc = load(a);
+	std::size_t i = 4;
+	for (; i + 4 <= n; i += 4) {
+	  auto v = load(a + i);
+	  acc = _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(acc, v));
+	}
+	alignas(32) std::int64_t lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+	auto res = min_scalar(lanes, 4);
+	for (; i < n; ++i) {
+	  res = a[i] < res ? a[i] : res;
+	}
+	return res;
+      }
+
+      VOID_AVX2 std::int64_t max_avx2(std::int64_t const* a, std::size_t n) {
+	if (n < 4) {
+	  return max_scalar(a, n);
+	}
+	auto acc = load(a);
+	std::size_t i = 4;
+	for (; i + 4 <= n; i += 4) {
+	  auto v = load(a + i);
+	  acc = _mm256_blendv_epi8(acc, v, _mm256_cmpgt_epi64(v, acc));
+	}
+	alignas(32) std::int64_t lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+	auto res = max_scalar(lanes, 4);
+	for (; i < n; ++i) {
+	  res = a[i] > res ? a[i] : res;
+	}
+	return res;
+      }
+
+      struct AddVec {
+	VOID_AVX2 static bool apply(__m256i x, __m256i y, std::int64_t* out, __m256i& ovf) {
+	  store(out, add_checked(x, y, ovf));
+	  return true;
+	}
+      };
+
+      struct SubVec {
+	VOID_AVX2 static bool apply(__m256i x, __m256i y, std::int64_t* out, __m256i& ovf) {
+	  store(out, sub_checked(x, y, ovf));
+	  return true;
+	}
+      };
+
+      struct RSubVec {
+	VOID_AVX2 static bool apply(__m256i x, __m256i y, std::int64_t* out, __m256i& ovf) {
+	  store(out, sub_checked(y, x, ovf));
+	  return true;
+	}
+      };
+
+      struct MulVec {
+	// checks each lane itself instead of accumulating into ovf
+	VOID_AVX2 static bool apply(__m256i x, __m256i y, std::int64_t* out, __m256i&) {
+	  if (fits32(x) && fits32(y)) {
+	    store(out, _mm256_mul_epi32(x, y));
+	    return true;
+	  }
+	  alignas(32) std::int64_t xs[4], ys[4];
+	  _mm256_store_si256(reinterpret_cast<__m256i*>(xs), x);
+	  _mm256_store_si256(reinterpret_cast<__m256i*>(ys), y);
+	  for (int i = 0; i < 4; ++i) {
+	    if (__builtin_mul_overflow(xs[i], ys[i], out + i)) {
+	      return false;
+	    }
+	  }
+	  return true;
+	}
+      };
+
+      template <typename Op, typename Vec, bool Broadcast>
+      VOID_AVX2 bool binary_avx2(std::int64_t const* a, std::int64_t const* b, std::int64_t* out, std::size_t n) {
+	auto ovf = _mm256_setzero_si256();
+	auto s = _mm256_set1_epi64x(Broadcast ? b[0] : 0);
+	std::size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+	  if (!Vec::apply(load(a + i), Broadcast ? s : load(b + i), out + i, ovf)) {
+	    return false;
+	  }
+	}
+	return !any_sign(ovf) && binary_scalar<Op, Broadcast>(a + i, Broadcast ? b : b + i, out + i, n - i);
+      }
+#endif
+
+      struct Kernels {
+	bool (*sum)(std::int64_t const*, std::size_t, std::int64_t&);
+	bool (*dot)(std::int64_t const*, std::int64_t const*, std::size_t, std::int64_t&);
+	std::int64_t (*min)(std::int64_t const*, std::size_t);
+	std::int64_t (*max)(std::int64_t const*, std::size_t);
+	bool (*add)(std::int64_t const*, std::int64_t const*, std::int64_t*, std::size_t);
+	bool (*sub)(std::int64_t const*, std::int64_t const*, std::int64_t*, std::size_t);
+	bool (*mul)(std::int64_t const*, std::int64_t const*, std::int64_t*, std::size_t);
+	bool (*add_scalar)(std::int64_t const*, std::int64_t const*, std::int64_t*, std::size_t);
+	bool (*sub_scalar)(std::int64_t const*, std::int64_t const*, std::int64_t*, std::size_t);
+	bool (*rsub_scalar)(std::int64_t const*, std::int64_t const*, std::int64_t*, std::size_t);
+	bool (*mul_scalar)(std::int64_t const*, std::int64_t const*, std::int64_t*, std::size_t);
+      };
+
+      Kernels const scalar_kernels = {
+	sum_scalar,
+	dot_scalar,
+	min_scalar,
+	max_scalar,
+	binary_scalar<AddOp, false>,
+	binary_scalar<SubOp, false>,
+	binary_scalar<MulOp, false>,
+	binary_scalar<AddOp, true>,
+	binary_scalar<SubOp, true>,
+	binary_scalar<RSubOp, true>,
+	binary_scalar<MulOp, true>,
+      };
+
+#if VOID_SIMD_X86
+      Kernels const avx2_kernels = {
+	sum_avx2,
+	dot_avx2,
+	min_avx2,
+	max_avx2,
+	binary_avx2<AddOp, AddVec, false>,
+	binary_avx2<SubOp, SubVec, false>,
+	binary_avx2<MulOp, MulVec, false>,
+	binary_avx2<AddOp, AddVec, true>,
+	binary_avx2<SubOp, SubVec, true>,
+	binary_avx2<RSubOp, RSubVec, true>,
+	binary_avx2<MulOp, MulVec, true>,
+      };
+#endif
+
+      Kernels const* kernels_for(Isa isa) {
+#if VOID_SIMD_X86
+	if (isa == Isa::avx2) {
+	  return &avx2_kernels;
+	}
+#endif
+	return &scalar_kernels;
+      }
+
+      Kernels const* active = kernels_for(best_isa());
+    }
+
+    Isa best_isa() {
+#if VOID_SIMD_X86
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) {
+	return Isa::avx2;
+      }
+#endif
+      return Isa::scalar;
+    }
+
+    Isa isa() {
+      return active == &scalar_kernels ? Isa::scalar : Isa::avx2;
+    }
+
+    void set_isa(Isa isa) {
+      active = kernels_for(isa == Isa::avx2 && best_isa() == Isa::avx2 ? Isa::avx2 : Isa::scalar);
+    }
+
+    bool sum(std::int64_t const* a, std::size_t n, std::int64_t& res) {
+      return active->sum(a, n, res);
+    }
+
+    bool dot(std::int64_t const* a, std::int64_t const* b, std::size_t n, std::int64_t& res) {
+      return active->dot(a, b, n, res);
+    }
+
+    std::int64_t min(std::int64_t const* a, std::size_t n) {
+      return active->min(a, n);
+    }
+
+    std::int64_t max(std::int64_t const* a, std::size_t n) {
+      return active->max(a, n);
+    }
+
+    bool add(std::int64_t const* a, std::int64_t const* b, std::int64_t* out, std::size_t n) {
+      return active->add(a, b, out, n);
+    }
+
+    bool sub(std::int64_t const* a, std::int64_t const* b, std::int64_t* out, std::size_t n) {
+      return active->sub(a, b, out, n);
+    }
+
+    bool mul(std::int64_t const* a, std::int64_t const* b, std::int64_t* out, std::size_t n) {
+      return active->mul(a, b, out, n);
+    }
+
+    bool add_scalar(std::int64_t const* a, std::int64_t s, std::int64_t* out, std::size_t n) {
+      return active->add_scalar(a, &s, out, n);
+    }
+
+    bool sub_scalar(std::int64_t const* a, std::int64_t s, std::int64_t* out, std::size_t n) {
+      return active->sub_scalar(a, &s, out, n);
+    }
+
+    bool rsub_scalar(std::int64_t const* a, std::int64_t s, std::int64_t* out, std::size_t n) {
+      return active->rsub_scalar(a, &s, out, n);
+    }
+
+    bool mul_scalar(std::int64_t const* a, std::int64_t s, std::int64_t* out, std::size_t n) {
+      return active->mul_scalar(a, &s, out, n);
+    }
+  }
+}
@@ -0,0 +1,124 @@
+#include <void/sink.hpp>
+
+#include <charconv>
+#include <cstring>
+
+namespace Void {
+  // Sink
+  Sink::Sink(PrintLimits limits)
+    : _limits(limits) {}
+
+  void Sink::write(std::string_view str) {
+    if (_truncated) {
+      return;
+    }
+    auto size = str.size();
+    if (size > _limits.max_size - _written) {
+      size = _limits.max_size - _written;
+    }
+
+    if (_used + size > buffer_size) {
+      flush();
+    }
+    if (size > buffer_size) {
+      write_out(str.data(), size);
+    } else {
+      std::memcpy(_buffer + _used, str.data(), size);
+      _used += size;
+    }
+    _written += size;
+
+    if (size < str.size()) {
+      mark_truncated();
+    }
+  }
+
+  void Sink::put(char c) {
+    if (_used < buffer_size && _written < _limits.max_size) {
+      _buffer[_used++] = c;
+      ++_written;
+    } else {
+      write(std::string_view(&c, 1));
+    }
+  }
+
+  void Sink::write_int(std::int64_t value) {
+    char buf[24];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+    write(std::string_view(buf, end - buf));
+  }
+
+  void Sink::finish(std::string_view str) {
+    // not counted against the size limit, like the "..." marker
+    if (_used + str.size() > buffer_size) {
+      flush();
+    }
+    if (str.size() > buffer_size) {
+      write_out(str.data(), str.size());
+    } else {
+      std::memcpy(_buffer + _used, str.data(), str.size());
+      _used += str.size();
+    }
+  }
+
+  void Sink::flush() {
+    if (_used != 0) {
+      write_out(_buffer, _used);
+      _used = 0;
+    }
+  }
+
+  bool Sink::enter() {
+    if (_depth >= _limits.max_depth) {
+      _elided = true;
+      write("...");
+      return false;
+    }
+    ++_depth;
+    return true;
+  }
+
+  void Sink::leave() {
+    --_depth;
+  }
+
+  bool Sink::full() const {
+    return _truncated;
+  }
+
+  bool Sink::truncated() const {
+    return _truncated || _elided;
+  }
+
+  void Sink::mark_truncated() {
+    // the marker itself is not counted against the size limit
+    _truncated = true;
+    flush();
+    write_out("...", 3);
+  }
+
+  // StreamSink
+  StreamSink::StreamSink(std::ostream& os, PrintLimits limits)
+    : Sink(limits), _os(os) {}
+
+  StreamSink::~StreamSink() {
+    flush();
+  }
+
+  void StreamSink::write_out(char const* data, std::size_t size) {
+    _os.write(data, size);
+  }
+
+  // StringSink
+  StringSink::StringSink(PrintLimits limits)
+    : Sink(limits) {}
+
+  std::string& StringSink::str() {
+    flush();
+    return _str;
+  }
+
+  void StringSink::write_out(char const* data, std::size_t size) {
+    _str.append(data, size);
+  }
+}
@@ -0,0 +1,450 @@
+#include <void/evaluator.hpp>
+#include <void/builtin.hpp>
+
+#include <cstring>
+#include <unordered_map>
+
+// Snapshot image, integers little endian:
+//   "VOIDSNAP" u32 version
+//   u32 n, n programs: string source
+//   u32 e, the number of environments
+//   u32 n, n objects:  u8 tag, payload; objects only refer to earlier ones
+//   e environments:    u32 outer + 1 or 0, u32 n, n (string name, u32 object)
+//   u32 global environment
+// where a string is a u32 size and the bytes.
+
+namespace Void {
+  namespace {
+    constexpr char magic[8] = {'V', 'O', 'I', 'D', 'S', 'N', 'A', 'P'};
+    constexpr std::uint32_t version = 1;
+
+    enum Tag : std::uint8_t {
+      null_tag,
+      true_tag,
+      false_tag,
+      integer_tag,     // u64
+      big_integer_tag, // string, decimal
+      string_tag,      // u8 interned, string
+      array_tag,       // u32 n, n objects
+      hash_tag,        // u32 n, n (key object, value object)
+      int_array_tag,   // u32 n, n u64
+      error_tag,       // string
+      builtin_tag,     // string name
+      function_tag,    // u32 program, u32 function literal, u32 environment
+    };
+
+    void put_u32(std::string& out, std::uint32_t value) {
+      for (int i = 0; i < 4; ++i) {
+	out.push_back(static_cast<char>(value >> (8 * i)));
+      }
+    }
+
+    void put_u64(std::string& out, std::uint64_t value) {
+      put_u32(out, static_cast<std::uint32_t>(value));
+      put_u32(out, static_cast<std::uint32_t>(value >> 32));
+    }
+
+    void put_string(std::string& out, std::string_view str) {
+      put_u32(out, static_cast<std::uint32_t>(str.size()));
+      out.append(str);
+    }
+
+    class Writer {
+    public:
+      std::string write(Environment const* global) {
+	auto root = env(global);
+	// environments found while writing bindings are appended as we go
+	for (std::size_t i = 0; i < _env_list.size(); ++i) {
+	  auto current = _env_list[i];
+	  auto outer = current->outer() ? env(current->outer().get()) + 1 : 0;
+	  std::vector<std::pair<std::string const*, std::uint32_t>> bindings;
+	  for (auto& [name, value] : current->store()) {
+	    bindings.emplace_back(&name, object(value));
+	  }
+	  put_u32(_envs, outer);
+	  put_u32(_envs, static_cast<std::uint32_t>(bindings.size()));
+	  for (auto& [name, id] : bindings) {
+	    put_string(_envs, *name);
+	    put_u32(_envs, id);
+	  }
+	}
+
+	std::string image(magic, sizeof(magic));
+	put_u32(image, version);
+	put_u32(image, static_cast<std::uint32_t>(_program_ids.size()));
+	image += _programs;
+	put_u32(image, static_cast<std::uint32_t>(_env_list.size()));
+	put_u32(image, _object_count);
+	image += _objects;
+	image += _envs;
+	put_u32(image, root);
+	return image;
+      }
+
+    private:
+      std::uint32_t env(Environment const* env) {
+	auto [it, inserted] = _env_ids.emplace(env, static_cast<std::uint32_t>(_env_list.size()));
+	if (inserted) {
+	  _env_list.push_back(env);
+	}
+	return it->second;
+      }
+
+      std::uint32_t program(Program const* program) {
+	auto [it, inserted] = _program_ids.emplace(program, static_cast<std::uint32_t>(_program_ids.size()));
+	if (inserted) {
+	  put_string(_programs, program->source());
+	  auto& functions = program->functions();
+	  for (std::size_t i = 0; i < functions.size(); ++i) {
+	    _function_ids.emplace(functions[i], static_cast<std::uint32_t>(i));
+	  }
+	}
+	return it->second;
+      }
+
+      std::uint32_t object(std::shared_ptr<Object> const& obj) {
+	if (auto it = _object_ids.find(obj.get()); it != _object_ids.end()) {
+	  return it->second;
+	}
+
+	// children first, so the reader always has what a record refers to
+	std::vector<std::uint32_t> children;
+	switch (obj->type()) {
+	case Object::array_object_t:
+	  for (auto& elem : obj->cast<Array>()->elements()) {
+	    children.push_back(object(elem));
+	  }
+	  break;
+	case Object::hash_object_t:
+	  for (auto& entry : obj->cast<Hash>()->pairs().entries()) {
+	    children.push_back(object(entry.key));
+	    children.push_back(object(entry.value));
+	  }
+	  break;
+	default:
+	  break;
+	}
+
+	switch (obj->type()) {
+	case Object::integer_object_t:
+	  _objects.push_back(integer_tag);
+	  put_u64(_objects, static_cast<std::uint64_t>(obj->cast<Integer>()->value()));
+	  break;
+	case Object::big_integer_object_t:
+	  _objects.push_back(big_integer_tag);
+	  put_string(_objects, obj->cast<BigInteger>()->value().to_string());
+	  break;
+	case Object::boolean_object_t:
+	  _objects.push_back(obj->cast<Boolean>()->value() ? true_tag : false_tag);
+	  break;
+	case Object::string_object_t:
+	  _objects.push_back(string_tag);
+	  _objects.push_back(obj->cast<String>()->interned());
+	  put_string(_objects, obj->cast<String>()->value());
+	  break;
+	case Object::array_object_t:
+	  _objects.push_back(array_tag);
+	  put_u32(_objects, static_cast<std::uint32_t>(children.size()));
+	  for (auto id : children) {
+	    put_u32(_objects, id);
+	  }
+	  break;
+	case Object::hash_object_t:
+	  _objects.push_back(hash_tag);
+	  put_u32(_objects, static_cast<std::uint32_t>(children.size() / 2));
+	  for (auto id : children) {
+	    put_u32(_objects, id);
+	  }
+	  break;
+	case Object::int_array_object_t: {
+	  auto& values = obj->cast<IntArray>()->values();
+	  _objects.push_back(int_array_tag);
+	  put_u32(_objects, static_cast<std::uint32_t>(values.size()));
+	  for (auto value : values) {
+	    put_u64(_objects, static_cast<std::uint64_t>(value));
+	  }
+	  break;
+	}
+	case Object::error_object_t:
+	  _objects.push_back(error_tag);
+	  put_string(_objects, obj->cast<Error>()->value());
+	  break;
+	case Object::builtin_object_t:
+	  _objects.push_back(builtin_tag);
+	  put_string(_objects, obj->cast<Builtin>()->name());
+	  break;
+	case Object::function_object_t: {
+	  auto func = obj->cast<Function>();
+	  auto program_id = program(func->program().get());
+	  auto env_id = env(func->env().get());
+	  _objects.push_back(function_tag);
+	  put_u32(_objects, program_id);
+	  put_u32(_objects, _function_ids.at(func->function()));
+	  put_u32(_objects, env_id);
+	  break;
+	}
+	default:
+	  // null, and return values which never outlive a call
+	  _objects.push_back(null_tag);
+	  break;
+	}
+
+	auto id = _object_count++;
+	_object_ids.emplace(obj.get(), id);
+	return id;
+      }
+
+      std::string _programs;
+      std::string _objects;
+      std::string _envs;
+      std::uint32_t _object_count{};
+      std::unordered_map<Object const*, std::uint32_t> _object_ids;
+      std::unordered_map<Environment const*, std::uint32_t> _env_ids;
+      std::vector<Environment const*> _env_list;
+      std::unordered_map<Program const*, std::uint32_t> _program_ids;
+      std::unordered_map<FunctionLiteral const*, std::uint32_t> _function_ids;
+    };
+
+    // reads past the end or out of range ids only clear ok()
+    class Reader {
+    public:
+      explicit Reader(std::string_view data)
+	: _data(data) {}
+
+      bool ok() const { return _ok; }
+      bool done() const { return _pos == _data.size(); }
+
+      bool fail() {
+	_ok = false;
+	return false;
+      }
+
+      std::string_view bytes(std::size_t size) {
+	if (!_ok || _data.size() - _pos < size) {
+	  fail();
+	  return {};
+	}
+	auto res = _data.substr(_pos, size);
+	_pos += size;
+	return res;
+      }
+
+      std::uint8_t u8() {
+	auto b = bytes(1);
+	return b.empty() ? 0 : static_cast<std::uint8_t>(b[0]);
+      }
+
+      std::uint32_t u32() {
+	auto b = bytes(4);
+	std::uint32_t value = 0;
+	for (std::size_t i = 0; i < b.size(); ++i) {
+	  value |= std::uint32_t{static_cast<unsigned char>(b[i])} << (8 * i);
+	}
+	return value;
+      }
+
+      std::uint64_t u64() {
+	auto low = u32();
+	return low | std::uint64_t{u32()} << 32;
+      }
+
+      std::string_view string() {
+	return bytes(u32());
+      }
+
+      // a count of items at least min_size bytes each, checked against
+      // what is left so a corrupt count cannot ask for a huge allocation
+      std::uint32_t count(std::size_t min_size) {
+	auto n = u32();
+	if (_ok && n > (_data.size() - _pos) / min_size) {
+	  fail();
+	  return 0;
+	}
+	return n;
+      }
+
+      template <typename T>
+      T const* at(std::vector<T> const& items, std::uint32_t index) {
+	if (index >= items.size()) {
+	  fail();
+	  return nullptr;
+	}
+	return &items[index];
+      }
+
+    private:
+      std::string_view _data;
+      std::size_t _pos{};
+      bool _ok{true};
+    };
+  }
+
+  std::string Evaluator::snapshot() const {
+    return Writer().write(_env.get());
+  }
+
+  std::shared_ptr<Object> Evaluator::restore(std::string_view image) {
+    auto corrupt = [] { return std::make_shared<Error>("corrupt snapshot"); };
+
+    Reader in(image);
+    if (in.bytes(sizeof(magic)) != std::string_view(magic, sizeof(magic)) || in.u32() != version) {
+      return std::make_shared<Error>("not a snapshot");
+    }
+
+    std::vector<std::shared_ptr<Program>> programs(in.count(4));
+    for (auto& program : programs) {
+      auto source = in.string();
+      Parser parser{std::string(source)};
+      program = parser.parse();
+      if (!parser.error().empty()) {
+	return corrupt();
+      }
+      program->set_source(std::string(source));
+    }
+
+    // environments come first, functions refer to them
+    std::vector<std::shared_ptr<Environment>> envs(in.count(8));
+    for (auto& env : envs) {
+      env = std::make_shared<Environment>();
+    }
+
+    std::vector<std::shared_ptr<Object>> objects(in.count(1));
+    for (std::size_t i = 0; i < objects.size(); ++i) {
+      auto& obj = objects[i];
+      auto child = [&](std::uint32_t id) -> std::shared_ptr<Object> const* {
+	if (id >= i) {
+	  in.fail();
+	  return nullptr;
+	}
+	return &objects[id];
+      };
+
+      switch (in.u8()) {
+      case null_tag:
+	obj = null_obj;
+	break;
+      case true_tag:
+	obj = true_obj;
+	break;
+      case false_tag:
+	obj = false_obj;
+	break;
+      case integer_tag:
+	obj = Integer::make(static_cast<std::int64_t>(in.u64()));
+	break;
+      case big_integer_tag: {
+	BigInt value;
+	if (!BigInt::parse(in.string(), value)) {
+	  in.fail();
+	}
+	obj = BigInteger::make(std::move(value));
+	break;
+      }
+      case string_tag: {
+	bool interned = in.u8() != 0;
+	auto value = in.string();
+	obj = interned ? String::intern(value) : std::make_shared<String>(std::string(value));
+	break;
+      }
+      case array_tag: {
+	auto arr = std::make_shared<Array>();
+	for (auto n = in.count(4); n > 0; --n) {
+	  if (auto elem = child(in.u32())) {
+	    arr->append(*elem);
+	  }
+	}
+	obj = arr;
+	break;
+      }
+      case hash_tag: {
+	auto hash = std::make_shared<Hash>();
+	for (auto n = in.count(8); n > 0; --n) {
+	  auto key = child(in.u32());
+	  auto value = child(in.u32());
+	  if (key && value && HashTable::hashable(key->get())) {
+	    hash->set(*key, *value);
+	  }
+	}
+	obj = hash;
+	break;
+      }
+      case int_array_tag: {
+	IntArray::Values values(in.count(8));
+	for (auto& value : values) {
+	  value = static_cast<std::int64_t>(in.u64());
+	}
+	obj = std::make_shared<IntArray>(std::move(values));
+	break;
+      }
+      case error_tag:
+	obj = std::make_shared<Error>(std::string(in.string()));
+	break;
+      case builtin_tag: {
+	std::string name(in.string());
+	if (auto it = _functions.find(name); it != _functions.end()) {
+	  obj = it->second;
+	} else if (auto it = builtin_func_map.find(name); it != builtin_func_map.end()) {
+	  obj = it->second;
+	} else {
+	  return std::make_shared<Error>("snapshot needs host function " + name);
+	}
+	break;
+      }
+      case function_tag: {
+	auto program = in.at(programs, in.u32());
+	auto index = in.u32();
+	auto env = in.at(envs, in.u32());
+	if (!program || !env || index >= (*program)->functions().size()) {
+	  return corrupt();
+	}
+	obj = std::make_shared<Function>((*program)->functions()[index], *program, *env);
+	break;
+      }
+      default:
+	return corrupt();
+      }
+      if (!in.ok()) {
+	return corrupt();
+      }
+    }
+
+    for (auto& env : envs) {
+      if (auto outer = in.u32()) {
+	if (auto found = in.at(envs, outer - 1)) {
+	  env->set_outer(*found);
+	}
+      }
+      for (auto n = in.count(8); n > 0; --n) {
+	std::string name(in.string());
+	if (auto value = in.at(objects, in.u32())) {
+	  env->set(std::move(name), *value);
+	}
+      }
+    }
+    // an outer chain that loops would hang every lookup of an unbound
+    // name, one without a loop has at most every scope on it
+    bool chains_end = true;
+    for (auto& env : envs) {
+      auto scope = env.get();
+      for (std::size_t steps = 0; scope && steps < envs.size(); ++steps) {
+	scope = scope->outer().get();
+      }
+      chains_end = chains_end && !scope;
+    }
+    auto root = in.at(envs, in.u32());
+    if (!in.ok() || !in.done() || !root || !chains_end) {
+      for (auto& env : envs) {
+	env->clear();
+      }
+      return corrupt();
+    }
+
+    // closures may point back at the scopes they live in
+    for (auto& env : envs) {
+      _captured.push_back(env);
+    }
+    _env->clear();
+    _env = *root;
+    return null_obj;
+  }
+}
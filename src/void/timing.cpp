@@ -0,0 +1,52 @@
+#include <void/timing.hpp>
+
+#include <sstream>
+
+namespace Void {
+  std::string EvalTiming::to_json() const {
+    std::ostringstream os;
+    os << "{\"lex_ns\": " << lex.count()
+       << ", \"parse_ns\": " << parse.count()
+       << ", \"eval_ns\": " << eval.count()
+       << ", \"print_ns\": " << print.count()
+       << ", \"tokens\": " << tokens
+       << ", \"nodes\": " << nodes << '}';
+    return os.str();
+  }
+
+  void TimingHistograms::record(EvalTiming const& timing) {
+    _lex.record(timing.lex.count());
+    _parse.record(timing.parse.count());
+    _eval.record(timing.eval.count());
+    _print.record(timing.print.count());
+    _tokens += timing.tokens;
+    _nodes += timing.nodes;
+  }
+
+  void TimingHistograms::merge(TimingHistograms const& other) {
+    _lex.merge(other._lex);
+    _parse.merge(other._parse);
+    _eval.merge(other._eval);
+    _print.merge(other._print);
+    _tokens += other._tokens;
+    _nodes += other._nodes;
+  }
+
+  std::string TimingHistograms::to_json() const {
+    std::ostringstream os;
+    auto write = [&](char const* name, Histogram const& histogram) {
+      os << '"' << name << "\": {\"count\": " << histogram.count()
+	 << ", \"mean_ns\": " << (histogram.count() ? histogram.sum() / histogram.count() : 0)
+	 << ", \"p50_ns\": " << histogram.percentile(50)
+	 << ", \"p99_ns\": " << histogram.percentile(99)
+	 << ", \"max_ns\": " << histogram.max() << "}, ";
+    };
+    os << '{';
+    write("lex", _lex);
+    write("parse", _parse);
+    write("eval", _eval);
+    write("print", _print);
+    os << "\"tokens\": " << _tokens << ", \"nodes\": " << _nodes << '}';
+    return os.str();
+  }
+}
@@ -0,0 +1,230 @@
+#include <void/tracer.hpp>
+#include <void/ast.hpp>
+#include <void/object.hpp>
+#include <void/profiler.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include <unistd.h>
+
+namespace Void {
+  namespace tracer {
+    namespace detail {
+      std::atomic<bool> tracing{false};
+    }
+
+    namespace {
+      struct Event {
+	std::int64_t start_ns; // since start()
+	std::int64_t duration_ns;
+	std::uint32_t name;
+      };
+
+      // Written only by its thread. writing brackets a write so stop()
+      // can wait for it, the buffer is never freed so a thread can keep a
+      // plain pointer to it.
+      struct Buffer {
+	std::unique_ptr<Event[]> events;
+	std::size_t capacity{};
+	std::atomic<std::uint64_t> head{0};
+	std::atomic<bool> writing{false};
+	std::uint32_t tid{};
+      };
+
+      struct Name {
+	std::string name;
+	bool builtin;
+      };
+
+      // registry, names and filter; taken once per thread and name, not per call
+      std::mutex mutex;
+      std::vector<std::unique_ptr<Buffer>> buffers;
+      std::vector<Name> names;
+      std::unordered_map<std::string, std::uint32_t> name_ids;
+      std::unordered_set<std::string> filter;
+      std::size_t capacity{};
+      std::chrono::steady_clock::time_point epoch;
+      // bumped by every start(), so threads refresh their buffer and ids
+      std::atomic<unsigned> generation{0};
+
+      // A function or builtin freed during a run may have its address
+      // reused by another, which is then traced under the old name.
+      struct ThreadState {
+	Buffer* buffer{};
+	unsigned generation{};
+	std::unordered_map<void const*, std::uint32_t> ids;
+      };
+      thread_local ThreadState state;
+
+      void refresh(unsigned current) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!state.buffer) {
+	  buffers.push_back(std::make_unique<Buffer>());
+	  state.buffer = buffers.back().get();
+	  state.buffer->tid = static_cast<std::uint32_t>(buffers.size());
+	}
+	if (state.buffer->capacity != capacity) {
+	  state.buffer->events = std::make_unique<Event[]>(capacity);
+	  state.buffer->capacity = capacity;
+	  state.buffer->head.store(0);
+	}
+	state.ids.clear();
+	state.generation = current;
+      }
+
+      // 0 if the filter leaves it out
+      std::uint32_t name_id(void const* key, bool builtin) {
+	auto name = builtin ? static_cast<Builtin const*>(key)->name()
+			    : profiler::frame_name(static_cast<FunctionLiteral const*>(key));
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!filter.empty() && !filter.count(name)) {
+	  return 0;
+	}
+	auto [it, inserted] = name_ids.emplace((builtin ? "b:" : "f:") + name, static_cast<std::uint32_t>(names.size()));
+	if (inserted) {
+	  names.push_back({std::move(name), builtin});
+	}
+	return it->second;
+      }
+
+      void write_json_string(std::ostream& os, std::string const& str) {
+	os << '"';
+	for (unsigned char c : str) {
+	  if (c == '"' || c == '\\') {
+	    os << '\\' << c;
+	  } else if (c < 0x20) {
+	    char buf[8];
+	    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+	    os << buf;
+	  } else {
+	    os << c;
+	  }
+	}
+	os << '"';
+      }
+
+      // microseconds with the nanoseconds kept
+      void write_us(std::ostream& os, std::int64_t ns) {
+	char buf[32];
+	std::snprintf(buf, sizeof(buf), "%lld.%03lld", static_cast<long long>(ns / 1000), static_cast<long long>(ns % 1000));
+	os << buf;
+      }
+
+      void wait_for_writers() {
+	for (auto& buffer : buffers) {
+	  while (buffer->writing.load()) {
+	    std::this_thread::yield();
+	  }
+	}
+      }
+    }
+
+    bool start(std::vector<std::string> traced, std::size_t events_per_thread) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (active() || events_per_thread == 0) {
+	return false;
+      }
+      generation.fetch_add(1);
+      wait_for_writers();
+      for (auto& buffer : buffers) {
+	buffer->head.store(0);
+      }
+      names.assign(1, {"", false});
+      name_ids.clear();
+      filter = std::unordered_set<std::string>(traced.begin(), traced.end());
+      capacity = events_per_thread;
+      epoch = std::chrono::steady_clock::now();
+      detail::tracing.store(true);
+      return true;
+    }
+
+    void stop() {
+      std::lock_guard<std::mutex> lock(mutex);
+      detail::tracing.store(false);
+      wait_for_writers();
+    }
+
+    Summary summary() {
+      std::lock_guard<std::mutex> lock(mutex);
+      Summary res{};
+      for (auto& buffer : buffers) {
+	auto head = buffer->head.load(std::memory_order_acquire);
+	res.events += std::min<std::uint64_t>(head, buffer->capacity);
+	res.overwritten += head - std::min<std::uint64_t>(head, buffer->capacity);
+      }
+      return res;
+    }
+
+    void write_chrome_json(std::ostream& os) {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto pid = static_cast<long>(getpid());
+      char const* sep = "\n";
+      os << "{\"traceEvents\": [";
+      for (auto& buffer : buffers) {
+	auto head = buffer->head.load(std::memory_order_acquire);
+	auto first = head - std::min<std::uint64_t>(head, buffer->capacity);
+	for (auto i = first; i < head; ++i) {
+	  auto& event = buffer->events[i % buffer->capacity];
+	  auto& name = names[event.name];
+	  os << sep << "{\"name\": ";
+	  write_json_string(os, name.name);
+	  os << ", \"cat\": \"" << (name.builtin ? "builtin" : "function") << "\", \"ph\": \"X\", \"ts\": ";
+	  write_us(os, event.start_ns);
+	  os << ", \"dur\": ";
+	  write_us(os, event.duration_ns);
+	  os << ", \"pid\": " << pid << ", \"tid\": " << buffer->tid << '}';
+	  sep = ",\n";
+	}
+      }
+      os << "\n], \"displayTimeUnit\": \"ns\"}\n";
+    }
+
+    void reset() {
+      std::lock_guard<std::mutex> lock(mutex);
+      wait_for_writers();
+      for (auto& buffer : buffers) {
+	buffer->head.store(0);
+      }
+    }
+
+    void Span::begin(void const* key, bool builtin) {
+      auto current = generation.load();
+      if (state.generation != current || !state.buffer) {
+	refresh(current);
+      }
+      auto it = state.ids.find(key);
+      if (it == state.ids.end()) {
+	it = state.ids.emplace(key, name_id(key, builtin)).first;
+      }
+      _name = it->second;
+      if (_name) {
+	_start = std::chrono::steady_clock::now();
+      }
+    }
+
+    void Span::end() {
+      auto now = std::chrono::steady_clock::now();
+      auto buffer = state.buffer;
+      // pairs with the tracing store and generation bump before
+      // wait_for_writers, one side sees the other
+      buffer->writing.store(true);
+      if (detail::tracing.load() && state.generation == generation.load()) {
+	auto head = buffer->head.load(std::memory_order_relaxed);
+	buffer->events[head % buffer->capacity] = {
+	  std::chrono::duration_cast<std::chrono::nanoseconds>(_start - epoch).count(),
+	  std::chrono::duration_cast<std::chrono::nanoseconds>(now - _start).count(),
+	  _name,
+	};
+	buffer->head.store(head + 1, std::memory_order_release);
+      }
+      buffer->writing.store(false, std::memory_order_release);
+    }
+  }
+}
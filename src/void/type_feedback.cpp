@@ -0,0 +1,260 @@
+#include <void/type_feedback.hpp>
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+namespace Void {
+  namespace type_feedback {
+    namespace {
+      constexpr char const* header = "void-feedback 1";
+
+      void collect(AstNode* node, std::vector<Expression*>& res) {
+	if (!node) {
+	  return;
+	}
+	switch (node->kind()) {
+	case NodeKind::program:
+	  for (auto& stmt : static_cast<Program*>(node)->statements()) {
+	    collect(stmt.get(), res);
+	  }
+	  break;
+	case NodeKind::let_statement:
+	  collect(static_cast<LetStatement*>(node)->expression(), res);
+	  break;
+	case NodeKind::return_statement:
+	  collect(static_cast<ReturnStatement*>(node)->expression(), res);
+	  break;
+	case NodeKind::expression_statement:
+	  collect(static_cast<ExpressionStatement*>(node)->expression(), res);
+	  break;
+	case NodeKind::block_statement:
+	  for (auto& stmt : static_cast<BlockStatement*>(node)->statements()) {
+	    collect(stmt.get(), res);
+	  }
+	  break;
+	case NodeKind::array_literal:
+	  for (auto& expr : static_cast<ArrayLiteral*>(node)->expressions()) {
+	    collect(expr.get(), res);
+	  }
+	  break;
+	case NodeKind::hash_literal:
+	  for (auto& [key, value] : static_cast<HashLiteral*>(node)->pairs()) {
+	    collect(key.get(), res);
+	    collect(value.get(), res);
+	  }
+	  break;
+	case NodeKind::function_literal:
+	  collect(static_cast<FunctionLiteral*>(node)->body(), res);
+	  break;
+	case NodeKind::if_expression: {
+	  auto expr = static_cast<IfExpression*>(node);
+	  res.push_back(expr);
+	  collect(expr->condition(), res);
+	  collect(expr->consequence(), res);
+	  collect(expr->alternative(), res);
+	  break;
+	}
+	case NodeKind::call_expression: {
+	  auto expr = static_cast<CallExpression*>(node);
+	  res.push_back(expr);
+	  collect(expr->function(), res);
+	  for (auto& arg : expr->arguments()) {
+	    collect(arg.get(), res);
+	  }
+	  break;
+	}
+	case NodeKind::index_expression:
+	  collect(static_cast<IndexExpression*>(node)->array(), res);
+	  collect(static_cast<IndexExpression*>(node)->index(), res);
+	  break;
+	case NodeKind::prefix_expression:
+	  collect(static_cast<PrefixExpression*>(node)->right(), res);
+	  break;
+	case NodeKind::infix_expression: {
+	  auto expr = static_cast<InfixExpression*>(node);
+	  res.push_back(expr);
+	  collect(expr->left(), res);
+	  collect(expr->right(), res);
+	  break;
+	}
+	case NodeKind::identifier:
+	case NodeKind::integer_literal:
+	case NodeKind::boolean_literal:
+	case NodeKind::string_literal:
+	  break;
+	}
+      }
+
+      std::vector<Site> feedback_of(Program& program) {
+	std::vector<Site> res;
+	for (auto expr : sites(program)) {
+	  Site site{expr->kind(), {}, {}, {}};
+	  switch (site.kind) {
+	  case NodeKind::infix_expression:
+	    site.infix = static_cast<InfixExpression*>(expr)->feedback();
+	    break;
+	  case NodeKind::call_expression:
+	    site.call = static_cast<CallExpression*>(expr)->feedback();
+	    site.call.target = nullptr;
+	    break;
+	  default:
+	    site.branch = static_cast<IfExpression*>(expr)->feedback();
+	    break;
+	  }
+	  res.push_back(std::move(site));
+	}
+	return res;
+      }
+
+      bool read_site(std::istream& is, Site& site) {
+	std::string kind;
+	is >> kind;
+	if (kind == "infix") {
+	  site.kind = NodeKind::infix_expression;
+	  return static_cast<bool>(is >> site.infix.count >> site.infix.left >> site.infix.right);
+	}
+	if (kind == "call") {
+	  site.kind = NodeKind::call_expression;
+	  is >> site.call.count >> site.call.polymorphic >> site.call.name;
+	  if (site.call.name == "-") {
+	    site.call.name.clear();
+	  }
+	  return static_cast<bool>(is);
+	}
+	if (kind == "if") {
+	  site.kind = NodeKind::if_expression;
+	  return static_cast<bool>(is >> site.branch.taken >> site.branch.not_taken);
+	}
+	return false;
+      }
+
+      void write_site(std::ostream& os, Site const& site) {
+	switch (site.kind) {
+	case NodeKind::infix_expression:
+	  os << "infix " << site.infix.count << ' ' << site.infix.left << ' ' << site.infix.right << '\n';
+	  break;
+	case NodeKind::call_expression:
+	  os << "call " << site.call.count << ' ' << site.call.polymorphic << ' '
+	     << (site.call.name.empty() ? "-" : site.call.name) << '\n';
+	  break;
+	default:
+	  os << "if " << site.branch.taken << ' ' << site.branch.not_taken << '\n';
+	  break;
+	}
+      }
+    }
+
+    std::uint64_t source_hash(std::string_view source) {
+      std::uint64_t hash = 14695981039346656037ull;
+      for (unsigned char c : source) {
+	hash = (hash ^ c) * 1099511628211ull;
+      }
+      return hash;
+    }
+
+    std::vector<Expression*> sites(Program& program) {
+      std::vector<Expression*> res;
+      collect(&program, res);
+      return res;
+    }
+
+    bool Profile::read(std::istream& is) {
+      std::string line;
+      if (!std::getline(is, line) || line != header) {
+	return false;
+      }
+      std::string word;
+      std::uint64_t hash;
+      std::size_t count;
+      while (is >> word) {
+	if (word != "program" || !(is >> std::hex >> hash >> std::dec >> count)) {
+	  _programs.clear();
+	  return false;
+	}
+	std::vector<Site> program;
+	for (std::size_t i = 0; i < count; ++i) {
+	  Site site{};
+	  if (!read_site(is, site)) {
+	    _programs.clear();
+	    return false;
+	  }
+	  program.push_back(std::move(site));
+	}
+	_programs[hash] = std::move(program);
+      }
+      return true;
+    }
+
+    void Profile::write(std::ostream& os) const {
+      auto programs = _programs;
+      for (auto& weak : _attached) {
+	if (auto program = weak.lock()) {
+	  programs[source_hash(program->source())] = feedback_of(*program);
+	}
+      }
+      os << header << '\n';
+      for (auto& [hash, program] : programs) {
+	os << "program " << std::hex << hash << std::dec << ' ' << program.size() << '\n';
+	for (auto& site : program) {
+	  write_site(os, site);
+	}
+      }
+    }
+
+    bool Profile::attach(std::shared_ptr<Program>& program) {
+      auto it = _programs.find(source_hash(program->source()));
+      auto exprs = sites(*program);
+      bool known = it != _programs.end() && it->second.size() == exprs.size();
+      for (std::size_t i = 0; known && i < exprs.size(); ++i) {
+	known = it->second[i].kind == exprs[i]->kind();
+      }
+      if (known) {
+	for (std::size_t i = 0; i < exprs.size(); ++i) {
+	  auto& site = it->second[i];
+	  switch (site.kind) {
+	  case NodeKind::infix_expression:
+	    static_cast<InfixExpression*>(exprs[i])->feedback() = site.infix;
+	    break;
+	  case NodeKind::call_expression:
+	    static_cast<CallExpression*>(exprs[i])->feedback() = site.call;
+	    break;
+	  default:
+	    static_cast<IfExpression*>(exprs[i])->feedback() = site.branch;
+	    break;
+	  }
+	}
+      }
+
+      // the handle owns the program and folds it just before releasing it
+      auto owner = std::move(program);
+      auto raw = owner.get();
+      program = std::shared_ptr<Program>(raw, [this, owner = std::move(owner)](Program*) mutable {
+	fold(*owner);
+	owner.reset();
+      });
+      _attached.erase(std::remove_if(_attached.begin(), _attached.end(),
+				     [](auto& weak) { return weak.expired(); }),
+		      _attached.end());
+      _attached.push_back(program);
+      return known;
+    }
+
+    void Profile::fold(Program& program) {
+      _programs[source_hash(program.source())] = feedback_of(program);
+    }
+
+    std::size_t Profile::programs() const {
+      std::set<std::uint64_t> hashes;
+      for (auto& [hash, program] : _programs) {
+	hashes.insert(hash);
+      }
+      for (auto& weak : _attached) {
+	if (auto program = weak.lock()) {
+	  hashes.insert(source_hash(program->source()));
+	}
+      }
+      return hashes.size();
+    }
+  }
+}
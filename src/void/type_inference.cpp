@@ -0,0 +1,488 @@
+#include <void/type_inference.hpp>
+#include <void/builtin.hpp>
+#include <void/object.hpp>
+
+#include <unordered_map>
+
+namespace Void {
+  namespace type_inference {
+    namespace {
+      static_assert(object_type_count <= sizeof(Types) * 8, "a Types bit per object type");
+
+      constexpr Types bit(Object::ObjectType type) {
+	return static_cast<Types>(1u << type);
+      }
+
+      constexpr Types integer = bit(Object::integer_object_t);
+      constexpr Types boolean = bit(Object::boolean_object_t);
+      constexpr Types big_integer = bit(Object::big_integer_object_t);
+      constexpr Types int_array = bit(Object::int_array_object_t);
+      constexpr Types array = bit(Object::array_object_t);
+      constexpr Types callable = bit(Object::function_object_t) | bit(Object::builtin_object_t);
+
+      bool single(Types types) {
+	return types && !(types & (types - 1));
+      }
+
+      bool arithmetic(InfixOp op) {
+	return op == InfixOp::add || op == InfixOp::sub || op == InfixOp::mul || op == InfixOp::div;
+      }
+
+      // what eval_infix_expression returns for one pair of operand types,
+      // 0 where it returns an error
+      Types infix_result(InfixOp op, Object::ObjectType left, Object::ObjectType right) {
+	bool numbers = (left == Object::integer_object_t || left == Object::big_integer_object_t) &&
+	  (right == Object::integer_object_t || right == Object::big_integer_object_t);
+	bool compare = op != InfixOp::other && !arithmetic(op);
+	if (numbers) {
+	  if (compare) {
+	    return boolean;
+	  }
+	  if (op == InfixOp::other) {
+	    return 0;
+	  }
+	  // Integers overflow into BigIntegers, assumed not to
+	  return left == Object::integer_object_t && right == Object::integer_object_t ? integer : integer | big_integer;
+	}
+	if (left == Object::string_object_t && right == Object::string_object_t) {
+	  return op == InfixOp::add ? bit(Object::string_object_t) : compare ? boolean : 0;
+	}
+	if (left == Object::array_object_t && right == Object::array_object_t) {
+	  return op == InfixOp::add ? array : bit(Object::null_object_t);
+	}
+	if (left == Object::int_array_object_t || right == Object::int_array_object_t) {
+	  if (left == right && (op == InfixOp::eq || op == InfixOp::ne)) {
+	    return boolean;
+	  }
+	  bool operands = (left == Object::int_array_object_t || left == Object::integer_object_t) &&
+	    (right == Object::int_array_object_t || right == Object::integer_object_t);
+	  bool elementwise = op == InfixOp::add || op == InfixOp::sub || op == InfixOp::mul;
+	  return operands && elementwise ? int_array | array : 0;
+	}
+	if (left == right && (op == InfixOp::eq || op == InfixOp::ne)) {
+	  return boolean;
+	}
+	return 0;
+      }
+
+      // the builtins whose result type does not depend on their arguments
+      Types builtin_result(std::string const& name) {
+	static std::unordered_map<std::string, Types> const results = {
+	  {"len", integer},
+	  {"puts", bit(Object::null_object_t)},
+	  {"substr", bit(Object::string_object_t)},
+	  {"intern", bit(Object::string_object_t)},
+	  {"int_array", int_array},
+	  {"to_array", array},
+	};
+	auto it = results.find(name);
+	return it != results.end() ? it->second : any;
+      }
+
+      // what a name or parameter is bound to; neither a function nor mixed
+      // while the pass has not seen it bound yet
+      struct Binding {
+	Types types{};
+	FunctionLiteral* function{}; // the one literal it is bound to
+	bool mixed{};		     // bound to something else as well
+      };
+
+      struct Scope {
+	std::unordered_map<std::string, Binding> names;
+	Scope* outer{};
+
+	Binding* find(std::string const& name) {
+	  for (auto scope = this; scope; scope = scope->outer) {
+	    if (auto it = scope->names.find(name); it != scope->names.end()) {
+	      return &it->second;
+	    }
+	  }
+	  return nullptr;
+	}
+      };
+
+      struct Function {
+	std::vector<Binding> parameters; // what the calls pass
+	Types result{};
+	Scope scope;
+      };
+
+      // Every pass walks the whole program and only ever grows types, so
+      // passes repeat until one changes nothing; a last one reports.
+      class Inference {
+      public:
+	Report run(Program& program) {
+	  declare(&program, _globals);
+	  do {
+	    _changed = false;
+	    block(program.statements(), _globals);
+	  } while (_changed);
+	  _reporting = true;
+	  block(program.statements(), _globals);
+	  return std::move(_report);
+	}
+
+      private:
+	void join(Types& into, Types types) {
+	  if ((into | types) != into) {
+	    into |= types;
+	    _changed = true;
+	  }
+	}
+
+	void bind(Binding& binding, Binding const& value) {
+	  join(binding.types, value.types);
+	  if (binding.mixed || (!value.function && !value.mixed) || binding.function == value.function) {
+	    return;
+	  }
+	  if (value.function && !binding.function) {
+	    binding.function = value.function;
+	  } else {
+	    binding.function = nullptr;
+	    binding.mixed = true;
+	  }
+	  _changed = true;
+	}
+
+	// the binding an expression of the given types makes
+	Binding value_of(Expression* node, Types types, Scope& scope) {
+	  if (node && node->kind() == NodeKind::function_literal) {
+	    return {types, static_cast<FunctionLiteral*>(node), false};
+	  }
+	  if (node && node->kind() == NodeKind::identifier) {
+	    if (auto binding = scope.find(static_cast<Identifier*>(node)->value())) {
+	      return *binding;
+	    }
+	  }
+	  return {types, nullptr, true};
+	}
+
+	// the lets of a function body or program, before its first use,
+	// not those of the functions nested in it
+	void declare(AstNode* node, Scope& scope) {
+	  if (!node) {
+	    return;
+	  }
+	  switch (node->kind()) {
+	  case NodeKind::program:
+	    for (auto& stmt : static_cast<Program*>(node)->statements()) {
+	      declare(stmt.get(), scope);
+	    }
+	    break;
+	  case NodeKind::block_statement:
+	    for (auto& stmt : static_cast<BlockStatement*>(node)->statements()) {
+	      declare(stmt.get(), scope);
+	    }
+	    break;
+	  case NodeKind::let_statement: {
+	    auto stmt = static_cast<LetStatement*>(node);
+	    scope.names.try_emplace(stmt->identier()->value());
+	    declare(stmt->expression(), scope);
+	    break;
+	  }
+	  case NodeKind::return_statement:
+	    declare(static_cast<ReturnStatement*>(node)->expression(), scope);
+	    break;
+	  case NodeKind::expression_statement:
+	    declare(static_cast<ExpressionStatement*>(node)->expression(), scope);
+	    break;
+	  case NodeKind::if_expression: {
+	    auto expr = static_cast<IfExpression*>(node);
+	    declare(expr->condition(), scope);
+	    declare(expr->consequence(), scope);
+	    declare(expr->alternative(), scope);
+	    break;
+	  }
+	  case NodeKind::array_literal:
+	    for (auto& expr : static_cast<ArrayLiteral*>(node)->expressions()) {
+	      declare(expr.get(), scope);
+	    }
+	    break;
+	  case NodeKind::hash_literal:
+	    for (auto& [key, value] : static_cast<HashLiteral*>(node)->pairs()) {
+	      declare(key.get(), scope);
+	      declare(value.get(), scope);
+	    }
+	    break;
+	  case NodeKind::call_expression: {
+	    auto expr = static_cast<CallExpression*>(node);
+	    declare(expr->function(), scope);
+	    for (auto& arg : expr->arguments()) {
+	      declare(arg.get(), scope);
+	    }
+	    break;
+	  }
+	  case NodeKind::index_expression:
+	    declare(static_cast<IndexExpression*>(node)->array(), scope);
+	    declare(static_cast<IndexExpression*>(node)->index(), scope);
+	    break;
+	  case NodeKind::prefix_expression:
+	    declare(static_cast<PrefixExpression*>(node)->right(), scope);
+	    break;
+	  case NodeKind::infix_expression:
+	    declare(static_cast<InfixExpression*>(node)->left(), scope);
+	    declare(static_cast<InfixExpression*>(node)->right(), scope);
+	    break;
+	  case NodeKind::function_literal:
+	  case NodeKind::identifier:
+	  case NodeKind::integer_literal:
+	  case NodeKind::boolean_literal:
+	  case NodeKind::string_literal:
+	    break;
+	  }
+	}
+
+	void site(Expression* node, bool proven, std::string reason) {
+	  if (!_reporting) {
+	    return;
+	  }
+	  ++_report.sites;
+	  if (proven) {
+	    ++_report.proven;
+	  } else {
+	    _report.failures.push_back({node->line(), node->kind(), std::move(reason)});
+	  }
+	}
+
+	// the value of the block, a return leaves it with none
+	Types block(std::vector<std::unique_ptr<Statement>> const& stmts, Scope& scope) {
+	  Types res = bit(Object::null_object_t);
+	  for (auto& stmt : stmts) {
+	    res = statement(stmt.get(), scope);
+	  }
+	  return res;
+	}
+
+	Types statement(Statement* node, Scope& scope) {
+	  switch (node->kind()) {
+	  case NodeKind::let_statement: {
+	    auto stmt = static_cast<LetStatement*>(node);
+	    auto value = stmt->expression();
+	    auto types = expression(value, scope);
+	    bind(scope.names[stmt->identier()->value()], value_of(value, types, scope));
+	    return bit(Object::null_object_t);
+	  }
+	  case NodeKind::return_statement: {
+	    auto types = expression(static_cast<ReturnStatement*>(node)->expression(), scope);
+	    if (_function) {
+	      join(_function->result, types);
+	    }
+	    return 0;
+	  }
+	  case NodeKind::expression_statement:
+	    return expression(static_cast<ExpressionStatement*>(node)->expression(), scope);
+	  default:
+	    return any;
+	  }
+	}
+
+	Types expression(Expression* node, Scope& scope) {
+	  if (!node) {
+	    return 0;
+	  }
+	  switch (node->kind()) {
+	  case NodeKind::integer_literal:
+	    return static_cast<IntegerLiteral*>(node)->is_big() ? big_integer : integer;
+	  case NodeKind::boolean_literal:
+	    return boolean;
+	  case NodeKind::string_literal:
+	    return bit(Object::string_object_t);
+	  case NodeKind::array_literal:
+	    for (auto& expr : static_cast<ArrayLiteral*>(node)->expressions()) {
+	      expression(expr.get(), scope);
+	    }
+	    return array;
+	  case NodeKind::hash_literal:
+	    for (auto& [key, value] : static_cast<HashLiteral*>(node)->pairs()) {
+	      expression(key.get(), scope);
+	      expression(value.get(), scope);
+	    }
+	    return bit(Object::hash_object_t);
+	  case NodeKind::identifier: {
+	    auto& name = static_cast<Identifier*>(node)->value();
+	    if (auto binding = scope.find(name)) {
+	      return binding->types;
+	    }
+	    // host functions are Builtins too
+	    return builtin_func_map.count(name) ? bit(Object::builtin_object_t) : any;
+	  }
+	  case NodeKind::function_literal:
+	    return function(static_cast<FunctionLiteral*>(node), scope);
+	  case NodeKind::prefix_expression: {
+	    auto expr = static_cast<PrefixExpression*>(node);
+	    auto right = expression(expr->right(), scope);
+	    if (expr->op() == "!") {
+	      return boolean;
+	    }
+	    return expr->op() == "-" ? static_cast<Types>(right & (integer | big_integer)) : 0;
+	  }
+	  case NodeKind::infix_expression:
+	    return infix(static_cast<InfixExpression*>(node), scope);
+	  case NodeKind::if_expression:
+	    return if_expression(static_cast<IfExpression*>(node), scope);
+	  case NodeKind::call_expression:
+	    return call(static_cast<CallExpression*>(node), scope);
+	  case NodeKind::index_expression:
+	    return index(static_cast<IndexExpression*>(node), scope);
+	  default:
+	    return any;
+	  }
+	}
+
+	Types function(FunctionLiteral* node, Scope& outer) {
+	  auto& info = _functions[node];
+	  auto& params = node->parameters();
+	  info.parameters.resize(params.size());
+	  info.scope.outer = &outer;
+	  if (info.scope.names.empty()) {
+	    declare(node->body(), info.scope);
+	  }
+	  for (std::size_t i = 0; i < params.size(); ++i) {
+	    bind(info.scope.names[params[i]->value()], info.parameters[i]);
+	  }
+
+	  auto enclosing = _function;
+	  _function = &info;
+	  join(info.result, block(node->body()->statements(), info.scope));
+	  _function = enclosing;
+	  return bit(Object::function_object_t);
+	}
+
+	Types infix(InfixExpression* node, Scope& scope) {
+	  auto left = expression(node->left(), scope);
+	  auto right = expression(node->right(), scope);
+	  auto op = node->infix_op();
+	  Types res = 0;
+	  for (std::size_t l = 0; l < object_type_count; ++l) {
+	    for (std::size_t r = 0; r < object_type_count; ++r) {
+	      if ((left >> l & 1) && (right >> r & 1)) {
+		res |= infix_result(op, static_cast<Object::ObjectType>(l), static_cast<Object::ObjectType>(r));
+	      }
+	    }
+	  }
+
+	  if (op != InfixOp::other) {
+	    bool proven = single(left) && single(right);
+	    site(node, proven, "operands of '" + node->op() + "' are " + to_string(left) + " and " + to_string(right));
+	    if (_reporting && left == integer && right == integer && node->quick() == Quick::none) {
+	      node->set_quick(Quick::int_int);
+	    }
+	  }
+	  return res;
+	}
+
+	Types if_expression(IfExpression* node, Scope& scope) {
+	  auto cond = expression(node->condition(), scope);
+	  auto res = block(node->consequence()->statements(), scope);
+	  res |= node->alternative() ? block(node->alternative()->statements(), scope) : bit(Object::null_object_t);
+
+	  site(node, cond == boolean, "condition is " + to_string(cond));
+	  if (_reporting && cond == boolean && node->quick() == Quick::none) {
+	    node->set_quick(Quick::bool_cond);
+	  }
+	  return res;
+	}
+
+	Types call(CallExpression* node, Scope& scope) {
+	  auto callee = node->function();
+	  auto types = expression(callee, scope);
+	  std::vector<Binding> args;
+	  for (auto& arg : node->arguments()) {
+	    args.push_back(value_of(arg.get(), expression(arg.get(), scope), scope));
+	  }
+	  site(node, types && (types & ~callable) == 0, "callee is " + to_string(types));
+
+	  FunctionLiteral* literal = nullptr;
+	  if (callee->kind() == NodeKind::function_literal) {
+	    literal = static_cast<FunctionLiteral*>(callee);
+	  } else if (callee->kind() == NodeKind::identifier) {
+	    auto& name = static_cast<Identifier*>(callee)->value();
+	    auto binding = scope.find(name);
+	    if (!binding) {
+	      return builtin_func_map.count(name) ? builtin_result(name) : any;
+	    }
+	    if (binding->mixed) {
+	      return any;
+	    }
+	    // bound later in the pass, or to nothing yet
+	    literal = binding->function;
+	    if (!literal) {
+	      return 0;
+	    }
+	  }
+	  if (!literal) {
+	    return any;
+	  }
+	  auto& info = _functions[literal];
+	  if (args.size() != literal->parameters().size()) {
+	    return 0;
+	  }
+	  info.parameters.resize(args.size());
+	  for (std::size_t i = 0; i < args.size(); ++i) {
+	    bind(info.parameters[i], args[i]);
+	  }
+	  return info.result;
+	}
+
+	Types index(IndexExpression* node, Scope& scope) {
+	  auto arr = expression(node->array(), scope);
+	  auto idx = expression(node->index(), scope);
+	  auto hash = bit(Object::hash_object_t);
+	  bool proven = single(arr) && (arr == hash || ((arr == array || arr == int_array) && idx == integer));
+	  site(node, proven, "indexes " + to_string(arr) + " with " + to_string(idx));
+
+	  Types res = 0;
+	  if (arr & (array | hash)) {
+	    res = any;
+	  }
+	  if (arr & int_array) {
+	    res |= integer | bit(Object::null_object_t);
+	  }
+	  return res;
+	}
+
+	Scope _globals;
+	// node based, a Scope's outer stays put while the map grows
+	std::unordered_map<FunctionLiteral*, Function> _functions;
+	Function* _function{}; // whose body is being walked
+	bool _changed{};
+	bool _reporting{};
+	Report _report;
+      };
+    }
+
+    std::string to_string(Types types) {
+      if (!types) {
+	return "unknown";
+      }
+      if (types == any) {
+	return "any type";
+      }
+      std::string res;
+      for (std::size_t i = 0; i < object_type_count; ++i) {
+	if (types >> i & 1) {
+	  res += (res.empty() ? "" : " or ");
+	  res += Void::to_string(static_cast<Object::ObjectType>(i));
+	}
+      }
+      return res;
+    }
+
+    void Report::merge(Report const& other) {
+      sites += other.sites;
+      proven += other.proven;
+      failures.insert(failures.end(), other.failures.begin(), other.failures.end());
+    }
+
+    Report infer(Program& program) {
+      return Inference().run(program);
+    }
+
+    void write_report(std::ostream& os, Report const& report) {
+      os << "type inference: " << report.proven << " of " << report.sites << " sites proven\n";
+      for (auto& failure : report.failures) {
+	os << "  line " << failure.line << ": " << Void::to_string(failure.kind) << ": " << failure.reason << '\n';
+      }
+    }
+  }
+}
@@ -0,0 +1,213 @@
+#include "protocol.hpp"
+
+#include <void/histogram.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Load generator for void_cli --serve. Every connection keeps `pipeline`
+// requests in flight: it sends a batch, waits for all of its responses,
+// and records each request's latency from send to response.
+
+using namespace Void;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+  struct Options {
+    std::string socket_path;
+    unsigned connections = 4;
+    std::uint64_t requests = 100000; // per connection
+    unsigned pipeline = 16;
+    std::string eval;
+    std::string call;
+    std::vector<server::Arg> args;
+  };
+
+  struct Result {
+    Histogram latency_ns;
+    std::uint64_t errors{};
+    bool failed{};
+  };
+
+  void usage() {
+    std::cerr << "usage: void_load --socket=PATH (--eval=SOURCE | --call=NAME [--arg=VALUE]...)\n"
+	      << "                 [--connections=N] [--requests=N] [--pipeline=N]\n";
+  }
+
+  int connect_to(std::string const& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+      return -1;
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  bool write_all(int fd, std::string const& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+      auto n = write(fd, data.data() + sent, data.size() - sent);
+      if (n <= 0) {
+	return false;
+      }
+      sent += n;
+    }
+    return true;
+  }
+
+  void run_connection(Options const& options, Result& result) {
+    int fd = connect_to(options.socket_path);
+    if (fd < 0) {
+      result.failed = true;
+      return;
+    }
+
+    // the batch is the same every time, encode it once
+    std::string batch;
+    for (unsigned i = 0; i < options.pipeline; ++i) {
+      if (options.call.empty()) {
+	server::append_eval(batch, options.eval);
+      } else {
+	server::append_call(batch, options.call, options.args);
+      }
+    }
+
+    std::string in(64 * 1024, '\0');
+    std::size_t used = 0;
+    std::uint64_t done = 0;
+    while (done < options.requests) {
+      auto count = std::min<std::uint64_t>(options.pipeline, options.requests - done);
+      auto start = Clock::now();
+      if (!write_all(fd, count == options.pipeline ? batch : batch.substr(0, batch.size() / options.pipeline * count))) {
+	result.failed = true;
+	break;
+      }
+
+      for (std::uint64_t received = 0; received < count;) {
+	std::string_view payload;
+	auto state = server::next_frame(std::string_view(in.data(), used), payload);
+	if (state == server::Parse::ok) {
+	  auto now = Clock::now();
+	  result.latency_ns.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count());
+	  if (payload.empty() || static_cast<server::Status>(payload[0]) != server::Status::ok) {
+	    ++result.errors;
+	  }
+	  auto consumed = server::header_size + payload.size();
+	  std::memmove(in.data(), in.data() + consumed, used - consumed);
+	  used -= consumed;
+	  ++received;
+	  continue;
+	}
+	if (state == server::Parse::invalid) {
+	  result.failed = true;
+	  close(fd);
+	  return;
+	}
+	if (in.size() - used < 4096) {
+	  in.resize(in.size() * 2);
+	}
+	auto n = read(fd, in.data() + used, in.size() - used);
+	if (n <= 0) {
+	  result.failed = true;
+	  close(fd);
+	  return;
+	}
+	used += n;
+      }
+      done += count;
+    }
+    close(fd);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    std::string value(arg.substr(arg.find('=') + 1));
+    if (arg.rfind("--socket=", 0) == 0) {
+      options.socket_path = value;
+    } else if (arg.rfind("--connections=", 0) == 0) {
+      options.connections = std::atoi(value.c_str());
+    } else if (arg.rfind("--requests=", 0) == 0) {
+      options.requests = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (arg.rfind("--pipeline=", 0) == 0) {
+      options.pipeline = std::atoi(value.c_str());
+    } else if (arg.rfind("--eval=", 0) == 0) {
+      options.eval = value;
+    } else if (arg.rfind("--call=", 0) == 0) {
+      options.call = value;
+    } else if (arg.rfind("--arg=", 0) == 0) {
+      // integers when the whole value parses as one, strings otherwise
+      char* end;
+      errno = 0;
+      auto number = std::strtoll(value.c_str(), &end, 10);
+      if (!value.empty() && *end == '\0' && errno == 0) {
+	options.args.emplace_back(std::int64_t{number});
+      } else {
+	options.args.emplace_back(value);
+      }
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (options.socket_path.empty() || options.eval.empty() == options.call.empty() ||
+      options.connections == 0 || options.pipeline == 0) {
+    usage();
+    return 2;
+  }
+
+  std::vector<Result> results(options.connections);
+  std::vector<std::thread> threads;
+  auto start = Clock::now();
+  for (auto& result : results) {
+    threads.emplace_back(run_connection, std::cref(options), std::ref(result));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  Histogram latency;
+  std::uint64_t errors = 0;
+  bool failed = false;
+  for (auto& result : results) {
+    latency.merge(result.latency_ns);
+    errors += result.errors;
+    failed |= result.failed;
+  }
+
+  std::cout << "requests:    " << latency.count() << '\n'
+	    << "errors:      " << errors << '\n'
+	    << "seconds:     " << seconds << '\n'
+	    << "throughput:  " << static_cast<std::uint64_t>(latency.count() / seconds) << " req/s\n"
+	    << "latency p50: " << latency.percentile(50) / 1000.0 << " us\n"
+	    << "latency p99: " << latency.percentile(99) / 1000.0 << " us\n"
+	    << "latency max: " << latency.max() / 1000.0 << " us\n";
+  if (failed) {
+    std::cerr << "void_load: some connections failed\n";
+    return 1;
+  }
+  return 0;
+}
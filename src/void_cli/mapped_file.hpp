@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Void {
+  // read only mapping of a whole regular file, not ok when it cannot be
+  // opened or mapped
+  class MappedFile {
+  public:
+    explicit MappedFile(std::string const& path) {
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+	return;
+      }
+      struct stat st;
+      if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+	if (st.st_size == 0) {
+	  _ok = true;
+	} else {
+	  auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	  if (data != MAP_FAILED) {
+	    _data = static_cast<char const*>(data);
+	    _size = st.st_size;
+	    _ok = true;
+	  }
+	}
+      }
+      close(fd);
+    }
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    ~MappedFile() {
+      if (_data) {
+	munmap(const_cast<char*>(_data), _size);
+      }
+    }
+
+    bool ok() const { return _ok; }
+    std::string_view view() const { return {_data, _size}; }
+
+  private:
+    char const* _data{};
+    std::size_t _size{};
+    bool _ok{};
+  };
+}
@@ -0,0 +1,68 @@
+#include "protocol.hpp"
+
+namespace Void::server {
+  void put_u32(std::string& out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+  }
+
+  std::uint32_t get_u32(char const* data) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+      value |= std::uint32_t{static_cast<unsigned char>(data[i])} << (8 * i);
+    }
+    return value;
+  }
+
+  std::uint64_t get_u64(char const* data) {
+    return get_u32(data) | std::uint64_t{get_u32(data + 4)} << 32;
+  }
+
+  void append_eval(std::string& out, std::string_view source) {
+    put_u32(out, static_cast<std::uint32_t>(1 + source.size()));
+    out.push_back(static_cast<char>(Kind::eval));
+    out.append(source);
+  }
+
+  void append_call(std::string& out, std::string_view name, std::vector<Arg> const& args) {
+    auto start = out.size();
+    put_u32(out, 0);
+    out.push_back(static_cast<char>(Kind::call));
+    name = name.substr(0, 255);
+    out.push_back(static_cast<char>(name.size()));
+    out.append(name);
+    for (auto& arg : args) {
+      if (auto value = std::get_if<std::int64_t>(&arg)) {
+	out.push_back('i');
+	put_u32(out, static_cast<std::uint32_t>(*value));
+	put_u32(out, static_cast<std::uint32_t>(static_cast<std::uint64_t>(*value) >> 32));
+      } else {
+	auto& str = std::get<std::string>(arg);
+	out.push_back('s');
+	put_u32(out, static_cast<std::uint32_t>(str.size()));
+	out.append(str);
+      }
+    }
+
+    // patch the size now that the payload is known
+    std::string size;
+    put_u32(size, static_cast<std::uint32_t>(out.size() - start - header_size));
+    out.replace(start, header_size, size);
+  }
+
+  Parse next_frame(std::string_view buffer, std::string_view& payload) {
+    if (buffer.size() < header_size) {
+      return Parse::partial;
+    }
+    auto size = get_u32(buffer.data());
+    if (size > max_frame_size) {
+      return Parse::invalid;
+    }
+    if (buffer.size() - header_size < size) {
+      return Parse::partial;
+    }
+    payload = buffer.substr(header_size, size);
+    return Parse::ok;
+  }
+}
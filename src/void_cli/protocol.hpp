@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace Void::server {
+  // Every message is a frame: a 32 bit little endian size, then that many
+  // bytes of payload. Requests are a Kind byte followed by
+  //   eval: the source text
+  //   call: u8 name size, the name, then each argument as
+  //         'i' and a 64 bit little endian integer, or
+  //         's', a 32 bit size and the string bytes
+  // Responses are a Status byte followed by the result as the REPL prints it.
+  enum class Kind : std::uint8_t {
+    eval = 1,
+    call = 2,
+  };
+
+  enum class Status : std::uint8_t {
+    ok = 0,
+    error = 1,
+  };
+
+  inline constexpr std::size_t header_size = 4;
+  inline constexpr std::size_t max_frame_size = std::size_t{64} << 20;
+
+  using Arg = std::variant<std::int64_t, std::string>;
+
+  void put_u32(std::string&, std::uint32_t);
+  std::uint32_t get_u32(char const*);
+  std::uint64_t get_u64(char const*);
+
+  void append_eval(std::string& out, std::string_view source);
+  void append_call(std::string& out, std::string_view name, std::vector<Arg> const& args);
+
+  enum class Parse {
+    ok,
+    partial, // wait for more bytes
+    invalid, // oversized frame, drop the connection
+  };
+
+  // the first frame in buffer, payload excludes the size field
+  Parse next_frame(std::string_view buffer, std::string_view& payload);
+}
@@ -3,28 +3,314 @@
 #include <vector>
 #include <void/ast.hpp>
 #include <void/parser.hpp>
+#include <void/heap_profiler.hpp>
+#include <void/perf_counters.hpp>
+#include <void/tracer.hpp>
+#include <void/type_feedback.hpp>
+#include <void/type_inference.hpp>
 
+#include "server.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string_view>
+
+bool read_line(std::string& line) {
+  return static_cast<bool>(std::getline(std::cin, line));
+}
+
+void usage() {
+  std::cerr << "usage: void_cli [--snapshot=FILE] [--preload=FILE]... [--save-snapshot=FILE]\n"
+	    << "                [--serve=SOCKET [--workers=N]] [--profile=PREFIX] [--stats]\n"
+	    << "                [--heap-profile] [--time] [--trace=FILE [--trace-filter=NAME,...]]\n"
+	    << "                [--perf-counters] [--feedback=FILE] [--infer] [SCRIPT]\n";
+}
+
+// the evaluator's counters as one line of JSON on stderr
+void write_stats(Void::Evaluator const& evaluator) {
+  if (!Void::stats_enabled) {
+    std::cerr << "void_cli: built without VOID_STATS, no counters\n";
+    return;
+  }
+  std::cerr << evaluator.stats().counters.to_json() << '\n';
+}
+
+// the snapshot first, then the preloads on top of it
+bool load(Void::Evaluator& evaluator, Void::server::Options const& options) {
+  if (!options.snapshot.empty()) {
+    Void::MappedFile image(options.snapshot);
+    auto res = image.ok() ? evaluator.restore(image.view()) : std::make_shared<Void::Error>("cannot read " + options.snapshot);
+    if (res->type() == Void::Object::error_object_t) {
+      std::cerr << "void_cli: " << res->inspect() << '\n';
+      return false;
+    }
+  }
+  for (auto& path : options.preload) {
+    Void::MappedFile file(path);
+    auto res = file.ok() ? evaluator.eval(std::string(file.view())) : std::make_shared<Void::Error>("cannot read " + path);
+    if (res->type() == Void::Object::error_object_t) {
+      std::cerr << "void_cli: " << path << ": " << res->inspect() << '\n';
+      return false;
+    }
+  }
+  return true;
+}
+
+int save_snapshot(Void::server::Options const& options, std::string const& path) {
+  Void::Evaluator evaluator{};
+  if (!load(evaluator, options)) {
+    return 1;
+  }
+  auto image = evaluator.snapshot();
+  std::ofstream out(path, std::ios::binary);
+  if (!out.write(image.data(), image.size())) {
+    std::cerr << "void_cli: cannot write " << path << '\n';
+    return 1;
+  }
+  return 0;
+}
+
+// one line of JSON on stderr per eval, see Void::EvalTiming
+void write_timing(Void::EvalTiming const& timing) {
+  std::cerr << timing.to_json() << '\n';
+}
+
+int run_script(Void::server::Options const& options, std::string const& path, bool stats,
+	       Void::type_feedback::Profile* profile, Void::type_inference::Report* inference) {
+  Void::Evaluator evaluator{};
+  evaluator.set_profile(profile);
+  evaluator.set_inference(inference);
+  Void::MappedFile file(path);
+  if (!file.ok()) {
+    std::cerr << "void_cli: cannot read " << path << '\n';
+    return 1;
+  }
+  if (!load(evaluator, options)) {
+    return 1;
+  }
+  Void::EvalTiming timing;
+  auto res = options.time ? evaluator.eval(std::string(file.view()), timing) : evaluator.eval(std::string(file.view()));
+  if (options.time) {
+    write_timing(timing);
+  }
+  if (stats) {
+    write_stats(evaluator);
+  }
+  if (res->type() == Void::Object::error_object_t) {
+    std::cerr << "void_cli: " << path << ": " << res->inspect() << '\n';
+    return 1;
+  }
+  return 0;
+}
+
+// PREFIX.folded for flamegraph.pl and PREFIX.pprof for pprof
+int write_profile(std::string const& prefix) {
+  Void::profiler::stop();
+  std::ofstream folded(prefix + ".folded");
+  Void::profiler::write_folded(folded);
+  std::ofstream pprof(prefix + ".pprof", std::ios::binary);
+  Void::profiler::write_pprof(pprof);
+  if (!folded || !pprof) {
+    std::cerr << "void_cli: cannot write " << prefix << ".folded or " << prefix << ".pprof\n";
+    return 1;
+  }
+  auto summary = Void::profiler::summary();
+  std::cerr << "void_cli: " << summary.samples << " samples";
+  if (summary.dropped) {
+    std::cerr << ", " << summary.dropped << " dropped";
+  }
+  std::cerr << '\n';
+  return 0;
+}
+
+// Chrome trace event JSON of every traced call
+int write_trace(std::string const& path) {
+  Void::tracer::stop();
+  std::ofstream out(path);
+  Void::tracer::write_chrome_json(out);
+  if (!out) {
+    std::cerr << "void_cli: cannot write " << path << '\n';
+    return 1;
+  }
+  auto summary = Void::tracer::summary();
+  std::cerr << "void_cli: " << summary.events << " trace events";
+  if (summary.overwritten) {
+    std::cerr << ", " << summary.overwritten << " overwritten";
+  }
+  std::cerr << '\n';
+  return 0;
+}
 
-std::string read_line() {
-  std::string line;
-  std::getline(std::cin, line);
-  return line;
+// a missing file starts an empty profile
+bool read_feedback(std::string const& path, Void::type_feedback::Profile& profile) {
+  std::ifstream in(path);
+  if (in && !profile.read(in)) {
+    std::cerr << "void_cli: " << path << " is not a feedback profile\n";
+    return false;
+  }
+  return true;
 }
 
-int main() {
-  int status; 
+int write_feedback(std::string const& path, Void::type_feedback::Profile const& profile) {
+  std::ofstream out(path);
+  profile.write(out);
+  if (!out) {
+    std::cerr << "void_cli: cannot write " << path << '\n';
+    return 1;
+  }
+  return 0;
+}
 
+int repl(Void::server::Options const& options, bool stats, Void::type_feedback::Profile* profile,
+	 Void::type_inference::Report* inference) {
   Void::Evaluator evaluator{};
+  evaluator.set_profile(profile);
+  evaluator.set_inference(inference);
+  if (!load(evaluator, options)) {
+    return 1;
+  }
   
   while (1) { 
     std::cout << ">> ";
-    std::string line_str = read_line();
-    if (line_str == "exit") {
+    std::cout.flush();
+    std::string line_str;
+    if (!read_line(line_str) || line_str == "exit") {
       break;
     }
-    auto res = evaluator.eval(line_str);
-    std::cout << res->inspect() << std::endl;
+    Void::EvalTiming timing;
+    auto res = options.time ? evaluator.eval(line_str, timing) : evaluator.eval(line_str);
+    auto printing = std::chrono::steady_clock::now();
+    Void::StreamSink out(std::cout, Void::display_limits);
+    res->write_to(out);
+    out.finish("\n");
+    out.flush();
+    std::cout.flush();
+    if (options.time) {
+      timing.print = std::chrono::steady_clock::now() - printing;
+      write_timing(timing);
+    }
+  }
+  if (stats) {
+    write_stats(evaluator);
   }
   return 0; 
 }
+
+int main(int argc, char* argv[]) {
+  Void::server::Options server;
+  bool serve = false;
+  std::string save;
+  std::string profile;
+  std::string script;
+  bool stats = false;
+  bool heap_profile = false;
+  bool perf_counters = false;
+  std::string feedback;
+  bool infer = false;
+  std::string trace;
+  std::vector<std::string> trace_filter;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    auto value = arg.substr(arg.find('=') + 1);
+    if (arg.rfind("--serve=", 0) == 0) {
+      serve = true;
+      server.socket_path = value;
+    } else if (arg.rfind("--workers=", 0) == 0) {
+      server.workers = std::atoi(argv[i] + std::string_view("--workers=").size());
+    } else if (arg.rfind("--preload=", 0) == 0) {
+      server.preload.emplace_back(value);
+    } else if (arg.rfind("--snapshot=", 0) == 0) {
+      server.snapshot = value;
+    } else if (arg.rfind("--save-snapshot=", 0) == 0) {
+      save = value;
+    } else if (arg.rfind("--profile=", 0) == 0) {
+      profile = value;
+    } else if (arg == "--stats") {
+      stats = true;
+    } else if (arg.rfind("--trace=", 0) == 0) {
+      trace = value;
+    } else if (arg.rfind("--trace-filter=", 0) == 0) {
+      for (std::size_t begin = 0, end; begin <= value.size(); begin = end + 1) {
+	end = std::min(value.find(',', begin), value.size());
+	if (end > begin) {
+	  trace_filter.emplace_back(value.substr(begin, end - begin));
+	}
+      }
+    } else if (arg == "--time") {
+      server.time = true;
+    } else if (arg == "--heap-profile") {
+      heap_profile = true;
+    } else if (arg == "--perf-counters") {
+      perf_counters = true;
+    } else if (arg.rfind("--feedback=", 0) == 0) {
+      feedback = value;
+    } else if (arg == "--infer") {
+      infer = true;
+    } else if (arg.rfind("--", 0) != 0 && script.empty()) {
+      script = arg;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  if (!save.empty()) {
+    return save_snapshot(server, save);
+  }
+
+  if (!profile.empty() && !Void::profiler::start(std::chrono::microseconds(1000))) {
+    std::cerr << "void_cli: cannot start the profiler\n";
+    return 1;
+  }
+  // reports go to stderr on heap_profile() or kill -USR1
+  if (heap_profile) {
+    Void::heap_profiler::start();
+    Void::heap_profiler::dump_on_signal();
+  }
+  if (!trace.empty()) {
+    Void::tracer::start(trace_filter);
+  }
+  if (perf_counters && !Void::perf_counters::start()) {
+    std::cerr << "void_cli: cannot open perf counters, see /proc/sys/kernel/perf_event_paranoid\n";
+    return 1;
+  }
+  // type feedback of the script or REPL, not of served requests
+  Void::type_feedback::Profile feedback_profile;
+  if (!feedback.empty() && !read_feedback(feedback, feedback_profile)) {
+    return 1;
+  }
+  auto types = feedback.empty() ? nullptr : &feedback_profile;
+  // likewise what type inference could not prove, written on exit
+  Void::type_inference::Report inference;
+  auto inferred = infer ? &inference : nullptr;
+  int status;
+  if (serve) {
+    status = Void::server::serve(server);
+  } else if (!script.empty()) {
+    status = run_script(server, script, stats, types, inferred);
+  } else {
+    status = repl(server, stats, types, inferred);
+  }
+  if (infer && !serve) {
+    Void::type_inference::write_report(std::cerr, inference);
+  }
+  if (!feedback.empty() && !serve && write_feedback(feedback, feedback_profile) != 0 && status == 0) {
+    status = 1;
+  }
+  if (!profile.empty() && write_profile(profile) != 0 && status == 0) {
+    status = 1;
+  }
+  if (!trace.empty() && write_trace(trace) != 0 && status == 0) {
+    status = 1;
+  }
+  if (perf_counters) {
+    Void::perf_counters::stop();
+    Void::perf_counters::write_report(std::cerr);
+  }
+  return status;
+}
@@ -0,0 +1,403 @@
+#include "server.hpp"
+#include "protocol.hpp"
+#include "mapped_file.hpp"
+
+#include <void/evaluator.hpp>
+#include <void/sink.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Void::server {
+  namespace {
+    constexpr std::size_t read_size = 64 * 1024;
+    // a huge result is cut like in the REPL instead of flooding the client
+    constexpr PrintLimits response_limits{64, std::size_t{16} << 20};
+
+    std::atomic<bool> stopping{false};
+    // workers add their timings here when they stop
+    std::mutex timings_mutex;
+
+    void on_signal(int) {
+      stopping.store(true);
+    }
+
+    void set_nonblocking(int fd) {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    // serializes a result straight into the connection's output buffer
+    class ResponseSink : public Sink {
+    public:
+      explicit ResponseSink(std::string& out)
+	: Sink(response_limits), _out(out) {}
+      ~ResponseSink() override { flush(); }
+
+    protected:
+      void write_out(char const* data, std::size_t size) override {
+	_out.append(data, size);
+      }
+
+    private:
+      std::string& _out;
+    };
+
+    struct Connection {
+      explicit Connection(int fd) : fd(fd) {}
+
+      int fd;
+      std::string in;
+      std::size_t in_used{};
+      std::string out;
+      std::size_t out_sent{};
+    };
+
+    class Worker {
+    public:
+      // timings is where to add the worker's eval timings, if anywhere
+      Worker(std::string_view image, std::vector<std::string> const& preload, TimingHistograms* timings)
+	: _image(image), _preload(preload), _total_timings(timings) {
+	if (pipe(_wake) != 0) {
+	  throw std::runtime_error(std::strerror(errno));
+	}
+	set_nonblocking(_wake[0]);
+	_thread = std::thread([this] { run(); });
+      }
+
+      ~Worker() {
+	wake();
+	_thread.join();
+	close(_wake[0]);
+	close(_wake[1]);
+      }
+
+      void add(int fd) {
+	{
+	  std::lock_guard<std::mutex> lock(_mutex);
+	  _incoming.push_back(fd);
+	}
+	wake();
+      }
+
+      void wake() {
+	char c = 0;
+	[[maybe_unused]] auto n = write(_wake[1], &c, 1);
+      }
+
+    private:
+      void run();
+      void accept_incoming();
+      bool read_requests(Connection&);
+      bool write_responses(Connection&);
+      void handle(std::string_view request, std::string& out);
+      std::shared_ptr<Object> call(std::string_view request);
+
+      std::string_view _image;
+      std::vector<std::string> const& _preload;
+      TimingHistograms* _total_timings;
+      int _wake[2];
+      std::mutex _mutex;
+      std::vector<int> _incoming;
+      std::thread _thread;
+
+      // owned by the worker thread
+      std::unique_ptr<Evaluator> _evaluator;
+      std::unordered_map<std::string, Callable> _callables;
+      std::vector<std::shared_ptr<Object>> _args;
+      std::vector<std::unique_ptr<Connection>> _connections;
+      TimingHistograms _timings;
+    };
+
+    void Worker::run() {
+      _evaluator = std::make_unique<Evaluator>();
+      if (!_image.empty()) {
+	auto res = _evaluator->restore(_image);
+	if (res->type() == Object::error_object_t) {
+	  std::cerr << "void_cli: snapshot: " << res->inspect() << '\n';
+	}
+      }
+      for (auto& source : _preload) {
+	auto res = _evaluator->eval(source);
+	if (res->type() == Object::error_object_t) {
+	  std::cerr << "void_cli: preload: " << res->inspect() << '\n';
+	}
+      }
+
+      std::vector<pollfd> fds;
+      while (!stopping.load()) {
+	fds.clear();
+	fds.push_back({_wake[0], POLLIN, 0});
+	for (auto& conn : _connections) {
+	  short events = POLLIN;
+	  if (conn->out_sent < conn->out.size()) {
+	    events |= POLLOUT;
+	  }
+	  fds.push_back({conn->fd, events, 0});
+	}
+
+	if (poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) {
+	  break;
+	}
+
+	if (fds[0].revents) {
+	  char buf[64];
+	  while (read(_wake[0], buf, sizeof(buf)) > 0) {}
+	  accept_incoming();
+	}
+
+	// connections added above have no pollfd yet, they are visited next round
+	std::size_t polled = fds.size() - 1;
+	for (std::size_t i = 0, j = 0; i < polled; ++i) {
+	  auto& conn = *_connections[j];
+	  auto revents = fds[i + 1].revents;
+	  bool alive = true;
+	  if (revents & (POLLIN | POLLHUP | POLLERR)) {
+	    alive = read_requests(conn);
+	  }
+	  if (alive && conn.out_sent < conn.out.size()) {
+	    alive = write_responses(conn);
+	  }
+	  if (alive) {
+	    ++j;
+	  } else {
+	    close(conn.fd);
+	    _connections.erase(_connections.begin() + j);
+	  }
+	}
+      }
+
+      for (auto& conn : _connections) {
+	close(conn->fd);
+      }
+      _connections.clear();
+      _callables.clear();
+      _evaluator.reset();
+      if (_total_timings) {
+	std::lock_guard<std::mutex> lock(timings_mutex);
+	_total_timings->merge(_timings);
+      }
+    }
+
+    void Worker::accept_incoming() {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for (auto fd : _incoming) {
+	_connections.push_back(std::make_unique<Connection>(fd));
+      }
+      _incoming.clear();
+    }
+
+    // false when the connection is done
+    bool Worker::read_requests(Connection& conn) {
+      bool open = true;
+      while (true) {
+	if (conn.in.size() - conn.in_used < read_size) {
+	  conn.in.resize(conn.in_used + read_size);
+	}
+	auto n = read(conn.fd, conn.in.data() + conn.in_used, conn.in.size() - conn.in_used);
+	if (n > 0) {
+	  conn.in_used += n;
+	  continue;
+	}
+	if (n < 0 && errno == EINTR) {
+	  continue;
+	}
+	open = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+	break;
+      }
+
+      // everything that arrived is one batch
+      std::string_view buffer(conn.in.data(), conn.in_used);
+      std::string_view payload;
+      Parse state;
+      while ((state = next_frame(buffer, payload)) == Parse::ok) {
+	handle(payload, conn.out);
+	buffer.remove_prefix(header_size + payload.size());
+      }
+      if (state == Parse::invalid) {
+	return false;
+      }
+      std::memmove(conn.in.data(), buffer.data(), buffer.size());
+      conn.in_used = buffer.size();
+
+      return open || conn.out_sent < conn.out.size();
+    }
+
+    bool Worker::write_responses(Connection& conn) {
+      while (conn.out_sent < conn.out.size()) {
+	auto n = write(conn.fd, conn.out.data() + conn.out_sent, conn.out.size() - conn.out_sent);
+	if (n > 0) {
+	  conn.out_sent += n;
+	} else if (n < 0 && errno == EINTR) {
+	  continue;
+	} else {
+	  return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+	}
+      }
+      conn.out.clear();
+      conn.out_sent = 0;
+      return true;
+    }
+
+    void Worker::handle(std::string_view request, std::string& out) {
+      std::shared_ptr<Object> res;
+      std::optional<EvalTiming> timing;
+      if (request.empty()) {
+	res = std::make_shared<Error>("empty request");
+      } else if (static_cast<Kind>(request[0]) == Kind::eval) {
+	if (_total_timings) {
+	  res = _evaluator->eval(std::string(request.substr(1)), timing.emplace());
+	} else {
+	  res = _evaluator->eval(std::string(request.substr(1)));
+	}
+	// the eval may have rebound any name
+	_callables.clear();
+      } else if (static_cast<Kind>(request[0]) == Kind::call) {
+	res = call(request.substr(1));
+      } else {
+	res = std::make_shared<Error>("unknown request");
+      }
+
+      auto start = out.size();
+      put_u32(out, 0);
+      out.push_back(static_cast<char>(res->type() == Object::error_object_t ? Status::error : Status::ok));
+      auto printing = timing ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+      {
+	ResponseSink sink(out);
+	res->write_to(sink);
+      }
+      if (timing) {
+	timing->print = std::chrono::steady_clock::now() - printing;
+	_timings.record(*timing);
+      }
+      std::string size;
+      put_u32(size, static_cast<std::uint32_t>(out.size() - start - header_size));
+      out.replace(start, header_size, size);
+    }
+
+    std::shared_ptr<Object> Worker::call(std::string_view request) {
+      if (request.empty() || request.size() - 1 < static_cast<unsigned char>(request[0])) {
+	return std::make_shared<Error>("malformed call");
+      }
+      std::string name(request.substr(1, static_cast<unsigned char>(request[0])));
+      request.remove_prefix(1 + name.size());
+
+      _args.clear();
+      while (!request.empty()) {
+	auto tag = request[0];
+	request.remove_prefix(1);
+	if (tag == 'i' && request.size() >= 8) {
+	  _args.push_back(Integer::make(static_cast<std::int64_t>(get_u64(request.data()))));
+	  request.remove_prefix(8);
+	} else if (tag == 's' && request.size() >= 4 && request.size() - 4 >= get_u32(request.data())) {
+	  auto size = get_u32(request.data());
+	  _args.push_back(std::make_shared<String>(std::string(request.substr(4, size))));
+	  request.remove_prefix(4 + size);
+	} else {
+	  return std::make_shared<Error>("malformed call");
+	}
+      }
+
+      // functions are resolved once per name until an eval rebinds names
+      auto it = _callables.find(name);
+      if (it == _callables.end()) {
+	it = _callables.emplace(name, _evaluator->lookup_function(name)).first;
+      }
+      if (!it->second) {
+	return std::make_shared<Error>("not a function: " + name);
+      }
+      return _evaluator->call(it->second.function(), Args(_args));
+    }
+  }
+
+  int serve(Options const& options) {
+    std::optional<MappedFile> snapshot;
+    if (!options.snapshot.empty()) {
+      snapshot.emplace(options.snapshot);
+      if (!snapshot->ok()) {
+	std::cerr << "void_cli: cannot read " << options.snapshot << '\n';
+	return 1;
+      }
+    }
+    std::vector<std::string> preload;
+    for (auto& path : options.preload) {
+      MappedFile file(path);
+      if (!file.ok()) {
+	std::cerr << "void_cli: cannot read " << path << '\n';
+	return 1;
+      }
+      preload.emplace_back(file.view());
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (options.socket_path.size() >= sizeof(addr.sun_path)) {
+      std::cerr << "void_cli: socket path too long\n";
+      return 1;
+    }
+    std::strcpy(addr.sun_path, options.socket_path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(options.socket_path.c_str());
+    if (listener < 0 ||
+	bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+	listen(listener, SOMAXCONN) != 0) {
+      std::cerr << "void_cli: " << options.socket_path << ": " << std::strerror(errno) << '\n';
+      return 1;
+    }
+
+    // no SA_RESTART, a signal has to interrupt poll
+    struct sigaction action{};
+    action.sa_handler = on_signal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    TimingHistograms timings;
+    {
+      std::vector<std::unique_ptr<Worker>> workers;
+      for (unsigned i = 0; i < std::max(options.workers, 1u); ++i) {
+	workers.push_back(std::make_unique<Worker>(snapshot ? snapshot->view() : std::string_view(), preload,
+						   options.time ? &timings : nullptr));
+      }
+
+      std::size_t next = 0;
+      while (!stopping.load()) {
+	pollfd fd{listener, POLLIN, 0};
+	if (poll(&fd, 1, -1) <= 0) {
+	  continue;
+	}
+	int conn = accept(listener, nullptr, nullptr);
+	if (conn < 0) {
+	  continue;
+	}
+	set_nonblocking(conn);
+	workers[next++ % workers.size()]->add(conn);
+      }
+      // destroying the workers wakes and joins them
+    }
+
+    close(listener);
+    unlink(options.socket_path.c_str());
+    if (options.time) {
+      std::cerr << timings.to_json() << '\n';
+    }
+    return 0;
+  }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Void::server {
+  struct Options {
+    std::string socket_path;
+    std::string snapshot;             // image every evaluator restores first
+    std::vector<std::string> preload; // script files run by every evaluator
+    unsigned workers = 1;
+    bool time = false; // per phase histograms of evals, on stderr at exit
+  };
+
+  // Serves framed eval and call requests (see protocol.hpp) on a Unix
+  // socket until SIGINT or SIGTERM. Each worker thread owns one warm
+  // Evaluator and the connections assigned to it, so bindings made by an
+  // eval are seen by later requests on the same worker. All complete
+  // requests read in one wakeup run as a batch and their responses go out
+  // in a single write. Returns the process exit status.
+  int serve(Options const&);
+}
@@ -0,0 +1,82 @@
+#include <void/bigint.hpp>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <string>
+
+using namespace Void;
+
+namespace {
+  BigInt parse(std::string const& digits) {
+    BigInt res;
+    EXPECT_TRUE(BigInt::parse(digits, res));
+    return res;
+  }
+
+  BigInt random_big(std::mt19937& rng, std::size_t digits) {
+    std::string str(1, '1' + rng() % 9);
+    for (std::size_t i = 1; i < digits; ++i) {
+      str += static_cast<char>('0' + rng() % 10);
+    }
+    return parse(str);
+  }
+}
+
+TEST(bigint, TestParseAndPrint) {
+  EXPECT_EQ(parse("0").to_string(), "0");
+  EXPECT_EQ(parse("-0").to_string(), "0");
+  EXPECT_EQ(parse("000123").to_string(), "123");
+  EXPECT_EQ(parse("-1000000000000000000000").to_string(), "-1000000000000000000000");
+  EXPECT_EQ(BigInt(INT64_MIN).to_string(), "-9223372036854775808");
+
+  BigInt res;
+  EXPECT_FALSE(BigInt::parse("", res));
+  EXPECT_FALSE(BigInt::parse("12a", res));
+}
+
+TEST(bigint, TestInt64Range) {
+  EXPECT_TRUE(BigInt(INT64_MAX).fits_int64());
+  EXPECT_TRUE(BigInt(INT64_MIN).fits_int64());
+  EXPECT_EQ(BigInt(INT64_MIN).to_int64(), INT64_MIN);
+  EXPECT_FALSE((BigInt(INT64_MAX) + BigInt(1)).fits_int64());
+  EXPECT_FALSE((-BigInt(INT64_MIN)).fits_int64());
+  EXPECT_TRUE((BigInt(INT64_MAX) + BigInt(1) - BigInt(1)).fits_int64());
+}
+
+TEST(bigint, TestArithmetic) {
+  auto two64 = parse("18446744073709551616");
+  EXPECT_EQ((two64 * two64).to_string(), "340282366920938463463374607431768211456");
+  EXPECT_EQ((two64 - two64).to_string(), "0");
+  EXPECT_EQ((BigInt(5) - two64).to_string(), "-18446744073709551611");
+
+  BigInt fact(1);
+  for (int i = 2; i <= 30; ++i) {
+    fact = fact * BigInt(i);
+  }
+  EXPECT_EQ(fact.to_string(), "265252859812191058636308480000000");
+
+  // truncates toward zero, the remainder takes the sign of the dividend
+  EXPECT_EQ((parse("-7") / BigInt(2)).to_string(), "-3");
+  EXPECT_EQ((parse("-7") % BigInt(2)).to_string(), "-1");
+  EXPECT_EQ((fact / two64).to_string(), "14379386343318");
+  EXPECT_LT(parse("-100000000000000000000"), BigInt(-1));
+  EXPECT_GT(two64, BigInt(INT64_MAX));
+}
+
+TEST(bigint, TestKaratsubaAndDivision) {
+  std::mt19937 rng(42);
+  for (auto digits : {50, 400, 1000, 3000}) {
+    auto a = random_big(rng, digits);
+    auto b = random_big(rng, digits / 2 + 7);
+    auto r = random_big(rng, digits / 3);
+
+    // (a + b)^2 computed two ways, the large products go through Karatsuba
+    EXPECT_EQ((a + b) * (a + b), a * a + BigInt(2) * a * b + b * b);
+
+    auto n = a * b + r;
+    EXPECT_EQ(n / b, a);
+    EXPECT_EQ(n % b, r);
+    EXPECT_EQ((-n) / b, -a);
+    EXPECT_EQ((-n) % b, -r);
+  }
+}
@@ -0,0 +1,93 @@
+#include <void/builtin.hpp>
+#include <void/arg_stack.hpp>
+#include <void/object.hpp>
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace Void;
+
+namespace {
+  thread_local std::size_t allocations = 0;
+}
+
+// sanitizers pair allocations with their own operator new, leave it alone
+#if !defined(__SANITIZE_ADDRESS__)
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (auto ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+#endif
+
+TEST(builtin, TestArity) {
+  auto& len = builtin_func_map.at("len");
+  auto& set = builtin_func_map.at("set");
+  EXPECT_EQ(len->arity(), 1);
+  EXPECT_EQ(set->arity(), 3);
+
+  std::vector<std::shared_ptr<Object>> args = {std::make_shared<String>("abc")};
+  EXPECT_EQ(len->run(args)->inspect(), "3");
+  args.push_back(null_obj);
+  EXPECT_EQ(len->run(args)->type(), Object::error_object_t);
+  EXPECT_EQ(set->run(args)->type(), Object::error_object_t);
+}
+
+TEST(builtin, TestNoAllocation) {
+#if defined(__SANITIZE_ADDRESS__)
+  GTEST_SKIP();
+#endif
+  auto arr = std::make_shared<Array>();
+  for (int i = 0; i < 100; ++i) {
+    arr->append(Integer::make(i));
+  }
+  auto& len = builtin_func_map.at("len");
+  auto& first = builtin_func_map.at("first");
+  auto& last = builtin_func_map.at("last");
+
+  ArgStack stack;
+  { ArgStack::Frame warmup(stack, 1); }
+
+  auto before = allocations;
+  for (int i = 0; i < 1000; ++i) {
+    ArgStack::Frame frame(stack, 1);
+    frame[0] = arr;
+    Args args(frame.data(), frame.size());
+    EXPECT_EQ(len->run(args)->cast<Integer>()->value(), 100);
+    EXPECT_EQ(first->run(args)->cast<Integer>()->value(), 0);
+    EXPECT_EQ(last->run(args)->cast<Integer>()->value(), 99);
+  }
+  EXPECT_EQ(allocations, before);
+}
+
+TEST(builtin, TestArgStack) {
+  ArgStack stack;
+  std::vector<ArgStack::Slot*> frames;
+  // frames stay in place while many more are pushed above them
+  for (std::size_t i = 1; i <= 300; ++i) {
+    auto slots = stack.push_frame(i % 7 == 0 ? 2000 : i % 5);
+    for (std::size_t j = 0; j < (i % 7 == 0 ? 2000 : i % 5); ++j) {
+      slots[j] = Integer::make(i);
+    }
+    frames.push_back(slots);
+  }
+  for (std::size_t i = 300; i >= 1; --i) {
+    auto size = i % 7 == 0 ? 2000 : i % 5;
+    if (size != 0) {
+      EXPECT_EQ(frames[i - 1][size - 1]->inspect(), std::to_string(i));
+    }
+    stack.pop_frame(size);
+  }
+}
@@ -0,0 +1,52 @@
+#include <void/evaluator.hpp>
+#include <void/counters.hpp>
+#include <gtest/gtest.h>
+#include <string>
+
+using namespace Void;
+
+TEST(counters, TestCounts) {
+  if (!stats_enabled) {
+    GTEST_SKIP() << "built without VOID_STATS";
+  }
+  Evaluator evaluator;
+  evaluator.eval(R"(
+    let down = fn(n) { if (n == 0) { 0 } else { down(n - 1) } };
+    down(3);
+    len("ab");
+  )");
+
+  auto counters = evaluator.stats().counters;
+  EXPECT_EQ(counters.function_calls, 4u);
+  EXPECT_EQ(counters.max_depth, 4u);
+  EXPECT_EQ(counters.depth, 0u);
+  EXPECT_EQ(counters.nodes[static_cast<std::size_t>(NodeKind::call_expression)], 5u);
+  EXPECT_EQ(counters.nodes[static_cast<std::size_t>(NodeKind::if_expression)], 4u);
+  EXPECT_EQ(counters.objects[Object::function_object_t], 1u);
+  EXPECT_EQ(counters.builtin_calls_by_name().at("len"), 1u);
+  // n in every call and every recursion, down per call, then len,
+  // which is not bound
+  EXPECT_EQ(counters.env_gets, 4u + 3u + 4u + 1u);
+  // down is one scope out in the calls that recurse
+  EXPECT_EQ(counters.env_hops, 3u);
+
+  auto json = counters.to_json();
+  EXPECT_NE(json.find("\"function_calls\": 4"), std::string::npos);
+  EXPECT_NE(json.find("\"builtin_calls\": {\"len\": 1}"), std::string::npos);
+}
+
+TEST(counters, TestBuiltin) {
+  Evaluator evaluator;
+  auto res = evaluator.eval("let f = fn() { 1 }; f(); f(); stats()");
+  if (!stats_enabled) {
+    EXPECT_EQ(res->type(), Object::error_object_t);
+    return;
+  }
+  ASSERT_EQ(res->type(), Object::hash_object_t);
+  auto hash = res->cast<Hash>();
+  String key("function_calls");
+  ASSERT_TRUE(hash->get(&key));
+  EXPECT_EQ(hash->get(&key)->inspect(), "2");
+  String builtins("builtin_calls");
+  EXPECT_EQ(hash->get(&builtins)->inspect(), "{stats: 1}");
+}
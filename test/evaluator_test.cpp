@@ -6,8 +6,277 @@
 #include <gtest/gtest.h>
 #include <any>
 #include <memory>
+#include <string>
+#include <string_view>
 
 using namespace Void;
 
+namespace {
+  std::int64_t score(std::int64_t base, std::string_view tag, bool boost) {
+    return base * static_cast<std::int64_t>(tag.size()) * (boost ? 2 : 1);
+  }
+
+  std::string greet(std::string name) {
+    return "hello, " + name;
+  }
+
+  std::int64_t total(IntArray::Values const& values) {
+    std::int64_t res = 0;
+    for (auto value : values) {
+      res += value;
+    }
+    return res;
+  }
+
+  int counter = 0;
+  void bump() {
+    ++counter;
+  }
+
+  std::shared_ptr<Object> count_args(Args args) {
+    return Integer::make(args.size());
+  }
+}
+
 TEST(evaluator, TestLiteral) {
 }
+
+TEST(evaluator, TestArrayBuiltin) {
+  Evaluator evaluator;
+
+  evaluator.eval("let a = [1, 2, 3]");
+  evaluator.eval("let b = push(a, 4)");
+  EXPECT_EQ(evaluator.eval("a")->inspect(), "[1, 2, 3]");
+  EXPECT_EQ(evaluator.eval("b")->inspect(), "[1, 2, 3, 4]");
+  EXPECT_EQ(evaluator.eval("pop(b)")->inspect(), "[1, 2, 3]");
+  EXPECT_EQ(evaluator.eval("a + b")->inspect(), "[1, 2, 3, 1, 2, 3, 4]");
+  EXPECT_EQ(evaluator.eval("len(a + b)")->inspect(), "7");
+  EXPECT_EQ(evaluator.eval("b[3]")->inspect(), "4");
+  EXPECT_EQ(evaluator.eval("b[4]")->inspect(), "null");
+  EXPECT_EQ(evaluator.eval("last(push(a, 9))")->inspect(), "9");
+}
+
+TEST(evaluator, TestHash) {
+  Evaluator evaluator;
+
+  evaluator.eval(R"(let h = {"a": 1, 2: "two", true: [3], [1, 2]: "pair"})");
+  EXPECT_EQ(evaluator.eval(R"(h["a"])")->inspect(), "1");
+  EXPECT_EQ(evaluator.eval("h[2]")->inspect(), "two");
+  EXPECT_EQ(evaluator.eval("h[1 + 1]")->inspect(), "two");
+  EXPECT_EQ(evaluator.eval("h[true]")->inspect(), "[3]");
+  EXPECT_EQ(evaluator.eval("h[[1, 2]]")->inspect(), "pair");
+  EXPECT_EQ(evaluator.eval(R"(h["b"])")->inspect(), "null");
+  EXPECT_EQ(evaluator.eval("len(h)")->inspect(), "4");
+  EXPECT_EQ(evaluator.eval("keys(h)")->inspect(), "[a, 2, true, [1, 2]]");
+  EXPECT_EQ(evaluator.eval("values(h)")->inspect(), "[1, two, [3], pair]");
+
+  evaluator.eval(R"(let g = set(h, "a", 10))");
+  EXPECT_EQ(evaluator.eval(R"(get(g, "a"))")->inspect(), "10");
+  EXPECT_EQ(evaluator.eval(R"(get(h, "a"))")->inspect(), "1");
+  EXPECT_EQ(evaluator.eval(R"(len(set(h, "c", 0)))")->inspect(), "5");
+  EXPECT_EQ(evaluator.eval(R"(get(h, "c"))")->inspect(), "null");
+  EXPECT_EQ(evaluator.eval("h[fn(){}]")->type(), Object::error_object_t);
+}
+
+TEST(evaluator, TestString) {
+  Evaluator evaluator;
+
+  evaluator.eval(R"(let s = "hello" + ", " + "world")");
+  EXPECT_EQ(evaluator.eval("s")->inspect(), "hello, world");
+  EXPECT_EQ(evaluator.eval("len(s)")->inspect(), "12");
+  EXPECT_EQ(evaluator.eval("substr(s, 7, 5)")->inspect(), "world");
+  EXPECT_EQ(evaluator.eval(R"(substr(s, 0, 5) == "hello")")->inspect(), "true");
+  EXPECT_EQ(evaluator.eval(R"(s < "help")")->inspect(), "true");
+  EXPECT_EQ(evaluator.eval("substr(s, -1, 5)")->type(), Object::error_object_t);
+}
+
+TEST(evaluator, TestStringInterning) {
+  Evaluator evaluator;
+
+  evaluator.eval(R"(let a = "tag"; let b = "tag"; let c = intern(substr("a tag", 2, 3)))");
+  auto a = evaluator.eval("a");
+  EXPECT_EQ(a.get(), evaluator.eval("b").get());
+  EXPECT_EQ(a.get(), evaluator.eval("c").get());
+  EXPECT_EQ(evaluator.eval("a == c")->inspect(), "true");
+  EXPECT_EQ(evaluator.eval(R"(a == "gat")")->inspect(), "false");
+  EXPECT_EQ(evaluator.eval(R"(if (a == "gat") { 1 } else { 2 })")->inspect(), "2");
+  EXPECT_EQ(evaluator.eval(R"(if (false) { 1 } else { 2 })")->inspect(), "2");
+}
+
+TEST(evaluator, TestInteger) {
+  Evaluator evaluator;
+
+  EXPECT_EQ(evaluator.eval("4294967296 * 4")->inspect(), "17179869184");
+  EXPECT_EQ(evaluator.eval("9223372036854775807 + 1")->inspect(), "9223372036854775808");
+  EXPECT_EQ(evaluator.eval("9223372036854775807 + 1")->type(), Object::big_integer_object_t);
+  EXPECT_EQ(evaluator.eval("9223372036854775807 + 1 - 1")->type(), Object::integer_object_t);
+  EXPECT_EQ(evaluator.eval("-9223372036854775807 - 1")->inspect(), "-9223372036854775808");
+  EXPECT_EQ(evaluator.eval("(-9223372036854775807 - 1) / -1")->inspect(), "9223372036854775808");
+  EXPECT_EQ(evaluator.eval("123456789012345678901234567890 * 10")->inspect(), "1234567890123456789012345678900");
+  EXPECT_EQ(evaluator.eval("100000000000000000000 > 99")->inspect(), "true");
+  EXPECT_EQ(evaluator.eval("if (1 > 2) { 1 } else { 2 }")->inspect(), "2");
+  EXPECT_EQ(evaluator.eval("1 / 0")->type(), Object::error_object_t);
+
+  evaluator.eval("let h = {100000000000000000000: 1}");
+  EXPECT_EQ(evaluator.eval("h[10000000000 * 10000000000]")->inspect(), "1");
+}
+
+TEST(evaluator, TestIntArray) {
+  Evaluator evaluator;
+
+  evaluator.eval("let a = int_array([1, 2, 3, 4, 5])");
+  evaluator.eval("let b = int_array([5, 4, 3, 2, 1])");
+  EXPECT_EQ(evaluator.eval("a")->type(), Object::int_array_object_t);
+  EXPECT_EQ(evaluator.eval("sum(a)")->inspect(), "15");
+  EXPECT_EQ(evaluator.eval("dot(a, b)")->inspect(), "35");
+  EXPECT_EQ(evaluator.eval("min(b)")->inspect(), "1");
+  EXPECT_EQ(evaluator.eval("max(b)")->inspect(), "5");
+  EXPECT_EQ(evaluator.eval("a + b")->inspect(), "[6, 6, 6, 6, 6]");
+  EXPECT_EQ(evaluator.eval("a * 2 - 1")->inspect(), "[1, 3, 5, 7, 9]");
+  EXPECT_EQ(evaluator.eval("10 - a")->inspect(), "[9, 8, 7, 6, 5]");
+  EXPECT_EQ(evaluator.eval("a[1] + len(a)")->inspect(), "7");
+  EXPECT_EQ(evaluator.eval("to_array(a) + [6]")->inspect(), "[1, 2, 3, 4, 5, 6]");
+  EXPECT_EQ(evaluator.eval("a == int_array(to_array(a))")->inspect(), "true");
+  EXPECT_EQ(evaluator.eval("a + int_array([1])")->type(), Object::error_object_t);
+  EXPECT_EQ(evaluator.eval("int_array([1, true])")->type(), Object::error_object_t);
+
+  // overflow promotes like scalar arithmetic does
+  evaluator.eval("let c = int_array([9223372036854775807, 1])");
+  EXPECT_EQ(evaluator.eval("sum(c)")->inspect(), "9223372036854775808");
+  EXPECT_EQ(evaluator.eval("c + 1")->inspect(), "[9223372036854775808, 2]");
+}
+
+TEST(evaluator, TestHostFunction) {
+  Evaluator evaluator;
+  evaluator.def("score", &score);
+  evaluator.def("greet", &greet);
+  evaluator.def("total", &total);
+  evaluator.def("bump", &bump);
+  evaluator.def("count_args", &count_args);
+
+  EXPECT_EQ(evaluator.eval(R"(score(7, "abc", true))")->inspect(), "42");
+  EXPECT_EQ(evaluator.eval(R"(greet("void"))")->inspect(), "hello, void");
+  EXPECT_EQ(evaluator.eval("total(int_array([1, 2, 3]))")->inspect(), "6");
+  EXPECT_EQ(evaluator.eval("bump(); bump()")->inspect(), "null");
+  EXPECT_EQ(counter, 2);
+  EXPECT_EQ(evaluator.eval("count_args(1, 2, 3)")->inspect(), "3");
+
+  EXPECT_EQ(evaluator.eval(R"(score("7", "abc", true))")->inspect(), "<error: argument 1: expected integer>");
+  EXPECT_EQ(evaluator.eval("score(7)")->type(), Object::error_object_t);
+
+  // registration is per evaluator
+  Evaluator other;
+  EXPECT_EQ(other.eval(R"(score(7, "abc", true))")->type(), Object::error_object_t);
+}
+
+TEST(evaluator, TestFunction) {
+  Evaluator evaluator;
+
+  EXPECT_EQ(evaluator.eval("let f = fn(x) { if (x > 1) { return 3; } 5 }; f(2)")->inspect(), "3");
+  EXPECT_EQ(evaluator.eval("f(0)")->inspect(), "5");
+  EXPECT_EQ(evaluator.eval("let fact = fn(n) { if (n < 2) { return 1; } n * fact(n - 1) }; fact(20)")->inspect(),
+	    "2432902008176640000");
+
+  // each call binds its parameters in a scope of its own
+  evaluator.eval("let mk = fn(n) { fn(x) { x + n } }; let add2 = mk(2); let add3 = mk(3)");
+  EXPECT_EQ(evaluator.eval("add2(10)")->inspect(), "12");
+  EXPECT_EQ(evaluator.eval("add3(10)")->inspect(), "13");
+  EXPECT_EQ(evaluator.eval("f(1, 2)")->inspect(), "<error: wrong number of arguments>");
+  // parameters bind in name order, the last of a repeated name wins
+  EXPECT_EQ(evaluator.eval("let g = fn(y, x, y) { x - y }; g(1, 5, 2)")->inspect(), "3");
+}
+
+TEST(evaluator, TestScript) {
+  Evaluator evaluator;
+
+  auto script = evaluator.compile("let n = 20; n * 2");
+  ASSERT_TRUE(script.ok());
+  EXPECT_EQ(script.run()->inspect(), "40");
+  EXPECT_EQ(script.run()->inspect(), "40");
+  EXPECT_EQ(evaluator.eval("n")->inspect(), "20");
+
+  auto bad = evaluator.compile("let = 1");
+  EXPECT_FALSE(bad.ok());
+  EXPECT_EQ(bad.run()->type(), Object::error_object_t);
+}
+
+TEST(evaluator, TestCallable) {
+  Evaluator evaluator;
+  evaluator.def("greet", &greet);
+  evaluator.eval(R"(let add = fn(x, y) { x + y }; let tag = fn(s) { s + "!" }; let n = 1)");
+
+  auto add = evaluator.lookup_function("add");
+  ASSERT_TRUE(add);
+  EXPECT_EQ(add.call(1, 2)->inspect(), "3");
+  EXPECT_EQ(add.call(std::int64_t{1} << 62, std::int64_t{1} << 62)->inspect(), "9223372036854775808");
+  EXPECT_EQ(add.call(1)->inspect(), "<error: wrong number of arguments>");
+  EXPECT_EQ(evaluator.lookup_function("tag").call("hi")->inspect(), "hi!");
+
+  // rebinding the name does not change a callable that was already resolved
+  evaluator.eval("let add = fn(x, y) { x * y }");
+  EXPECT_EQ(add.call(2, 5)->inspect(), "7");
+
+  EXPECT_EQ(evaluator.lookup_function("greet").call(std::string("void"))->inspect(), "hello, void");
+  EXPECT_EQ(evaluator.lookup_function("len").call("four")->inspect(), "4");
+  EXPECT_FALSE(evaluator.lookup_function("n"));
+  EXPECT_FALSE(evaluator.lookup_function("missing"));
+  EXPECT_EQ(Callable().call()->type(), Object::error_object_t);
+}
+
+TEST(evaluator, TestProgramLifetime) {
+  auto base = AstNode::stats();
+  {
+    Evaluator evaluator;
+    for (int i = 0; i < 100; ++i) {
+      evaluator.eval("let x = [1, 2, 3]; len(x) + 1");
+    }
+    EXPECT_EQ(evaluator.stats().ast.nodes, base.nodes);
+
+    // a function keeps the program that defined it until it is unbound
+    evaluator.eval("let f = fn(x) { x * 2 }");
+    auto held = evaluator.stats().ast;
+    EXPECT_GT(held.nodes, base.nodes);
+    EXPECT_GT(held.bytes, base.bytes);
+    EXPECT_EQ(evaluator.eval("f(21)")->inspect(), "42");
+    EXPECT_EQ(evaluator.stats().ast.nodes, held.nodes);
+
+    // a closure bound in a call's scope does not keep the program alive
+    // once the call returns
+    evaluator.eval("let f = fn() { let g = fn() { 1 }; g() }; f()");
+    auto once = evaluator.stats().ast;
+    for (int i = 0; i < 1000; ++i) {
+      evaluator.eval("let f = fn() { let g = fn() { 1 }; g() }; f()");
+    }
+    EXPECT_EQ(evaluator.stats().ast.nodes, once.nodes);
+    EXPECT_EQ(evaluator.stats().ast.bytes, once.bytes);
+    evaluator.eval("let f = fn(x) { x * 2 }");
+
+    auto script = evaluator.compile("f(1)");
+    EXPECT_GT(evaluator.stats().ast.nodes, held.nodes);
+    evaluator.eval("let f = 0");
+    EXPECT_EQ(script.run()->type(), Object::error_object_t);
+  }
+  EXPECT_EQ(AstNode::stats().nodes, base.nodes);
+  EXPECT_EQ(AstNode::stats().bytes, base.bytes);
+}
+
+TEST(evaluator, TestTiming) {
+  Evaluator evaluator;
+  EvalTiming timing;
+  // let, identifier, infix, two integer literals and the program
+  EXPECT_EQ(evaluator.eval("let x = 1 + 2;", timing)->type(), Object::null_object_t);
+  EXPECT_EQ(timing.tokens, 7u);
+  EXPECT_EQ(timing.nodes, 6u);
+  EXPECT_GT(timing.eval.count(), 0);
+  EXPECT_EQ(timing.print.count(), 0);
+  EXPECT_EQ(evaluator.eval("x * 2", timing)->inspect(), "6");
+  EXPECT_EQ(timing.tokens, 3u);
+
+  TimingHistograms histograms, total;
+  histograms.record(timing);
+  histograms.record(timing);
+  total.merge(histograms);
+  EXPECT_EQ(total.eval().count(), 2u);
+  EXPECT_EQ(total.tokens(), 6u);
+  EXPECT_NE(total.to_json().find("\"parse\": {\"count\": 2"), std::string::npos);
+}
@@ -0,0 +1,75 @@
+#include <void/gc.hpp>
+#include <void/histogram.hpp>
+#include <void/evaluator.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+
+using namespace Void;
+
+TEST(gc, TestHistogram) {
+  Histogram hist;
+  EXPECT_EQ(hist.percentile(50), 0u);
+
+  for (std::uint64_t i = 1; i <= 1000; ++i) {
+    hist.record(i);
+  }
+
+  EXPECT_EQ(hist.count(), 1000u);
+  EXPECT_EQ(hist.min(), 1u);
+  EXPECT_EQ(hist.max(), 1000u);
+  EXPECT_EQ(hist.sum(), 500500u);
+
+  // buckets are 12.5% wide
+  EXPECT_NEAR(static_cast<double>(hist.percentile(50)), 500.0, 500.0 * 0.125);
+  EXPECT_NEAR(static_cast<double>(hist.percentile(99)), 990.0, 990.0 * 0.125);
+  EXPECT_EQ(hist.percentile(100), 1000u);
+
+  Histogram other;
+  other.record(5000);
+  hist.merge(other);
+  EXPECT_EQ(hist.count(), 1001u);
+  EXPECT_EQ(hist.max(), 5000u);
+}
+
+TEST(gc, TestImmediateMode) {
+  Evaluator evaluator;
+  evaluator.eval("let a = [[1, 2], [3, 4]]");
+  auto before = evaluator.stats().gc;
+  evaluator.eval("let a = 0");
+  auto after = evaluator.stats().gc;
+  EXPECT_EQ(after.pending, 0u);
+  EXPECT_EQ(after.slices, before.slices);
+}
+
+TEST(gc, TestIncrementalMode) {
+  std::string input = "let a = [";
+  for (int i = 0; i < 1000; ++i) {
+    input += "[" + std::to_string(i) + "], ";
+  }
+  input += "0]";
+
+  Evaluator evaluator;
+  evaluator.set_gc_mode(Collector::incremental_mode);
+  evaluator.set_gc_pause_budget(std::chrono::microseconds(0));
+
+  evaluator.eval(input);
+  auto before = evaluator.stats().gc;
+
+  // every slice overruns a zero budget after its first batch
+  evaluator.eval("let a = 0");
+  auto mid = evaluator.stats().gc;
+  EXPECT_GT(mid.slices, before.slices);
+  EXPECT_GT(mid.pending, 0u);
+  EXPECT_EQ(mid.collections, before.collections);
+
+  evaluator.collect_garbage();
+  auto after = evaluator.stats().gc;
+  EXPECT_EQ(after.pending, 0u);
+  EXPECT_EQ(after.collections, before.collections + 1);
+  EXPECT_GE(after.reclaimed - before.reclaimed, 2001u);
+  EXPECT_EQ(after.pause_ns.count(), after.slices);
+  EXPECT_LE(after.pause_ns.percentile(50), after.pause_ns.max());
+
+  evaluator.set_gc_mode(Collector::immediate_mode);
+}
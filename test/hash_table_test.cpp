@@ -0,0 +1,64 @@
+#include <void/hash_table.hpp>
+#include <void/object.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+using namespace Void;
+
+TEST(HashTable, TestInsertAndFind) {
+  HashTable table;
+  for (int i = 0; i < 10000; ++i) {
+    auto key = std::make_shared<Integer>(i);
+    table.insert(key, std::make_shared<Integer>(i * 2), HashTable::hash(key.get()));
+  }
+  ASSERT_EQ(table.size(), 10000u);
+
+  for (int i = 0; i < 10000; ++i) {
+    Integer key(i);
+    auto entry = table.find(&key, HashTable::hash(&key));
+    ASSERT_TRUE(entry != nullptr);
+    EXPECT_EQ(entry->value->cast<Integer>()->value(), i * 2);
+  }
+
+  Integer missing(10000);
+  EXPECT_TRUE(table.find(&missing, HashTable::hash(&missing)) == nullptr);
+
+  // insertion order is kept
+  int expect = 0;
+  for (auto& entry : table.entries()) {
+    EXPECT_EQ(entry.key->cast<Integer>()->value(), expect++);
+  }
+}
+
+TEST(HashTable, TestOverwriteAndStructuralKeys) {
+  HashTable table;
+  auto key1 = std::make_shared<String>("key");
+  auto key2 = std::make_shared<String>("key");
+  table.insert(key1, std::make_shared<Integer>(1), HashTable::hash(key1.get()));
+  table.insert(key2, std::make_shared<Integer>(2), HashTable::hash(key2.get()));
+  ASSERT_EQ(table.size(), 1u);
+  EXPECT_EQ(table.entries()[0].value->cast<Integer>()->value(), 2);
+
+  // equal values of different types are different keys
+  auto str_one = std::make_shared<String>("1");
+  auto int_one = std::make_shared<Integer>(1);
+  EXPECT_FALSE(HashTable::equal(str_one.get(), int_one.get()));
+  EXPECT_FALSE(HashTable::hashable(std::make_shared<Hash>().get()));
+}
+
+TEST(HashTable, TestCollidingHashes) {
+  // every key lands in the same group, probing has to walk past it
+  HashTable table;
+  for (int i = 0; i < 100; ++i) {
+    auto key = std::make_shared<String>(std::to_string(i));
+    table.insert(key, std::make_shared<Integer>(i), 42);
+  }
+  ASSERT_EQ(table.size(), 100u);
+  for (int i = 0; i < 100; ++i) {
+    String key(std::to_string(i));
+    auto entry = table.find(&key, 42);
+    ASSERT_TRUE(entry != nullptr);
+    EXPECT_EQ(entry->value->cast<Integer>()->value(), i);
+  }
+}
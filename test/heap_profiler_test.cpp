@@ -0,0 +1,94 @@
+#include <void/evaluator.hpp>
+#include <void/heap_profiler.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+using namespace Void;
+
+namespace {
+  heap_profiler::Entry const* find(std::vector<heap_profiler::Entry> const& entries, std::string const& name) {
+    auto it = std::find_if(entries.begin(), entries.end(), [&](auto& entry) { return entry.name == name; });
+    return it == entries.end() ? nullptr : &*it;
+  }
+}
+
+TEST(heap_profiler, TestSites) {
+  heap_profiler::start();
+  {
+    Evaluator evaluator;
+    evaluator.eval(R"(
+      let grow = fn(arr, n) {
+        if (n == 0) { return arr; }
+        grow(push(arr, [n]), n - 1)
+      };
+      let kept = grow([], 100);
+    )");
+
+    auto res = heap_profiler::report();
+    // every [n] kept in the result was made on line 4
+    auto site = find(res.sites, "array_literal at line 4 in grow");
+    ASSERT_TRUE(site);
+    EXPECT_EQ(site->objects, 100u);
+    auto arrays = find(res.types, "array");
+    ASSERT_TRUE(arrays);
+    EXPECT_GE(arrays->objects, 101u);
+
+    std::ostringstream report;
+    heap_profiler::write_report(report, 1);
+    EXPECT_EQ(report.str().rfind("heap profile: ", 0), 0u);
+    EXPECT_NE(report.str().find("more sites"), std::string::npos);
+
+    auto text = evaluator.eval("heap_profile()");
+    ASSERT_EQ(text->type(), Object::string_object_t);
+  }
+  // the evaluator and all it made is gone
+  auto res = heap_profiler::report();
+  EXPECT_FALSE(find(res.sites, "array_literal at line 4 in grow"));
+  heap_profiler::stop();
+
+  Evaluator evaluator;
+  EXPECT_EQ(evaluator.eval("heap_profile()")->type(), Object::error_object_t);
+}
+
+TEST(heap_profiler, TestSameSource) {
+  heap_profiler::start();
+  Evaluator evaluator;
+  // each eval parses a new program, its nodes share the first one's sites
+  EXPECT_EQ(evaluator.eval("let a = [1];")->inspect(), "null");
+  auto known = heap_profiler::report().known_sites;
+  EXPECT_EQ(evaluator.eval("let a = [1];")->inspect(), "null");
+  auto res = heap_profiler::report();
+  EXPECT_EQ(res.known_sites, known);
+  auto site = find(res.sites, "array_literal at line 1 in [main]");
+  heap_profiler::stop();
+  ASSERT_TRUE(site);
+  EXPECT_EQ(site->objects, 1u);
+}
+
+TEST(heap_profiler, TestCallScopes) {
+  Evaluator evaluator;
+  evaluator.eval(R"(
+    let f = fn() { let g = fn() { 1 }; g() };
+    let keep = fn() { let h = fn() { 2 }; h };
+  )");
+  heap_profiler::start();
+  auto live_functions = [] {
+    auto report = heap_profiler::report();
+    auto functions = find(report.types, "function");
+    return functions ? functions->objects : 0;
+  };
+
+  // each call's scope and the closure bound in it hold each other, the
+  // call breaks that when the closure does not escape
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(evaluator.eval("f()")->inspect(), "1");
+  }
+  EXPECT_EQ(live_functions(), 0u);
+
+  // one that escapes keeps its scope
+  EXPECT_EQ(evaluator.eval("let h = keep(); h()")->inspect(), "2");
+  EXPECT_EQ(live_functions(), 1u);
+  heap_profiler::stop();
+}
@@ -173,3 +173,20 @@ let foo = fn (v1) {
   }
 }
 
+TEST(Lexer, TestLine) {
+  std::string input = "let a = 1;\r\n\nlet f = fn(x) {\n  \"a\nb\" + x\n} ?";
+
+  Lexer lexer(input);
+
+  std::vector<std::pair<std::string, int>> expect = {
+    {"let", 1}, {"a", 1}, {"=", 1}, {"1", 1}, {";", 1},
+    {"let", 3}, {"f", 3}, {"=", 3}, {"fn", 3}, {"(", 3}, {"x", 3}, {")", 3}, {"{", 3},
+    {"a\nb", 4}, {"+", 5}, {"x", 5}, {"}", 6}, {"?", 6},
+  };
+  for (auto& [literal, line] : expect) {
+    auto token = lexer.read_token();
+    EXPECT_EQ(token.literal, literal);
+    EXPECT_EQ(token.line, line);
+  }
+  EXPECT_EQ(lexer.read_token().type, Token::eof_t);
+}
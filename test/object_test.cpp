@@ -0,0 +1,99 @@
+#include <void/object.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+using namespace Void;
+
+TEST(object, TestSmallString) {
+  auto str = std::make_shared<String>("hello");
+  EXPECT_EQ(str->size(), 5u);
+  EXPECT_EQ(str->value(), "hello");
+  EXPECT_EQ(str->inspect(), "hello");
+
+  auto res = String::concat(str, std::make_shared<String>(", world"));
+  EXPECT_EQ(res->value(), "hello, world");
+  EXPECT_EQ(str->value(), "hello");
+}
+
+TEST(object, TestStringAppend) {
+  auto piece = std::make_shared<String>("0123456789");
+  auto str = std::make_shared<String>("");
+  std::string expect;
+  std::vector<std::shared_ptr<String>> versions;
+  for (int i = 0; i < 20000; ++i) {
+    str = String::concat(str, piece);
+    expect += "0123456789";
+    if (i % 1000 == 0) {
+      versions.push_back(str);
+    }
+  }
+  EXPECT_EQ(str->size(), expect.size());
+  EXPECT_EQ(str->value(), expect);
+
+  // earlier versions do not see the later appends
+  for (std::size_t i = 0; i < versions.size(); ++i) {
+    EXPECT_EQ(versions[i]->size(), (i * 1000 + 1) * 10);
+    EXPECT_EQ(versions[i]->value(), expect.substr(0, versions[i]->size()));
+  }
+
+  // both branch off the same prefix
+  auto left = String::concat(versions[3], std::make_shared<String>("left"));
+  auto right = String::concat(versions[3], std::make_shared<String>("right"));
+  EXPECT_EQ(left->value().substr(left->size() - 4), "left");
+  EXPECT_EQ(right->value().substr(right->size() - 5), "right");
+}
+
+TEST(object, TestStringRope) {
+  auto tail = std::make_shared<String>(std::string(300, 'x'));
+  auto str = std::make_shared<String>("");
+  std::string expect;
+  for (int i = 0; i < 200; ++i) {
+    auto head = std::make_shared<String>(std::to_string(i) + std::string(300, '-'));
+    str = String::concat(head, String::concat(str, tail));
+    expect = std::to_string(i) + std::string(300, '-') + expect + std::string(300, 'x');
+  }
+  EXPECT_EQ(str->size(), expect.size());
+  EXPECT_EQ(str->value(), expect);
+  EXPECT_EQ(str->hash(), std::make_shared<String>(expect)->hash());
+}
+
+TEST(object, TestSubstr) {
+  auto str = std::make_shared<String>("the quick brown fox jumps over the lazy dog");
+  EXPECT_EQ(str->substr(4, 5)->value(), "quick");
+  EXPECT_EQ(str->substr(4, 100)->value(), "quick brown fox jumps over the lazy dog");
+  EXPECT_EQ(str->substr(100, 5)->value(), "");
+
+  auto sub = str->substr(0, 19);
+  EXPECT_EQ(sub->value(), "the quick brown fox");
+  EXPECT_EQ(String::concat(sub, std::make_shared<String>("!"))->value(), "the quick brown fox!");
+  EXPECT_EQ(str->value(), "the quick brown fox jumps over the lazy dog");
+}
+
+TEST(object, TestIntern) {
+  auto first = String::intern("tag");
+  auto second = String::intern(std::make_shared<String>("tag"));
+  EXPECT_TRUE(first->interned());
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, String::intern("other"));
+
+  auto long_str = std::string(100, 'x');
+  auto built = String::concat(std::make_shared<String>(std::string(50, 'x')),
+			      std::make_shared<String>(std::string(50, 'x')));
+  EXPECT_EQ(String::intern(long_str), String::intern(built));
+
+  // shared across threads, nothing appends into an interned string's
+  // buffer, neither it nor a slice of it
+  auto shared = String::intern(String::concat(std::make_shared<String>(std::string(40, 'y')),
+					      std::make_shared<String>("y")));
+  auto data = shared->value().data();
+  auto suffix = std::make_shared<String>("!");
+  EXPECT_NE(String::concat(shared, suffix)->value().data(), data);
+  EXPECT_NE(String::concat(shared->substr(21, 20), suffix)->value().data(), data + 21);
+  EXPECT_EQ(shared->value(), std::string(41, 'y'));
+
+  // the table does not keep strings alive
+  std::weak_ptr<String> weak = String::intern("short lived tag");
+  EXPECT_TRUE(weak.expired());
+  EXPECT_EQ(String::intern("short lived tag")->value(), "short lived tag");
+}
@@ -506,6 +506,39 @@ fn(){return [1, 2, 3, 4];}[0];
   }
 }
 
+TEST(parser, TestTrivialHashLiteral) {
+  std::string input = R"(
+{};
+{"a": 1, "b": 2 + 3};
+{1: [1], true: {"x": fn () {}}};
+)";
+
+  Parser parser(input);
+  
+  auto program = parser.parse();
+  ASSERT_TRUE(program != nullptr);
+  EXPECT_TRUE(parser.error().empty());
+  
+  auto& stmts = program->statements();
+  ASSERT_EQ(static_cast<std::size_t>(3), stmts.size());
+
+  std::vector<std::string> expects = {
+    {"{}"},
+    {"{\"a\": 1, \"b\": (2 + 3)}"},
+    {"{1: [1], true: {\"x\": fn () {}}}"},
+  };
+
+  for (int i = 0; i < 3; ++i) { 
+    auto str_expect = expects[i];
+    auto stmt = dynamic_cast<ExpressionStatement*>(const_cast<Statement*>(stmts[i].get()));
+    ASSERT_TRUE(stmt != nullptr);
+    auto expr = dynamic_cast<HashLiteral*>(stmt->expression());
+    ASSERT_TRUE(expr != nullptr); 
+    auto str = expr->to_string(); 
+    EXPECT_EQ(str_expect, str);
+  }
+}
+
 TEST(parser, TestLetStatementError) {
   std::string input = R"(
 let 1 = 1;
@@ -0,0 +1,58 @@
+#include <void/evaluator.hpp>
+#include <void/perf_counters.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <sstream>
+#include <thread>
+
+using namespace Void;
+
+namespace {
+  std::uint64_t calls_of(std::vector<perf_counters::Entry> const& entries, std::string const& name) {
+    auto it = std::find_if(entries.begin(), entries.end(), [&](auto const& entry) { return entry.name == name; });
+    return it == entries.end() ? 0 : it->calls;
+  }
+
+  constexpr char const* source = R"(
+    let down = fn(n) { if (n == 0) { 0 } else { down(n - 1) } };
+    let f = fn() { len("ab") };
+  )";
+}
+
+TEST(perf_counters, TestCalls) {
+  if (!perf_counters::start()) {
+    GTEST_SKIP() << "perf_event_open is not available";
+  }
+  EXPECT_FALSE(perf_counters::start());
+  Evaluator evaluator;
+  evaluator.eval(source);
+  evaluator.eval("down(3); f(); f()");
+  std::thread([] {
+    Evaluator other;
+    other.eval(source);
+    other.eval("down(1)");
+  }).join();
+  perf_counters::stop();
+  evaluator.eval("down(3)");
+
+  auto entries = perf_counters::report();
+  EXPECT_EQ(calls_of(entries, "down"), 4u + 2u);
+  EXPECT_EQ(calls_of(entries, "f"), 2u);
+  // builtins are charged to the function calling them
+  EXPECT_EQ(calls_of(entries, "len"), 0u);
+
+  auto available = perf_counters::available();
+  for (auto& entry : entries) {
+    for (std::size_t i = 0; i < perf_counters::event_count; ++i) {
+      if (!available[i]) {
+	EXPECT_EQ(entry.values[i], 0u);
+      }
+    }
+  }
+  std::ostringstream os;
+  perf_counters::write_report(os);
+  EXPECT_NE(os.str().find("  down\n"), std::string::npos);
+
+  perf_counters::reset();
+  EXPECT_EQ(calls_of(perf_counters::report(), "down"), 0u);
+}
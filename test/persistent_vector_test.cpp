@@ -0,0 +1,86 @@
+#include <void/persistent_vector.hpp>
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <vector>
+
+using namespace Void;
+
+TEST(PersistentVector, TestPushAndIndex) {
+  PersistentVector<int> vec;
+  std::vector<PersistentVector<int>> versions;
+  for (int i = 0; i < 5000; ++i) {
+    versions.push_back(vec);
+    vec = vec.push_back(i);
+  }
+
+  ASSERT_EQ(vec.size(), 5000u);
+  for (int i = 0; i < 5000; ++i) {
+    EXPECT_EQ(vec[i], i);
+  }
+
+  // old versions are untouched
+  for (std::size_t n = 0; n < versions.size(); n += 97) {
+    ASSERT_EQ(versions[n].size(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+      EXPECT_EQ(versions[n][i], static_cast<int>(i));
+    }
+  }
+}
+
+TEST(PersistentVector, TestBranching) {
+  PersistentVector<int> base;
+  for (int i = 0; i < 40; ++i) {
+    base.append(i);
+  }
+
+  // both claim slot 40 of the same tail
+  auto left = base.push_back(100);
+  auto right = base.push_back(200);
+  EXPECT_EQ(left.size(), 41u);
+  EXPECT_EQ(right.size(), 41u);
+  EXPECT_EQ(left.back(), 100);
+  EXPECT_EQ(right.back(), 200);
+  EXPECT_EQ(base.size(), 40u);
+
+  auto popped = left.pop_back().push_back(300);
+  EXPECT_EQ(popped.back(), 300);
+  EXPECT_EQ(left.back(), 100);
+}
+
+TEST(PersistentVector, TestPop) {
+  PersistentVector<int> vec;
+  for (int i = 0; i < 3000; ++i) {
+    vec.append(i);
+  }
+
+  auto cur = vec;
+  for (int n = 3000; n > 0; --n) {
+    ASSERT_EQ(cur.size(), static_cast<std::size_t>(n));
+    ASSERT_EQ(cur.back(), n - 1);
+    ASSERT_EQ(cur.front(), 0);
+    cur = cur.pop_back();
+  }
+  EXPECT_TRUE(cur.empty());
+  EXPECT_EQ(vec.size(), 3000u);
+  EXPECT_EQ(vec[1234], 1234);
+}
+
+TEST(PersistentVector, TestConcatAndIterate) {
+  PersistentVector<int> left, right;
+  for (int i = 0; i < 70; ++i) {
+    left.append(i);
+  }
+  for (int i = 70; i < 1100; ++i) {
+    right.append(i);
+  }
+
+  auto vec = left.concat(right);
+  ASSERT_EQ(vec.size(), 1100u);
+
+  int expect = 0;
+  for (auto& value : vec) {
+    EXPECT_EQ(value, expect++);
+  }
+  EXPECT_EQ(expect, 1100);
+  EXPECT_EQ(left.size(), 70u);
+}
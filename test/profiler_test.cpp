@@ -0,0 +1,59 @@
+#include <void/evaluator.hpp>
+#include <void/profiler.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+using namespace Void;
+
+TEST(profiler, TestCallStack) {
+  CallStack stack;
+  EXPECT_EQ(stack.depth(), 0u);
+  {
+    CallStack::Scope main(stack, nullptr, 1);
+    stack.set_line(4);
+    {
+      CallStack::Scope inner(stack, nullptr, 7);
+      EXPECT_EQ(stack.depth(), 2u);
+      EXPECT_EQ(stack.frames()[1].line, 7);
+    }
+    EXPECT_EQ(stack.frames()[0].line, 4);
+  }
+  EXPECT_EQ(stack.depth(), 0u);
+}
+
+TEST(profiler, TestSamples) {
+  Evaluator evaluator;
+  evaluator.eval(R"(
+    let fib = fn(n) {
+      if (n < 2) { return n; }
+      fib(n - 1) + fib(n - 2)
+    };
+    let run = fn() { fib(18) };
+  )");
+
+  ASSERT_TRUE(profiler::start(std::chrono::microseconds(200)));
+  EXPECT_FALSE(profiler::start());
+  for (int i = 0; i < 1000 && profiler::summary().samples < 50; ++i) {
+    evaluator.eval("run()");
+  }
+  // rebinding frees the function, samples still name it
+  evaluator.eval("let fib = 0; let run = 0");
+  profiler::stop();
+  EXPECT_FALSE(profiler::active());
+  ASSERT_GE(profiler::summary().samples, 50u);
+
+  std::ostringstream folded;
+  profiler::write_folded(folded);
+  EXPECT_NE(folded.str().find("[main]:1;run:6;fib:"), std::string::npos) << folded.str();
+  EXPECT_NE(folded.str().find(";fib:4;fib:"), std::string::npos) << folded.str();
+
+  std::ostringstream pprof;
+  profiler::write_pprof(pprof);
+  ASSERT_FALSE(pprof.str().empty());
+  EXPECT_EQ(pprof.str()[0], '\x0a'); // sample_type, field 1 length delimited
+  EXPECT_NE(pprof.str().find("fib"), std::string::npos);
+
+  profiler::reset();
+  EXPECT_EQ(profiler::summary().samples, 0u);
+}
@@ -0,0 +1,94 @@
+#include <void/simd.hpp>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace Void;
+
+namespace {
+  std::vector<simd::Isa> isas() {
+    std::vector<simd::Isa> res = {simd::Isa::scalar};
+    if (simd::best_isa() == simd::Isa::avx2) {
+      res.push_back(simd::Isa::avx2);
+    }
+    return res;
+  }
+
+  std::vector<std::int64_t> random_values(std::mt19937_64& rng, std::size_t n, std::int64_t bound) {
+    std::vector<std::int64_t> res(n);
+    for (auto& value : res) {
+      value = static_cast<std::int64_t>(rng() % (2 * bound + 1)) - bound;
+    }
+    return res;
+  }
+}
+
+TEST(simd, TestReductions) {
+  std::mt19937_64 rng(7);
+  for (auto isa : isas()) {
+    simd::set_isa(isa);
+    for (std::size_t n : {1, 3, 4, 7, 64, 1001}) {
+      // mix small values and values too wide for the 32 bit multiply
+      auto a = random_values(rng, n, 1000);
+      auto b = random_values(rng, n, std::int64_t{1} << 40);
+      std::int64_t sum = 0, dot = 0, lo = a[0], hi = a[0];
+      for (std::size_t i = 0; i < n; ++i) {
+	sum += a[i];
+	dot += a[i] * b[i];
+	lo = std::min(lo, a[i]);
+	hi = std::max(hi, a[i]);
+      }
+
+      std::int64_t res;
+      ASSERT_TRUE(simd::sum(a.data(), n, res));
+      EXPECT_EQ(res, sum);
+      ASSERT_TRUE(simd::dot(a.data(), b.data(), n, res));
+      EXPECT_EQ(res, dot);
+      EXPECT_EQ(simd::min(a.data(), n), lo);
+      EXPECT_EQ(simd::max(a.data(), n), hi);
+    }
+  }
+  simd::set_isa(simd::best_isa());
+}
+
+TEST(simd, TestElementwise) {
+  std::mt19937_64 rng(11);
+  for (auto isa : isas()) {
+    simd::set_isa(isa);
+    for (std::size_t n : {0, 5, 8, 99}) {
+      auto a = random_values(rng, n, std::int64_t{1} << 40);
+      auto b = random_values(rng, n, 1 << 20);
+      std::vector<std::int64_t> out(n);
+
+      ASSERT_TRUE(simd::add(a.data(), b.data(), out.data(), n));
+      for (std::size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] + b[i]);
+      ASSERT_TRUE(simd::sub(a.data(), b.data(), out.data(), n));
+      for (std::size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] - b[i]);
+      ASSERT_TRUE(simd::mul(a.data(), b.data(), out.data(), n));
+      for (std::size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], a[i] * b[i]);
+      ASSERT_TRUE(simd::rsub_scalar(b.data(), 3, out.data(), n));
+      for (std::size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], 3 - b[i]);
+      ASSERT_TRUE(simd::mul_scalar(b.data(), -5, out.data(), n));
+      for (std::size_t i = 0; i < n; ++i) EXPECT_EQ(out[i], b[i] * -5);
+    }
+  }
+  simd::set_isa(simd::best_isa());
+}
+
+TEST(simd, TestOverflow) {
+  for (auto isa : isas()) {
+    simd::set_isa(isa);
+    std::vector<std::int64_t> a(13, 1), out(13);
+    a[9] = INT64_MAX;
+
+    std::int64_t res;
+    EXPECT_FALSE(simd::sum(a.data(), a.size(), res));
+    EXPECT_FALSE(simd::add_scalar(a.data(), 1, out.data(), a.size()));
+    EXPECT_FALSE(simd::mul_scalar(a.data(), 2, out.data(), a.size()));
+    EXPECT_FALSE(simd::sub_scalar(a.data(), -1, out.data(), a.size()));
+    EXPECT_FALSE(simd::dot(a.data(), a.data(), a.size(), res));
+    EXPECT_TRUE(simd::add_scalar(a.data(), -1, out.data(), a.size()));
+  }
+  simd::set_isa(simd::best_isa());
+}
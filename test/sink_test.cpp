@@ -0,0 +1,75 @@
+#include <void/sink.hpp>
+#include <void/object.hpp>
+#include <void/evaluator.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace Void;
+
+TEST(sink, TestBuffering) {
+  std::ostringstream os;
+  {
+    StreamSink sink(os);
+    sink.write("abc");
+    sink.put(',');
+    sink.write_int(-42);
+    EXPECT_EQ(os.str(), "");
+    sink.write(std::string(10000, 'x'));
+    EXPECT_EQ(os.str().size(), 10007u);
+    sink.put('!');
+  }
+  EXPECT_EQ(os.str().substr(0, 7), "abc,-42");
+  EXPECT_EQ(os.str().size(), 10008u);
+}
+
+TEST(sink, TestSizeLimit) {
+  StringSink sink(PrintLimits{16, 8});
+  sink.write("0123");
+  EXPECT_FALSE(sink.full());
+  sink.write("456789");
+  sink.write("ignored");
+  EXPECT_TRUE(sink.full());
+  EXPECT_TRUE(sink.truncated());
+  EXPECT_EQ(sink.str(), "01234567...");
+
+  // a line end still makes it past the limit
+  sink.put('\n');
+  sink.finish("\n");
+  EXPECT_EQ(sink.str(), "01234567...\n");
+}
+
+TEST(sink, TestObjects) {
+  Evaluator evaluator;
+
+  auto obj = evaluator.eval(R"([1, "two", [true, {"k": [3]}], int_array([4, 5])])");
+  EXPECT_EQ(obj->inspect(), "[1, two, [true, {k: [3]}], [4, 5]]");
+
+  StringSink shallow(PrintLimits{2});
+  obj->write_to(shallow);
+  EXPECT_EQ(shallow.str(), "[1, two, [true, ...], [4, 5]]");
+  EXPECT_TRUE(shallow.truncated());
+  EXPECT_FALSE(shallow.full());
+
+  StringSink small(PrintLimits{16, 12});
+  obj->write_to(small);
+  EXPECT_EQ(small.str(), "[1, two, [tr...");
+}
+
+TEST(sink, TestLargeArray) {
+  auto arr = std::make_shared<Array>();
+  for (int i = 0; i < 1000000; ++i) {
+    arr->append(std::make_shared<Integer>(i));
+  }
+
+  StringSink sink(display_limits);
+  arr->write_to(sink);
+  EXPECT_TRUE(sink.full());
+  EXPECT_EQ(sink.str().size(), display_limits.max_size + 3);
+  EXPECT_EQ(sink.str().substr(0, 10), "[0, 1, 2, ");
+
+  StringSink unlimited;
+  arr->write_to(unlimited);
+  EXPECT_EQ(unlimited.str().size(), 7888890u);
+}
@@ -0,0 +1,105 @@
+#include <void/evaluator.hpp>
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+
+using namespace Void;
+
+namespace {
+  std::int64_t twice(std::int64_t x) {
+    return x * 2;
+  }
+}
+
+TEST(snapshot, TestRoundTrip) {
+  std::string image;
+  {
+    Evaluator evaluator;
+    evaluator.eval(R"(
+      let n = 42;
+      let big = 100000000000000000000;
+      let s = intern("name");
+      let t = "text";
+      let a = [1, [2, "x"], true, null];
+      let h = {"k": a, 1: false};
+      let v = int_array([1, 2, 3]);
+      let size = len;
+      let mk = fn(k) { fn(x) { x + k } };
+      let add5 = mk(5);
+      let fact = fn(n) { if (n < 2) { return 1; } n * fact(n - 1) };
+    )");
+    image = evaluator.snapshot();
+  }
+
+  Evaluator evaluator;
+  ASSERT_EQ(evaluator.restore(image)->type(), Object::null_object_t);
+  // a snapshot of a restored evaluator is the same image; small Integers
+  // come back shared, so compare from the first restore on
+  auto restored = evaluator.snapshot();
+  Evaluator again;
+  ASSERT_EQ(again.restore(restored)->type(), Object::null_object_t);
+  EXPECT_EQ(again.snapshot(), restored);
+  EXPECT_EQ(evaluator.eval("n")->inspect(), "42");
+  EXPECT_EQ(evaluator.eval("big + 1")->inspect(), "100000000000000000001");
+  EXPECT_EQ(evaluator.eval(R"(s == intern("name"))")->inspect(), "true");
+  EXPECT_EQ(evaluator.eval("t + a[1][1]")->inspect(), "textx");
+  EXPECT_EQ(evaluator.eval(R"(h["k"][0] + len(a))")->inspect(), "5");
+  EXPECT_EQ(evaluator.eval("h[1]")->inspect(), "false");
+  EXPECT_EQ(evaluator.eval("sum(v)")->inspect(), "6");
+  EXPECT_EQ(evaluator.eval("size(t)")->inspect(), "4");
+  EXPECT_EQ(evaluator.eval("add5(10)")->inspect(), "15");
+  EXPECT_EQ(evaluator.eval("mk(1)(1)")->inspect(), "2");
+  EXPECT_EQ(evaluator.eval("fact(10)")->inspect(), "3628800");
+
+  // the restored scope is live, functions see later bindings
+  evaluator.eval("let fact = fn(n) { 0 }");
+  EXPECT_EQ(evaluator.eval("fact(3)")->inspect(), "0");
+}
+
+TEST(snapshot, TestHostFunctions) {
+  std::string image;
+  {
+    Evaluator evaluator;
+    evaluator.def("twice", &twice);
+    evaluator.eval("let f = twice");
+    image = evaluator.snapshot();
+  }
+
+  Evaluator missing;
+  EXPECT_EQ(missing.restore(image)->inspect(), "<error: snapshot needs host function twice>");
+
+  Evaluator evaluator;
+  evaluator.def("twice", &twice);
+  ASSERT_EQ(evaluator.restore(image)->type(), Object::null_object_t);
+  EXPECT_EQ(evaluator.eval("f(21)")->inspect(), "42");
+}
+
+TEST(snapshot, TestCorrupt) {
+  Evaluator source;
+  source.eval("let a = [1, 2, 3]; let f = fn(x) { a[x] }");
+  auto image = source.snapshot();
+
+  Evaluator evaluator;
+  EXPECT_EQ(evaluator.restore("garbage")->type(), Object::error_object_t);
+  for (std::size_t size = 0; size < image.size(); ++size) {
+    EXPECT_EQ(evaluator.restore(image.substr(0, size))->type(), Object::error_object_t);
+  }
+  for (std::size_t i = 12; i < image.size(); ++i) {
+    auto bad = image;
+    bad[i] = static_cast<char>(bad[i] ^ 0x5a);
+    evaluator.restore(bad); // must not crash, the result may be either
+  }
+
+  // one scope that is its own outer: version 1, no programs, one scope,
+  // no objects, the scope with outer 0 + 1 and no bindings, root 0
+  std::string loop("VOIDSNAP");
+  for (std::uint32_t word : {1u, 0u, 1u, 0u, 1u, 0u, 0u}) {
+    for (int i = 0; i < 4; ++i) {
+      loop.push_back(static_cast<char>(word >> (8 * i)));
+    }
+  }
+  EXPECT_EQ(evaluator.restore(loop)->type(), Object::error_object_t);
+  // and did not hang looking the name up
+  EXPECT_EQ(evaluator.eval("unbound")->type(), Object::null_object_t);
+  EXPECT_EQ(evaluator.eval("1 + 1")->inspect(), "2");
+}
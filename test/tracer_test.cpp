@@ -0,0 +1,69 @@
+#include <void/evaluator.hpp>
+#include <void/tracer.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace Void;
+
+namespace {
+  std::size_t count(std::string const& text, std::string const& part) {
+    std::size_t res = 0;
+    for (auto pos = text.find(part); pos != std::string::npos; pos = text.find(part, pos + 1)) {
+      ++res;
+    }
+    return res;
+  }
+
+  constexpr char const* source = R"(
+    let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) };
+    let size = fn(a) { len(a) };
+  )";
+}
+
+TEST(tracer, TestEvents) {
+  Evaluator evaluator;
+  evaluator.eval(source);
+  ASSERT_TRUE(tracer::start());
+  EXPECT_FALSE(tracer::start());
+  evaluator.eval("fib(4); size([1, 2])");
+  // calls on another thread go to its own buffer
+  std::thread([] {
+    Evaluator other;
+    other.eval(source);
+    other.eval("size([])");
+  }).join();
+  tracer::stop();
+  evaluator.eval("fib(4)");
+
+  EXPECT_EQ(tracer::summary().events, 9u + 2u + 2u);
+  std::ostringstream os;
+  tracer::write_chrome_json(os);
+  auto json = os.str();
+  EXPECT_EQ(json.rfind("{\"traceEvents\": [", 0), 0u);
+  EXPECT_EQ(count(json, "\"name\": \"fib\", \"cat\": \"function\", \"ph\": \"X\""), 9u);
+  EXPECT_EQ(count(json, "\"name\": \"len\", \"cat\": \"builtin\""), 2u);
+  EXPECT_EQ(count(json, "\"tid\": "), 13u);
+  tracer::reset();
+  EXPECT_EQ(tracer::summary().events, 0u);
+}
+
+TEST(tracer, TestFilterAndRing) {
+  Evaluator evaluator;
+  evaluator.eval(source);
+  ASSERT_TRUE(tracer::start({"size", "len"}, 3));
+  evaluator.eval("fib(4); size([1]); size([2])");
+  tracer::stop();
+
+  auto summary = tracer::summary();
+  EXPECT_EQ(summary.events, 3u);
+  EXPECT_EQ(summary.overwritten, 1u);
+  std::ostringstream os;
+  tracer::write_chrome_json(os);
+  EXPECT_EQ(count(os.str(), "fib"), 0u);
+  // the oldest event, the first len, was overwritten
+  EXPECT_EQ(count(os.str(), "\"len\""), 1u);
+  EXPECT_EQ(count(os.str(), "\"size\""), 2u);
+  tracer::reset();
+}
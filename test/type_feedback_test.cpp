@@ -0,0 +1,205 @@
+#include <void/evaluator.hpp>
+#include <void/parser.hpp>
+#include <void/type_feedback.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace Void;
+
+namespace {
+  constexpr char const* source = R"(
+    let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) };
+    fib(10);
+  )";
+
+  std::shared_ptr<Program> parse(std::string const& text) {
+    Parser parser(text);
+    std::shared_ptr<Program> program = parser.parse();
+    program->set_source(text);
+    return program;
+  }
+}
+
+TEST(type_feedback, TestRecord) {
+  type_feedback::Profile profile;
+  Evaluator evaluator;
+  evaluator.set_profile(&profile);
+  EXPECT_EQ(evaluator.eval(source)->inspect(), "55");
+  EXPECT_EQ(profile.programs(), 1u);
+
+  std::ostringstream os;
+  profile.write(os);
+  auto text = os.str();
+  EXPECT_EQ(text.rfind("void-feedback 1\nprogram ", 0), 0u);
+  // 177 calls, 89 of them with n < 2
+  EXPECT_NE(text.find("if 89 88\n"), std::string::npos);
+  EXPECT_NE(text.find("call 88 0 fib\n"), std::string::npos);
+  EXPECT_NE(text.find("call 1 0 fib\n"), std::string::npos);
+  // integer operands only, then specialized and no longer recorded
+  EXPECT_NE(text.find("infix 8 1 1\n"), std::string::npos);
+}
+
+TEST(type_feedback, TestReuse) {
+  type_feedback::Profile first;
+  {
+    Evaluator evaluator;
+    evaluator.set_profile(&first);
+    evaluator.eval(source);
+  }
+  std::stringstream file;
+  first.write(file);
+
+  type_feedback::Profile profile;
+  ASSERT_TRUE(profile.read(file));
+  auto other = parse("fib(3)");
+  EXPECT_FALSE(profile.attach(other));
+  auto program = parse(source);
+  ASSERT_TRUE(profile.attach(program));
+  auto sites = type_feedback::sites(*program);
+  ASSERT_EQ(sites.size(), 8u);
+  ASSERT_EQ(sites[0]->kind(), NodeKind::if_expression);
+  EXPECT_EQ(static_cast<IfExpression*>(sites[0])->feedback().taken, 89u);
+  ASSERT_EQ(sites[1]->kind(), NodeKind::infix_expression);
+  EXPECT_EQ(static_cast<InfixExpression*>(sites[1])->feedback().count, type_feedback::warm_up);
+  ASSERT_EQ(sites[7]->kind(), NodeKind::call_expression);
+  EXPECT_EQ(static_cast<CallExpression*>(sites[7])->feedback().name, "fib");
+
+  std::istringstream bad("void-feedback 1\nprogram 12 1\nloop 1\n");
+  EXPECT_FALSE(profile.read(bad));
+  // what was read is dropped, the attached programs stay
+  EXPECT_EQ(profile.programs(), 2u);
+}
+
+TEST(type_feedback, TestRelease) {
+  type_feedback::Profile profile;
+  auto nodes = AstNode::stats().nodes;
+  {
+    Evaluator evaluator;
+    evaluator.set_profile(&profile);
+    evaluator.eval(source);
+  }
+  // the program is not kept, its feedback is
+  EXPECT_EQ(AstNode::stats().nodes, nodes);
+  EXPECT_EQ(profile.programs(), 1u);
+  std::ostringstream os;
+  profile.write(os);
+  EXPECT_NE(os.str().find("if 89 88\n"), std::string::npos);
+}
+
+TEST(type_feedback, TestSpecialization) {
+  Evaluator evaluator;
+  // warm the site up on integers, then break its guard
+  evaluator.eval(R"(
+    let add = fn(a, b) { a + b };
+    let run = fn(n) { if (n == 0) { 0 } else { add(n, 1); run(n - 1) } };
+    run(20);
+    let pick = fn(f) { f(1) };
+    pick(fn(x) { x }); pick(fn(x) { x * 2 });
+  )");
+  EXPECT_EQ(evaluator.eval("add(2, 3)")->inspect(), "5");
+  EXPECT_EQ(evaluator.eval("add(\"a\", \"b\")")->inspect(), "ab");
+  EXPECT_EQ(evaluator.eval("add(9223372036854775807, 1)")->inspect(), "9223372036854775808");
+  EXPECT_EQ(evaluator.eval("add(2, 3)")->inspect(), "5");
+  EXPECT_EQ(evaluator.eval("pick(fn(x) { x + 1 })")->inspect(), "2");
+}
+
+TEST(type_feedback, TestSlots) {
+  Evaluator evaluator;
+  evaluator.eval(R"(
+    let x = 1;
+    let f = fn(shadow) { if (shadow) { let x = 2; } x };
+    let repeat = fn(n) { if (n == 0) { 0 } else { f(false); repeat(n - 1) } };
+    repeat(20);
+  )");
+  EXPECT_EQ(evaluator.eval("f(false)")->inspect(), "1");
+  // a nearer scope binds the name, the cached global must not be read
+  EXPECT_EQ(evaluator.eval("f(true)")->inspect(), "2");
+  EXPECT_EQ(evaluator.eval("let x = 5; f(false)")->inspect(), "5");
+  // closures over different scopes read through the same node
+  evaluator.eval("let adder = fn(y) { fn(z) { y + z } }; let add1 = adder(1); let add2 = adder(2);");
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(evaluator.eval("add1(10)")->inspect(), "11");
+    EXPECT_EQ(evaluator.eval("add2(10)")->inspect(), "12");
+  }
+  // a name bound to null still finds the builtin
+  EXPECT_EQ(evaluator.eval("let g = fn() { len(\"ab\") }; g(); g(); let len = if (false) { 1 }; g()")->inspect(), "2");
+}
+
+TEST(type_feedback, TestIfGuard) {
+  Evaluator evaluator;
+  evaluator.eval(R"(
+    let g = fn(c) { if (c) { 1 } else { 2 } };
+    let repeat = fn(n) { if (n == 0) { 0 } else { g(n == 1); repeat(n - 1) } };
+    repeat(20);
+  )");
+  EXPECT_EQ(evaluator.eval("g(true)")->inspect(), "1");
+  EXPECT_EQ(evaluator.eval("g(false)")->inspect(), "2");
+  EXPECT_EQ(evaluator.eval("g(0)")->inspect(), "1");
+  EXPECT_EQ(evaluator.eval("g(if (false) { 1 })")->inspect(), "2");
+  EXPECT_EQ(evaluator.eval("g(false)")->inspect(), "2");
+}
+
+TEST(type_feedback, TestPolymorphicCalls) {
+  Evaluator evaluator;
+  evaluator.eval(R"(
+    let call = fn(f, x) { f(x) };
+    let a = fn(x) { x + 1 }; let b = fn(x) { x + 2 }; let c = fn(x) { x + 3 };
+    let d = fn(x) { x + 4 }; let e = fn(x) { x + 5 };
+  )");
+  // a site that calls five functions and a builtin
+  EXPECT_EQ(evaluator.eval("call(a, 1) + call(b, 1) + call(c, 1) + call(d, 1) + call(e, 1)")->inspect(), "20");
+  EXPECT_EQ(evaluator.eval("call(len, \"abc\") + call(e, 1) + call(a, 1)")->inspect(), "11");
+  // a target seen before is still checked for arity
+  EXPECT_EQ(evaluator.eval("let g = fn() { a(1, 2) }; g()")->inspect(), "<error: wrong number of arguments>");
+  EXPECT_EQ(evaluator.eval("let a = fn(x, y) { x * y }; g()")->inspect(), "2");
+}
+
+TEST(type_feedback, TestCallCache) {
+  Evaluator evaluator;
+  evaluator.eval(R"(
+    let f = fn(x) { x + 1 };
+    let run = fn(x) { f(x) };
+    let call = fn(g, x) { g(x) };
+    let size = len;
+    let count = fn(s) { size(s) };
+  )");
+  auto site = [&](std::string const& name) -> CallCache& {
+    auto function = evaluator.lookup_function(name).function()->cast<Function>()->function();
+    auto stmt = static_cast<ExpressionStatement*>(function->body()->statements()[0].get());
+    return static_cast<CallExpression*>(stmt->expression())->cache();
+  };
+
+  auto& cache = site("run");
+  EXPECT_EQ(evaluator.eval("run(1)")->inspect(), "2");
+  EXPECT_EQ(evaluator.eval("run(2)")->inspect(), "3");
+  EXPECT_EQ(cache.size, 1u);
+  EXPECT_EQ(cache.hits, 1u);
+
+  // rebinding the callee misses
+  EXPECT_EQ(evaluator.eval("let f = fn(x) { x * 10 }; run(3)")->inspect(), "30");
+  EXPECT_EQ(cache.misses, 1u);
+  EXPECT_EQ(evaluator.eval("run(4)")->inspect(), "40");
+  EXPECT_EQ(cache.hits, 2u);
+  EXPECT_EQ(cache.size, 2u);
+
+  // a target whose arity does not match is never cached
+  EXPECT_EQ(evaluator.eval("let f = fn(x, y) { x }; run(5)")->inspect(), "<error: wrong number of arguments>");
+  EXPECT_EQ(evaluator.eval("run(5)")->inspect(), "<error: wrong number of arguments>");
+  EXPECT_EQ(cache.size, 2u);
+  EXPECT_EQ(cache.hits, 2u);
+
+  // a builtin reached through a binding
+  EXPECT_EQ(evaluator.eval("count(\"ab\") + count(\"abc\")")->inspect(), "5");
+  EXPECT_EQ(site("count").hits, 1u);
+
+  // a parameter is bound in a new scope every call
+  auto& megamorphic = site("call");
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(evaluator.eval("call(fn(x) { x }, 7)")->inspect(), "7");
+  }
+  EXPECT_TRUE(megamorphic.megamorphic);
+  EXPECT_EQ(megamorphic.size, 0u);
+  EXPECT_EQ(megamorphic.hits, 0u);
+}
@@ -0,0 +1,81 @@
+#include <void/evaluator.hpp>
+#include <void/parser.hpp>
+#include <void/type_feedback.hpp>
+#include <void/type_inference.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace Void;
+
+namespace {
+  std::shared_ptr<Program> parse(std::string const& text) {
+    Parser parser(text);
+    return parser.parse();
+  }
+}
+
+TEST(type_inference, TestMonomorphic) {
+  auto program = parse(R"(
+    let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) };
+    fib(10);
+  )");
+  auto report = type_inference::infer(*program);
+  // the if, four infix expressions and three calls
+  EXPECT_EQ(report.sites, 8u);
+  EXPECT_EQ(report.proven, 8u);
+  EXPECT_TRUE(report.failures.empty());
+
+  // specialized before the first run
+  for (auto expr : type_feedback::sites(*program)) {
+    if (expr->kind() == NodeKind::infix_expression) {
+      EXPECT_EQ(static_cast<InfixExpression*>(expr)->quick(), Quick::int_int);
+    } else if (expr->kind() == NodeKind::if_expression) {
+      EXPECT_EQ(static_cast<IfExpression*>(expr)->quick(), Quick::bool_cond);
+    }
+  }
+}
+
+TEST(type_inference, TestFailures) {
+  auto program = parse(R"(
+    let add = fn(a, b) { a + b };
+    add(1, 2);
+    add("x", "y");
+    let apply = fn(f, v) { f(v) };
+    apply(fn(x) { x * 2 }, 3);
+    let never = fn(n) { n - 1 };
+    if (len([1])) { 1 }
+  )");
+  auto report = type_inference::infer(*program);
+  ASSERT_EQ(report.failures.size(), 3u);
+  EXPECT_EQ(report.failures[0].line, 2);
+  EXPECT_EQ(report.failures[0].kind, NodeKind::infix_expression);
+  EXPECT_EQ(report.failures[0].reason, "operands of '+' are integer or string and integer or string");
+  // nothing calls it
+  EXPECT_EQ(report.failures[1].line, 7);
+  EXPECT_EQ(report.failures[1].reason, "operands of '-' are unknown and integer");
+  EXPECT_EQ(report.failures[2].kind, NodeKind::if_expression);
+  EXPECT_EQ(report.failures[2].reason, "condition is integer");
+  EXPECT_EQ(report.sites - report.proven, 3u);
+
+  std::ostringstream os;
+  type_inference::write_report(os, report);
+  EXPECT_EQ(os.str().rfind("type inference: ", 0), 0u);
+  EXPECT_NE(os.str().find("  line 8: if_expression: condition is integer\n"), std::string::npos);
+}
+
+TEST(type_inference, TestGuards) {
+  // a line sees neither the calls of later lines nor the bindings of
+  // earlier ones, the guard catches what it did not see
+  type_inference::Report report;
+  Evaluator evaluator;
+  evaluator.set_inference(&report);
+  EXPECT_EQ(evaluator.eval("let add = fn(a, b) { a + b }; add(1, 2)")->inspect(), "3");
+  EXPECT_EQ(evaluator.eval("add(\"a\", \"b\")")->inspect(), "ab");
+  EXPECT_EQ(evaluator.eval("add(9223372036854775807, 1)")->inspect(), "9223372036854775808");
+  EXPECT_EQ(report.sites, 4u);
+  EXPECT_EQ(report.proven, 2u);
+  ASSERT_EQ(report.failures.size(), 2u);
+  EXPECT_EQ(report.failures[0].reason, "callee is any type");
+}